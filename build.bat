@@ -3,7 +3,7 @@ echo Building Console Snake C++ Game...
 echo.
 
 echo Compiling with GCC...
-g++ -std=c++17 -o ConsoleSnakeCpp.exe src/*.cpp -luser32 -lkernel32
+g++ -std=c++17 -o ConsoleSnakeCpp.exe src/*.cpp -luser32 -lkernel32 -lwinmm -lpsapi
 
 if %ERRORLEVEL% EQU 0 (
     echo.
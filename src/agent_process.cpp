@@ -0,0 +1,293 @@
+#include "agent_process.h"
+#include "latency_histogram.h"
+#include <sstream>
+#include <vector>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+namespace {
+    // How long stop() waits for a child to exit after closing its stdin
+    const int EXIT_GRACE_MS = 200;
+}
+
+#ifdef _WIN32
+AgentProcess::AgentProcess() : processHandle(nullptr), inputPipe(nullptr), outputPipe(nullptr) {
+}
+#else
+AgentProcess::AgentProcess() : pid(-1), inputPipe(-1), outputPipe(-1) {
+}
+#endif
+
+AgentProcess::~AgentProcess() {
+    stop();
+}
+
+#ifdef _WIN32
+bool AgentProcess::start(const std::string& commandLine) {
+    stop();
+
+    SECURITY_ATTRIBUTES inherit = { sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE };
+    HANDLE childInput = nullptr;
+    HANDLE childOutput = nullptr;
+    if (!CreatePipe(&childInput, &inputPipe, &inherit, 0) || !CreatePipe(&outputPipe, &childOutput, &inherit, 0)) {
+        stop();
+        return false;
+    }
+    // Our ends stay in this process only
+    SetHandleInformation(inputPipe, HANDLE_FLAG_INHERIT, 0);
+    SetHandleInformation(outputPipe, HANDLE_FLAG_INHERIT, 0);
+
+    STARTUPINFOA startup = {};
+    startup.cb = sizeof(startup);
+    startup.dwFlags = STARTF_USESTDHANDLES;
+    startup.hStdInput = childInput;
+    startup.hStdOutput = childOutput;
+    startup.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+    PROCESS_INFORMATION info = {};
+    std::vector<char> command(commandLine.begin(), commandLine.end());
+    command.push_back('\0');
+    BOOL started = CreateProcessA(nullptr, command.data(), nullptr, nullptr, TRUE, 0, nullptr, nullptr,
+                                  &startup, &info);
+    CloseHandle(childInput);
+    CloseHandle(childOutput);
+    if (!started) {
+        stop();
+        return false;
+    }
+    CloseHandle(info.hThread);
+    processHandle = info.hProcess;
+    pending.clear();
+    return true;
+}
+
+void AgentProcess::stop() {
+    if (inputPipe != nullptr) {
+        CloseHandle(inputPipe);
+        inputPipe = nullptr;
+    }
+    if (processHandle != nullptr) {
+        if (WaitForSingleObject(processHandle, EXIT_GRACE_MS) != WAIT_OBJECT_0) {
+            TerminateProcess(processHandle, 1);
+            WaitForSingleObject(processHandle, INFINITE);
+        }
+        CloseHandle(processHandle);
+        processHandle = nullptr;
+    }
+    if (outputPipe != nullptr) {
+        CloseHandle(outputPipe);
+        outputPipe = nullptr;
+    }
+}
+
+bool AgentProcess::isRunning() const {
+    return processHandle != nullptr;
+}
+
+bool AgentProcess::writeAll(const std::string& data, int64_t deadline) {
+    // Blocking: anonymous pipes have no overlapped mode to time out with
+    (void)deadline;
+    size_t written = 0;
+    while (written < data.size()) {
+        DWORD count = 0;
+        if (!WriteFile(inputPipe, data.data() + written, static_cast<DWORD>(data.size() - written), &count, nullptr)) {
+            return false;
+        }
+        written += count;
+    }
+    return true;
+}
+
+int AgentProcess::readSome(char* buffer, int size, int64_t deadline) {
+    // Anonymous pipes cannot be waited on, so poll for data
+    while (true) {
+        DWORD available = 0;
+        if (!PeekNamedPipe(outputPipe, nullptr, 0, nullptr, &available, nullptr)) {
+            return -1;
+        }
+        if (available > 0) {
+            DWORD count = 0;
+            DWORD wanted = available < static_cast<DWORD>(size) ? available : static_cast<DWORD>(size);
+            if (!ReadFile(outputPipe, buffer, wanted, &count, nullptr) || count == 0) {
+                return -1;
+            }
+            return static_cast<int>(count);
+        }
+        if (LatencyHistogram::now() >= deadline) {
+            return 0;
+        }
+        Sleep(0);
+    }
+}
+#else
+bool AgentProcess::start(const std::string& commandLine) {
+    stop();
+
+    // A child that exits early must not take us down with SIGPIPE on the next write
+    signal(SIGPIPE, SIG_IGN);
+
+    std::vector<std::string> words;
+    std::istringstream stream(commandLine);
+    std::string word;
+    while (stream >> word) {
+        words.push_back(word);
+    }
+    if (words.empty()) {
+        return false;
+    }
+    std::vector<char*> args;
+    for (std::string& arg : words) {
+        args.push_back(&arg[0]);
+    }
+    args.push_back(nullptr);
+
+    int toChild[2];
+    int fromChild[2];
+    if (pipe(toChild) != 0) {
+        return false;
+    }
+    if (pipe(fromChild) != 0) {
+        ::close(toChild[0]);
+        ::close(toChild[1]);
+        return false;
+    }
+    // Our ends must not leak into other agents started later
+    fcntl(toChild[1], F_SETFD, FD_CLOEXEC);
+    fcntl(fromChild[0], F_SETFD, FD_CLOEXEC);
+    // A child that stops reading would otherwise block writes forever
+    fcntl(toChild[1], F_SETFL, O_NONBLOCK);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, toChild[0], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, fromChild[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addclose(&actions, toChild[0]);
+    posix_spawn_file_actions_addclose(&actions, fromChild[1]);
+    int status = posix_spawnp(&pid, args[0], &actions, nullptr, args.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    ::close(toChild[0]);
+    ::close(fromChild[1]);
+    inputPipe = toChild[1];
+    outputPipe = fromChild[0];
+    if (status != 0) {
+        pid = -1;
+        stop();
+        return false;
+    }
+    pending.clear();
+    return true;
+}
+
+void AgentProcess::stop() {
+    if (inputPipe >= 0) {
+        ::close(inputPipe);
+        inputPipe = -1;
+    }
+    if (pid > 0) {
+        int64_t deadline = LatencyHistogram::now() + EXIT_GRACE_MS * 1000;
+        while (waitpid(pid, nullptr, WNOHANG) == 0) {
+            if (LatencyHistogram::now() >= deadline) {
+                kill(pid, SIGKILL);
+                waitpid(pid, nullptr, 0);
+                break;
+            }
+            usleep(1000);
+        }
+        pid = -1;
+    }
+    if (outputPipe >= 0) {
+        ::close(outputPipe);
+        outputPipe = -1;
+    }
+}
+
+bool AgentProcess::isRunning() const {
+    return pid > 0;
+}
+
+bool AgentProcess::writeAll(const std::string& data, int64_t deadline) {
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t count = write(inputPipe, data.data() + written, data.size() - written);
+        if (count > 0) {
+            written += static_cast<size_t>(count);
+            continue;
+        }
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            return false;
+        }
+
+        // Pipe full: wait for the child to catch up
+        int64_t left = deadline - LatencyHistogram::now();
+        if (left <= 0) {
+            return false;
+        }
+        pollfd ready = { inputPipe, POLLOUT, 0 };
+        if (poll(&ready, 1, static_cast<int>((left + 999) / 1000)) < 0 && errno != EINTR) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int AgentProcess::readSome(char* buffer, int size, int64_t deadline) {
+    while (true) {
+        int64_t left = deadline - LatencyHistogram::now();
+        if (left <= 0) {
+            return 0;
+        }
+        pollfd ready = { outputPipe, POLLIN, 0 };
+        int count = poll(&ready, 1, static_cast<int>((left + 999) / 1000));
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0) {
+            return -1;
+        }
+        if (count == 0) {
+            return 0;
+        }
+        ssize_t bytes = read(outputPipe, buffer, static_cast<size_t>(size));
+        if (bytes < 0 && errno == EINTR) {
+            continue;
+        }
+        return bytes > 0 ? static_cast<int>(bytes) : -1;
+    }
+}
+#endif
+
+AgentProcess::ReadResult AgentProcess::readLine(std::string& line, int64_t deadline) {
+    while (true) {
+        size_t end = pending.find('\n');
+        if (end != std::string::npos) {
+            line.assign(pending, 0, end);
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            pending.erase(0, end + 1);
+            return READ_LINE;
+        }
+
+        char buffer[4096];
+        int count = readSome(buffer, sizeof(buffer), deadline);
+        if (count < 0) {
+            return READ_CLOSED;
+        }
+        if (count == 0) {
+            return READ_TIMEOUT;
+        }
+        pending.append(buffer, static_cast<size_t>(count));
+    }
+}
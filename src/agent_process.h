@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/types.h>
+#endif
+
+// A child process driven over its stdin/stdout, one text line per message.
+// Reads take a deadline, so a stuck child costs the caller a timeout, not a hang.
+class AgentProcess {
+public:
+    enum ReadResult {
+        READ_LINE,
+        READ_TIMEOUT,
+        READ_CLOSED // The child exited or closed its stdout
+    };
+
+private:
+#ifdef _WIN32
+    HANDLE processHandle;
+    HANDLE inputPipe;  // Our end of the child's stdin
+    HANDLE outputPipe; // Our end of the child's stdout
+#else
+    pid_t pid;
+    int inputPipe;
+    int outputPipe;
+#endif
+    std::string pending; // Bytes read past the last full line
+
+    // Up to `size` bytes, waiting at most until `deadline` (LatencyHistogram::now() units)
+    int readSome(char* buffer, int size, int64_t deadline);
+
+public:
+    AgentProcess();
+    ~AgentProcess();
+
+    AgentProcess(const AgentProcess&) = delete;
+    AgentProcess& operator=(const AgentProcess&) = delete;
+
+    // Words split on spaces; the first is looked up on PATH
+    bool start(const std::string& commandLine);
+    void stop(); // Closes stdin, gives the child a moment to exit, then kills it
+    bool isRunning() const;
+
+    // False if the child is gone or still has not taken everything by the deadline
+    bool writeAll(const std::string& data, int64_t deadline);
+    ReadResult readLine(std::string& line, int64_t deadline);
+};
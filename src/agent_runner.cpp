@@ -0,0 +1,147 @@
+#include "agent_runner.h"
+#include "bot.h"
+#include "simulation.h"
+#include "utils.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    const char DIRECTION_LETTERS[4] = { 'U', 'D', 'L', 'R' };
+
+    struct Sighting {
+        Position food;
+        int pendingGrowth;
+    };
+}
+
+bool AgentRunner::isAgent(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--agent") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int AgentRunner::main(int argc, char* argv[]) {
+    std::string botName;
+    BotSettings settings;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+        if (arg == "--agent") {
+            botName = value;
+        } else if (arg == "--think-ms") {
+            settings.timeBudgetMs = std::atoi(value.c_str());
+        } else if (arg == "--threads") {
+            settings.threads = std::atoi(value.c_str());
+        } else if (arg == "--policy") {
+            settings.policyFile = value;
+        } else {
+            Utils::logError("Unknown option " + arg);
+            return 2;
+        }
+    }
+    std::unique_ptr<Bot> bot = Bot::create(botName, settings);
+    if (!bot) {
+        Utils::logError(botName == "mlp" ? "Could not load policy " + settings.policyFile : "Unknown bot " + botName);
+        return 2;
+    }
+
+    // Moves go out in one line per frame, so stdout is flushed by hand
+    std::ios::sync_with_stdio(false);
+    std::string line;
+    std::string magic;
+    int version = 0;
+    int width = 0;
+    int height = 0;
+    std::string modeKey;
+    std::string levelFile;
+    if (!std::getline(std::cin, line)) {
+        return 1;
+    }
+    std::istringstream hello(line);
+    GameMode mode = MODE_CLASSIC;
+    if (!(hello >> magic >> version >> width >> height >> modeKey >> levelFile) || magic != "snake" || version != 1 ||
+        width <= 0 || height <= 0 || !Simulation::findMode(modeKey, mode)) {
+        Utils::logError("Unexpected greeting: " + line);
+        return 1;
+    }
+
+    if (!bot->fitsBoard(width, height)) {
+        Utils::logError("Policy " + settings.policyFile + " was not trained for a " + std::to_string(width) + "x" +
+                        std::to_string(height) + " board");
+        return 1;
+    }
+
+    Simulation sim(width, height);
+    sim.setMode(mode);
+    if (levelFile != "-" && !sim.loadLevel(levelFile)) {
+        Utils::logError("Could not load level " + levelFile);
+        return 1;
+    }
+    sim.reset();
+    std::cout << bot->getName() << "\n" << std::flush;
+
+    // Frames do not say whether a snake is still growing. Every game moves
+    // one tick per frame, so a pellet that moved was just eaten, and the
+    // tail then stays put for as many ticks as the rules grow per pellet.
+    std::unordered_map<long long, Sighting> sightings;
+    std::vector<Position> body;
+    std::string reply;
+    while (std::getline(std::cin, line)) {
+        std::istringstream header(line);
+        std::string word;
+        unsigned long long sequence = 0;
+        int count = 0;
+        if (!(header >> word >> sequence >> count) || word != "frame") {
+            Utils::logError("Unexpected message: " + line);
+            return 1;
+        }
+
+        reply = std::to_string(sequence) + " ";
+        for (int i = 0; i < count && std::getline(std::cin, line); i++) {
+            std::istringstream game(line);
+            long long id = 0;
+            char heading = 'R';
+            Position food;
+            int length = 0;
+            game >> id >> heading >> food.x >> food.y >> length;
+            body.resize(static_cast<size_t>(length > 0 ? length : 0));
+            for (Position& segment : body) {
+                game >> segment.x >> segment.y;
+            }
+
+            Direction direction = RIGHT;
+            for (int d = 0; d < 4; d++) {
+                if (DIRECTION_LETTERS[d] == heading) {
+                    direction = static_cast<Direction>(d);
+                }
+            }
+            if (!game || body.empty()) {
+                reply += DIRECTION_LETTERS[direction];
+                continue;
+            }
+            int pendingGrowth = 0;
+            auto seen = sightings.find(id);
+            if (seen != sightings.end()) {
+                pendingGrowth = std::max(0, seen->second.pendingGrowth - 1);
+                if (!(seen->second.food == food)) {
+                    pendingGrowth += sim.getGrowthSegments();
+                }
+            }
+            sightings[id] = Sighting{ food, pendingGrowth };
+            sim.restore(body, direction, food, pendingGrowth);
+            reply += DIRECTION_LETTERS[bot->chooseDirection(sim)];
+        }
+        std::cout << reply << "\n" << std::flush;
+    }
+    return 0;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+// Plays tournament games with one of the built-in bots, speaking the agent
+// protocol (see tournament.h) on stdin/stdout:
+//   ConsoleSnakeCpp --agent astar [--think-ms MS] [--threads N] [--policy FILE]
+// Each observed board is restored into a Simulation, so the bots run as they
+// do in the game.
+class AgentRunner {
+public:
+    static bool isAgent(int argc, char* argv[]);
+    static int main(int argc, char* argv[]);
+};
@@ -0,0 +1,12 @@
+#pragma once
+#include <cstdint>
+
+// Counts heap allocations made through operator new anywhere in the
+// program (all threads). allocation_counter.cpp replaces the global
+// operator new, so it only counts in executables that link it. Take a
+// reading before and after a stretch of code; the difference is how many
+// allocations it made.
+class AllocationCounter {
+public:
+    static uint64_t getCount();
+};
@@ -0,0 +1,385 @@
+#include "ansi_encoder.h"
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+    // Longest run of unchanged cells worth rewriting instead of a CUF
+    const int MAX_WRITE_THROUGH = 6;
+
+    // Output reserved per screen cell; a full repaint of the game screen
+    // takes well under this, since blank cells are mostly skipped
+    const size_t RESERVED_BYTES_PER_CELL = 4;
+
+    int foregroundCode(int color) {
+        // Console attributes are BGR with an intensity bit; ANSI colors are RGB
+        int fg = color & 0x0F;
+        int ansi = ((fg & 4) ? 1 : 0) | (fg & 2) | ((fg & 1) ? 4 : 0);
+        return (fg & 8) ? 90 + ansi : 30 + ansi;
+    }
+
+    int backgroundCode(int color) {
+        int bg = (color >> 4) & 0x0F;
+        int ansi = ((bg & 4) ? 1 : 0) | (bg & 2) | ((bg & 1) ? 4 : 0);
+        return (bg & 8) ? 100 + ansi : 40 + ansi;
+    }
+
+    int digitCount(int value) {
+        int digits = 1;
+        while (value >= 10) {
+            value /= 10;
+            digits++;
+        }
+        return digits;
+    }
+
+    // Bytes for ESC [ n X, where n is left out when it is 1
+    int relativeCost(int distance) {
+        if (distance == 0) {
+            return 0;
+        }
+        return distance == 1 ? 3 : 3 + digitCount(distance);
+    }
+
+    // Bytes for ESC [ row ; col H with the shortest allowed form
+    int absoluteCost(int x, int y) {
+        if (x == 0) {
+            return y == 0 ? 3 : 3 + digitCount(y + 1);
+        }
+        return 4 + digitCount(y + 1) + digitCount(x + 1);
+    }
+}
+
+AnsiEncoder::AnsiEncoder()
+    : width(0), height(0), cursorX(-1), cursorY(-1), currentColor(-1), glyphs(nullptr) {
+}
+
+void AnsiEncoder::resize(int newWidth, int newHeight) {
+    commit();
+    width = std::max(0, newWidth);
+    height = std::max(0, newHeight);
+    ScreenCell unknown = { ' ', -1 };
+    screen.assign(static_cast<size_t>(width) * height, unknown);
+
+    // Room for a full repaint up front, so the first frame larger than any
+    // before it does not grow the queue or the buffer in the middle of play
+    pending.reserve(screen.size());
+    buffer.reserve(screen.size() * RESERVED_BYTES_PER_CELL);
+    cursorX = -1;
+    cursorY = -1;
+}
+
+void AnsiEncoder::invalidate() {
+    cursorX = -1;
+    cursorY = -1;
+    currentColor = -1;
+}
+
+void AnsiEncoder::put(int x, int y, char ch, int color) {
+    AnsiCell cell = { x, y, ch, color };
+    pending.push_back(cell);
+}
+
+void AnsiEncoder::putString(int x, int y, const char* text, int color) {
+    for (int i = 0; text[i] != '\0'; ++i) {
+        put(x + i, y, text[i], color);
+    }
+}
+
+void AnsiEncoder::setGlyphTable(const GlyphTable* table) {
+    // Glyph cells and styles on screen may stand for other bytes now
+    commit();
+    glyphs = table;
+    resize(width, height);
+    invalidate();
+}
+
+void AnsiEncoder::putGlyph(int x, int y, int glyph, char ch, int color) {
+    put(x, y, ch, glyphs && !glyphs->isPlain() ? ANSI_GLYPH + glyph : color);
+}
+
+void AnsiEncoder::setCursor(int x, int y) {
+    commit();
+    moveCursor(x, y);
+}
+
+void AnsiEncoder::setColor(int color) {
+    commit();
+    applyColor(color);
+}
+
+void AnsiEncoder::resetColor() {
+    commit();
+    buffer += "\033[0m";
+    currentColor = -1;
+}
+
+void AnsiEncoder::clearScreen() {
+    commit();
+    buffer += "\033[2J\033[H";
+    cursorX = 0;
+    cursorY = 0;
+
+    // Cleared cells take the current background
+    ScreenCell blank = { ' ', currentColor };
+    std::fill(screen.begin(), screen.end(), blank);
+}
+
+void AnsiEncoder::appendRaw(const std::string& sequence) {
+    commit();
+    buffer += sequence;
+}
+
+void AnsiEncoder::commit() {
+    if (pending.empty()) {
+        return;
+    }
+
+    // Screen order keeps the cursor jumps short; stable so the last write to a cell wins.
+    // Insertion sort: cells are queued mostly in screen order already, so this is
+    // close to linear, and unlike std::stable_sort it needs no scratch buffer.
+    for (size_t i = 1; i < pending.size(); ++i) {
+        AnsiCell cell = pending[i];
+        size_t j = i;
+        while (j > 0 && (pending[j - 1].y > cell.y || (pending[j - 1].y == cell.y && pending[j - 1].x > cell.x))) {
+            pending[j] = pending[j - 1];
+            j--;
+        }
+        pending[j] = cell;
+    }
+    for (size_t i = 0; i < pending.size(); ++i) {
+        const AnsiCell& cell = pending[i];
+        if (i + 1 < pending.size() && pending[i + 1].x == cell.x && pending[i + 1].y == cell.y) {
+            continue;
+        }
+        writeCell(cell.x, cell.y, cell.ch, cell.color);
+    }
+    pending.clear();
+}
+
+bool AnsiEncoder::isKnown(int x, int y) const {
+    return x >= 0 && y >= 0 && x < width && y < height &&
+           screen[static_cast<size_t>(y) * width + x].color >= 0;
+}
+
+bool AnsiEncoder::sameGlyph(const ScreenCell& cell, char ch, int color) const {
+    if (cell.color < 0 || cell.ch != ch) {
+        return false;
+    }
+    // A space only shows its background (console colors only)
+    return cell.color == color ||
+           (ch == ' ' && cell.color < STYLE_BASE && color < STYLE_BASE && ((cell.color ^ color) & 0xF0) == 0);
+}
+
+int AnsiEncoder::rewriteCost(const ScreenCell& cell) const {
+    // Bytes to write a known cell again as it is, or -1 if that needs a color change
+    if (cell.color >= ANSI_GLYPH) {
+        int glyph = cell.color - ANSI_GLYPH;
+        if (STYLE_BASE + glyphs->getStyle(glyph) != currentColor) {
+            return -1;
+        }
+        return static_cast<int>(glyphs->getTextLength(glyph));
+    }
+    return sameGlyph(cell, cell.ch, currentColor) ? 1 : -1;
+}
+
+void AnsiEncoder::rewrite(const ScreenCell& cell) {
+    if (cell.color >= ANSI_GLYPH) {
+        int glyph = cell.color - ANSI_GLYPH;
+        buffer.append(glyphs->getText(glyph), glyphs->getTextLength(glyph));
+    } else {
+        buffer += cell.ch;
+    }
+}
+
+int AnsiEncoder::writeThroughCost(int fromX, int toX, int y) const {
+    int gap = toX - fromX;
+    if (gap <= 0 || gap > MAX_WRITE_THROUGH || currentColor < 0) {
+        return INT_MAX;
+    }
+    int cost = 0;
+    for (int x = fromX; x < toX; ++x) {
+        if (!isKnown(x, y)) {
+            return INT_MAX;
+        }
+        int bytes = rewriteCost(screen[static_cast<size_t>(y) * width + x]);
+        if (bytes < 0) {
+            return INT_MAX;
+        }
+        cost += bytes;
+    }
+    return cost;
+}
+
+void AnsiEncoder::moveCursor(int x, int y) {
+    if (x == cursorX && y == cursorY) {
+        return;
+    }
+
+    enum { MOVE_ABSOLUTE, MOVE_RELATIVE, MOVE_RETURN } method = MOVE_ABSOLUTE;
+    int best = absoluteCost(x, y);
+    int horizontal = 0;
+    bool writeThrough = false;
+
+    if (cursorX >= 0 && cursorY >= 0) {
+        int vertical = relativeCost(std::abs(y - cursorY));
+
+        // Move along the row from the current column
+        int dx = x - cursorX;
+        int step = relativeCost(std::abs(dx));
+        int through = dx > 0 ? writeThroughCost(cursorX, x, y) : INT_MAX;
+        int cost = vertical + std::min(step, through);
+        if (cost < best) {
+            best = cost;
+            method = MOVE_RELATIVE;
+            writeThrough = through < step;
+        }
+
+        // Carriage return, then along the row from column 0
+        if (x > 0) {
+            step = relativeCost(x);
+            through = writeThroughCost(0, x, y);
+        } else {
+            step = 0;
+            through = INT_MAX;
+        }
+        cost = vertical + 1 + std::min(step, through);
+        if (cost < best) {
+            best = cost;
+            method = MOVE_RETURN;
+            writeThrough = through < step;
+        }
+        horizontal = method == MOVE_RETURN ? 0 : cursorX;
+    }
+
+    if (method == MOVE_ABSOLUTE) {
+        buffer += "\033[";
+        if (x == 0) {
+            if (y != 0) {
+                appendNumber(y + 1);
+            }
+        } else {
+            appendNumber(y + 1);
+            buffer += ';';
+            appendNumber(x + 1);
+        }
+        buffer += 'H';
+    } else {
+        if (y < cursorY) {
+            appendSequence(cursorY - y, 'A');
+        } else if (y > cursorY) {
+            appendSequence(y - cursorY, 'B');
+        }
+        if (method == MOVE_RETURN) {
+            buffer += '\r';
+        }
+        if (writeThrough) {
+            for (int column = horizontal; column < x; ++column) {
+                rewrite(screen[static_cast<size_t>(y) * width + column]);
+            }
+        } else if (x > horizontal) {
+            appendSequence(x - horizontal, 'C');
+        } else if (x < horizontal) {
+            appendSequence(horizontal - x, 'D');
+        }
+    }
+    cursorX = x;
+    cursorY = y;
+}
+
+void AnsiEncoder::applyColor(int color) {
+    if (color == currentColor) {
+        return;
+    }
+
+    // After a theme style nothing about the terminal's colors can be assumed
+    bool unknown = currentColor < 0 || currentColor >= STYLE_BASE;
+    bool foreground = unknown || ((currentColor ^ color) & 0x0F) != 0;
+    bool background = unknown || ((currentColor ^ color) & 0xF0) != 0;
+    buffer += "\033[";
+    if (foreground) {
+        appendNumber(foregroundCode(color));
+    }
+    if (background) {
+        if (foreground) {
+            buffer += ';';
+        }
+        appendNumber(backgroundCode(color));
+    }
+    buffer += 'm';
+    currentColor = color;
+}
+
+void AnsiEncoder::writeCell(int x, int y, char ch, int color) {
+    bool tracked = width > 0 && height > 0;
+    if (tracked) {
+        if (x < 0 || y < 0 || x >= width || y >= height) {
+            return;
+        }
+        if (sameGlyph(screen[static_cast<size_t>(y) * width + x], ch, color)) {
+            return;
+        }
+    }
+
+    moveCursor(x, y);
+    if (color >= ANSI_GLYPH) {
+        // One copy of the pre-encoded bytes, leaving out the style when it is already set
+        int glyph = color - ANSI_GLYPH;
+        int style = STYLE_BASE + glyphs->getStyle(glyph);
+        if (style == currentColor) {
+            buffer.append(glyphs->getText(glyph), glyphs->getTextLength(glyph));
+        } else {
+            buffer.append(glyphs->getSequence(glyph), glyphs->getSequenceLength(glyph));
+            currentColor = style;
+        }
+    } else {
+        if (!(ch == ' ' && currentColor >= 0 && currentColor < STYLE_BASE && ((currentColor ^ color) & 0xF0) == 0)) {
+            applyColor(color);
+        }
+        buffer += ch;
+    }
+
+    if (tracked) {
+        ScreenCell& cell = screen[static_cast<size_t>(y) * width + x];
+        cell.ch = ch;
+        cell.color = color >= ANSI_GLYPH ? color : currentColor;
+    }
+
+    // Writing the last column leaves the cursor in a terminal-specific state
+    cursorX = x + 1;
+    if (tracked && cursorX >= width) {
+        cursorX = -1;
+        cursorY = -1;
+    }
+}
+
+void AnsiEncoder::appendNumber(int value) {
+    char digits[12];
+    int count = 0;
+    do {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    while (count > 0) {
+        buffer += digits[--count];
+    }
+}
+
+void AnsiEncoder::appendSequence(int value, char command) {
+    buffer += "\033[";
+    if (value != 1) {
+        appendNumber(value);
+    }
+    buffer += command;
+}
+
+void AnsiEncoder::encodeNaive(const std::vector<AnsiCell>& cells, std::string& out) {
+    // Naive in bytes only: formatted in place so measuring it does not allocate
+    char sequence[48];
+    for (const AnsiCell& cell : cells) {
+        int length = std::snprintf(sequence, sizeof(sequence), "\033[%d;%dH\033[0;%d;%dm%c", cell.y + 1, cell.x + 1,
+                                   foregroundCode(cell.color), backgroundCode(cell.color), cell.ch);
+        out.append(sequence, static_cast<size_t>(length));
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include "glyph_table.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// One character cell to draw, in screen coordinates (0-based)
+struct AnsiCell {
+    int x;
+    int y;
+    char ch;
+    int color; // Console color attribute (foreground | background << 4), or ANSI_GLYPH + a Glyph
+};
+
+// Cell colors at and above this stand for a glyph of the encoder's GlyphTable
+const int ANSI_GLYPH = 0x10000;
+
+// Turns cell updates into as few ANSI escape bytes as possible.
+//
+// Cells are queued and encoded on commit() in screen order. The encoder keeps
+// a shadow copy of what the terminal shows plus the cursor position and the
+// active colors, so for each jump it picks the shortest of an absolute move
+// (CUP), relative moves (CUU/CUD/CUF/CUB, carriage return) or simply writing
+// the unchanged cells in between again. Colors are only sent when they change
+// and cells that already show the right glyph are skipped. All output goes
+// into one buffer that is reused between frames.
+//
+// Glyph cells are copied from the GlyphTable's pre-encoded spans; theme
+// styles take the place of console colors while one is active.
+class AnsiEncoder {
+private:
+    struct ScreenCell {
+        char ch;
+        int color; // -1 when unknown; ANSI_GLYPH + glyph for glyph cells
+    };
+
+    // currentColor values from here up are GlyphTable styles
+    static const int STYLE_BASE = 0x100;
+
+    std::string buffer;
+    std::vector<AnsiCell> pending;
+    std::vector<ScreenCell> screen;
+    int width;
+    int height;
+    int cursorX; // -1 when unknown
+    int cursorY;
+    int currentColor; // -1 when unknown
+    const GlyphTable* glyphs;
+
+    bool isKnown(int x, int y) const;
+    bool sameGlyph(const ScreenCell& cell, char ch, int color) const;
+    int rewriteCost(const ScreenCell& cell) const;
+    void rewrite(const ScreenCell& cell);
+    int writeThroughCost(int fromX, int toX, int y) const;
+    void moveCursor(int x, int y);
+    void applyColor(int color);
+    void writeCell(int x, int y, char ch, int color);
+    void appendNumber(int value);
+    void appendSequence(int value, char command);
+
+public:
+    AnsiEncoder();
+
+    // Screen size; resets the shadow screen to unknown
+    void resize(int newWidth, int newHeight);
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+    // Forget the cursor and colors (after output the encoder did not produce)
+    void invalidate();
+
+    // Queue cells; later cells at the same position win
+    void put(int x, int y, char ch, int color);
+    void putString(int x, int y, const char* text, int color);
+
+    // Glyph cells, drawn as ch and color when there is no table or it is a
+    // plain one (the table must outlive the encoder's use of it)
+    void setGlyphTable(const GlyphTable* table);
+    void putGlyph(int x, int y, int glyph, char ch, int color);
+
+    // Immediate operations (pending cells are committed first)
+    void setCursor(int x, int y);
+    void setColor(int color);
+    void resetColor();
+    void clearScreen();
+    void appendRaw(const std::string& sequence);
+
+    // Encode all pending cells into the buffer
+    void commit();
+
+    // Output buffer; clearBuffer() keeps its capacity for the next frame
+    const std::string& getBuffer() const { return buffer; }
+    void clearBuffer() { buffer.clear(); }
+
+    int getColor() const { return currentColor; }
+    int getCursorX() const { return cursorX; }
+    int getCursorY() const { return cursorY; }
+
+    // Reference encoding: absolute move and full color for every cell
+    static void encodeNaive(const std::vector<AnsiCell>& cells, std::string& out);
+};
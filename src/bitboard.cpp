@@ -0,0 +1,78 @@
+#include "bitboard.h"
+#include <algorithm>
+
+Bitboard::Bitboard(int width, int height) : width(0), height(0), wordsPerRow(0) {
+    resize(width, height);
+}
+
+void Bitboard::resize(int newWidth, int newHeight) {
+    width = std::max(newWidth, 0);
+    height = std::max(newHeight, 0);
+    wordsPerRow = (width + 63) / 64;
+    words.assign(static_cast<size_t>(wordsPerRow) * height, 0);
+}
+
+void Bitboard::clear() {
+    std::fill(words.begin(), words.end(), 0);
+}
+
+Bitboard& Bitboard::operator|=(const Bitboard& other) {
+    size_t count = std::min(words.size(), other.words.size());
+    for (size_t i = 0; i < count; ++i) {
+        words[i] |= other.words[i];
+    }
+    return *this;
+}
+
+int Bitboard::count() const {
+    int total = 0;
+    for (uint64_t word : words) {
+        total += popCount(word);
+    }
+    return total;
+}
+
+bool Bitboard::isEmpty() const {
+    for (uint64_t word : words) {
+        if (word != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int Bitboard::popCount(uint64_t value) {
+    // SWAR count, constant time however full the word is
+    value = value - ((value >> 1) & 0x5555555555555555ull);
+    value = (value & 0x3333333333333333ull) + ((value >> 2) & 0x3333333333333333ull);
+    value = (value + (value >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    return static_cast<int>((value * 0x0101010101010101ull) >> 56);
+}
+
+int Bitboard::lowestBit(uint64_t value) {
+    return popCount((value & (~value + 1)) - 1);
+}
+
+int Bitboard::getWidth() const {
+    return width;
+}
+
+int Bitboard::getHeight() const {
+    return height;
+}
+
+int Bitboard::getWordsPerRow() const {
+    return wordsPerRow;
+}
+
+uint64_t* Bitboard::data() {
+    return words.data();
+}
+
+const uint64_t* Bitboard::data() const {
+    return words.data();
+}
+
+size_t Bitboard::wordCount() const {
+    return words.size();
+}
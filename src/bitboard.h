@@ -0,0 +1,55 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One bit per board cell, packed row by row into 64-bit words.
+// Coordinates are 0-based; callers translate from play-area positions.
+class Bitboard {
+private:
+    int width;
+    int height;
+    int wordsPerRow;
+    std::vector<uint64_t> words;
+
+public:
+    Bitboard(int width = 0, int height = 0);
+
+    // Setup
+    void resize(int newWidth, int newHeight);
+    void clear();
+
+    // Cell access (no bounds checking - hot path)
+    bool test(int x, int y) const {
+        return (words[static_cast<size_t>(y) * wordsPerRow + (x >> 6)] >> (x & 63)) & 1;
+    }
+    void set(int x, int y) {
+        words[static_cast<size_t>(y) * wordsPerRow + (x >> 6)] |= uint64_t(1) << (x & 63);
+    }
+    void reset(int x, int y) {
+        words[static_cast<size_t>(y) * wordsPerRow + (x >> 6)] &= ~(uint64_t(1) << (x & 63));
+    }
+
+    // Tests the cell in (this | other) without building the union
+    bool testUnion(const Bitboard& other, int x, int y) const {
+        size_t index = static_cast<size_t>(y) * wordsPerRow + (x >> 6);
+        return ((words[index] | other.words[index]) >> (x & 63)) & 1;
+    }
+
+    // Whole-board operations
+    Bitboard& operator|=(const Bitboard& other);
+    int count() const;
+    bool isEmpty() const;
+
+    // Word helpers: set bits in a word, index of the lowest set bit (word != 0)
+    static int popCount(uint64_t value);
+    static int lowestBit(uint64_t value);
+
+    // Raw storage (used for loading/saving compiled levels)
+    int getWidth() const;
+    int getHeight() const;
+    int getWordsPerRow() const;
+    uint64_t* data();
+    const uint64_t* data() const;
+    size_t wordCount() const;
+};
@@ -0,0 +1,275 @@
+#include "bot.h"
+#include "mcts_bot.h"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+
+namespace {
+    const Direction ALL_DIRECTIONS[4] = { UP, DOWN, LEFT, RIGHT };
+}
+
+// Bot implementation
+std::unique_ptr<Bot> Bot::create(const std::string& name, const BotSettings& settings) {
+    if (name == "greedy") {
+        return std::unique_ptr<Bot>(new GreedyBot());
+    }
+    if (name == "astar") {
+        return std::unique_ptr<Bot>(new AStarBot());
+    }
+    if (name == "mcts") {
+        return std::unique_ptr<Bot>(new MctsBot(settings.timeBudgetMs, settings.threads));
+    }
+    if (name == "mlp") {
+        std::unique_ptr<PolicyBot> bot(new PolicyBot());
+        if (!bot->load(settings.policyFile)) {
+            return nullptr;
+        }
+        return std::unique_ptr<Bot>(bot.release());
+    }
+    return nullptr;
+}
+
+bool Bot::fitsBoard(int, int) const {
+    return true;
+}
+
+bool Bot::stepPosition(const Simulation& sim, Position& pos, Direction dir) {
+    switch (dir) {
+        case UP:
+            pos.y--;
+            break;
+        case DOWN:
+            pos.y++;
+            break;
+        case LEFT:
+            pos.x--;
+            break;
+        case RIGHT:
+            pos.x++;
+            break;
+    }
+
+    if (sim.getMode() == MODE_WRAP) {
+        return WallWrap::resolve(pos, sim.getWidth(), sim.getHeight());
+    }
+    return WallDeath::resolve(pos, sim.getWidth(), sim.getHeight());
+}
+
+bool Bot::isFree(const Simulation& sim, const Position& pos) {
+    return !sim.getOccupancy().testUnion(sim.getLevel().getWalls(), pos.x - 1, pos.y - 1);
+}
+
+bool Bot::isReverse(Direction current, Direction dir) {
+    return (current == UP && dir == DOWN) || (current == DOWN && dir == UP) ||
+           (current == LEFT && dir == RIGHT) || (current == RIGHT && dir == LEFT);
+}
+
+Direction Bot::safestDirection(const Simulation& sim) {
+    const Snake& snake = sim.getSnake();
+    Direction best = snake.getDirection();
+    int bestExits = -1;
+
+    // Pick the open neighbour with the most open neighbours of its own
+    for (Direction dir : ALL_DIRECTIONS) {
+        if (isReverse(snake.getDirection(), dir)) {
+            continue;
+        }
+        Position next = snake.getHead();
+        if (!stepPosition(sim, next, dir) || !isFree(sim, next)) {
+            continue;
+        }
+
+        int exits = 0;
+        for (Direction onward : ALL_DIRECTIONS) {
+            Position beyond = next;
+            if (stepPosition(sim, beyond, onward) && isFree(sim, beyond) && beyond != snake.getHead()) {
+                exits++;
+            }
+        }
+        if (exits > bestExits) {
+            bestExits = exits;
+            best = dir;
+        }
+    }
+    return best;
+}
+
+// GreedyBot implementation
+Direction GreedyBot::chooseDirection(const Simulation& sim) {
+    const Snake& snake = sim.getSnake();
+    const Food& food = sim.getFood();
+    if (!food.isActive()) {
+        return safestDirection(sim);
+    }
+
+    Position head = snake.getHead();
+    Position target = food.getPosition();
+    Direction preferred[2];
+    preferred[0] = target.x < head.x ? LEFT : RIGHT;
+    preferred[1] = target.y < head.y ? UP : DOWN;
+    if (std::abs(target.y - head.y) > std::abs(target.x - head.x)) {
+        std::swap(preferred[0], preferred[1]);
+    }
+
+    for (Direction dir : preferred) {
+        Position next = head;
+        if (!isReverse(snake.getDirection(), dir) && stepPosition(sim, next, dir) && isFree(sim, next)) {
+            return dir;
+        }
+    }
+    return safestDirection(sim);
+}
+
+const char* GreedyBot::getName() const {
+    return "greedy";
+}
+
+// AStarBot implementation
+AStarBot::AStarBot() : generation(0) {
+}
+
+int AStarBot::heuristic(const Simulation& sim, const Position& from, const Position& to) const {
+    int dx = std::abs(from.x - to.x);
+    int dy = std::abs(from.y - to.y);
+    if (sim.getMode() == MODE_WRAP) {
+        dx = std::min(dx, sim.getWidth() - dx);
+        dy = std::min(dy, sim.getHeight() - dy);
+    }
+    return dx + dy;
+}
+
+Direction AStarBot::chooseDirection(const Simulation& sim) {
+    const Snake& snake = sim.getSnake();
+    const Food& food = sim.getFood();
+    if (!food.isActive()) {
+        return roomiestDirection(sim);
+    }
+
+    const int width = sim.getWidth();
+    const size_t cells = static_cast<size_t>(width) * sim.getHeight();
+    if (visited.size() != cells) {
+        cost.assign(cells, 0);
+        parent.assign(cells, -1);
+        visited.assign(cells, 0);
+        generation = 0;
+    }
+    if (++generation == 0) {
+        // Stamp wrapped around - start over with a clean slate
+        std::fill(visited.begin(), visited.end(), 0);
+        generation = 1;
+    }
+
+    Position head = snake.getHead();
+    Position goal = food.getPosition();
+    int start = (head.y - 1) * width + (head.x - 1);
+    int target = (goal.y - 1) * width + (goal.x - 1);
+
+    open.clear();
+    cost[start] = 0;
+    parent[start] = -1;
+    visited[start] = generation;
+    open.emplace_back(heuristic(sim, head, goal), start);
+
+    bool found = false;
+    while (!open.empty()) {
+        std::pop_heap(open.begin(), open.end(), std::greater<std::pair<int, int>>());
+        int cell = open.back().second;
+        open.pop_back();
+
+        if (cell == target) {
+            found = true;
+            break;
+        }
+
+        Position pos(cell % width + 1, cell / width + 1);
+        for (Direction dir : ALL_DIRECTIONS) {
+            if (cell == start && isReverse(snake.getDirection(), dir)) {
+                continue;
+            }
+            Position next = pos;
+            if (!stepPosition(sim, next, dir) || !isFree(sim, next)) {
+                continue;
+            }
+
+            int nextCell = (next.y - 1) * width + (next.x - 1);
+            int nextCost = cost[cell] + 1;
+            if (visited[nextCell] == generation && cost[nextCell] <= nextCost) {
+                continue;
+            }
+            visited[nextCell] = generation;
+            cost[nextCell] = nextCost;
+            parent[nextCell] = cell;
+            open.emplace_back(nextCost + heuristic(sim, next, goal), nextCell);
+            std::push_heap(open.begin(), open.end(), std::greater<std::pair<int, int>>());
+        }
+    }
+
+    if (!found) {
+        return roomiestDirection(sim);
+    }
+
+    // Walk back to the cell right after the head
+    int step = target;
+    while (parent[step] != start) {
+        step = parent[step];
+    }
+
+    // Never follow the path into a space the body cannot fit in
+    Position next(step % width + 1, step / width + 1);
+    if (flood.reachable(sim, next) < snake.getLength()) {
+        return roomiestDirection(sim);
+    }
+    for (Direction dir : ALL_DIRECTIONS) {
+        Position candidate = head;
+        if (stepPosition(sim, candidate, dir) && candidate == next) {
+            return dir;
+        }
+    }
+    return safestDirection(sim);
+}
+
+Direction AStarBot::roomiestDirection(const Simulation& sim) {
+    const Snake& snake = sim.getSnake();
+    Direction best = safestDirection(sim);
+    int bestRoom = -1;
+    for (Direction dir : ALL_DIRECTIONS) {
+        if (isReverse(snake.getDirection(), dir)) {
+            continue;
+        }
+        Position next = snake.getHead();
+        if (!stepPosition(sim, next, dir) || !isFree(sim, next)) {
+            continue;
+        }
+        int room = flood.reachable(sim, next);
+        if (room > bestRoom) {
+            bestRoom = room;
+            best = dir;
+        }
+    }
+    return best;
+}
+
+const char* AStarBot::getName() const {
+    return "astar";
+}
+
+// PolicyBot implementation
+bool PolicyBot::load(const std::string& filename) {
+    return policy.load(filename);
+}
+
+bool PolicyBot::fitsBoard(int width, int height) const {
+    return policy.fits(width, height);
+}
+
+Direction PolicyBot::chooseDirection(const Simulation& sim) {
+    Direction action;
+    if (!policy.choose(sim, action)) {
+        return safestDirection(sim);
+    }
+    return action;
+}
+
+const char* PolicyBot::getName() const {
+    return "mlp";
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include "flood_fill.h"
+#include "mlp_policy.h"
+#include "simulation.h"
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Tuning for bots that search under a time budget
+struct BotSettings {
+    int timeBudgetMs;  // Thinking time per move
+    int threads;       // Search threads, 0 = one per hardware thread
+    std::string policyFile; // Weights for the "mlp" bot
+
+    BotSettings() : timeBudgetMs(10), threads(0) {}
+};
+
+// Automatic player: picks the next direction from the current world state
+class Bot {
+public:
+    virtual ~Bot() = default;
+
+    virtual Direction chooseDirection(const Simulation& sim) = 0;
+    virtual const char* getName() const = 0;
+
+    // False if the bot cannot play a board this size; checked once when the
+    // board is known, so a mismatch fails at startup rather than every move
+    virtual bool fitsBoard(int width, int height) const;
+
+    // Creates a bot by name ("greedy", "astar", "mcts", "mlp"); returns nullptr
+    // if unknown or if the mlp policy file cannot be loaded
+    static std::unique_ptr<Bot> create(const std::string& name, const BotSettings& settings = BotSettings());
+
+protected:
+    // Helpers shared by the bots
+    static bool stepPosition(const Simulation& sim, Position& pos, Direction dir);
+    static bool isFree(const Simulation& sim, const Position& pos);
+    static bool isReverse(Direction current, Direction dir);
+    static Direction safestDirection(const Simulation& sim);
+};
+
+// Moves toward the food along whichever axis is open, no look-ahead
+class GreedyBot : public Bot {
+public:
+    Direction chooseDirection(const Simulation& sim) override;
+    const char* getName() const override;
+};
+
+// Shortest path to the food with A*, unless the first step leads into a
+// pocket too small for the snake; then it heads for the most room. Buffers
+// are kept between calls so a decision does not allocate once the board size
+// is known.
+class AStarBot : public Bot {
+private:
+    std::vector<int> cost;           // g-score per cell
+    std::vector<int> parent;         // Cell we came from
+    std::vector<unsigned> visited;   // Generation stamp, avoids clearing per call
+    std::vector<std::pair<int, int>> open; // (f-score, cell) min-heap
+    unsigned generation;
+    FloodFill flood;
+
+    int heuristic(const Simulation& sim, const Position& from, const Position& to) const;
+    Direction roomiestDirection(const Simulation& sim);
+
+public:
+    AStarBot();
+
+    Direction chooseDirection(const Simulation& sim) override;
+    const char* getName() const override;
+};
+
+// Plays a trained MLP policy. Only fits the board size it was trained for;
+// callers check fitsBoard() before the first move.
+class PolicyBot : public Bot {
+private:
+    MlpPolicy policy;
+
+public:
+    bool load(const std::string& filename);
+
+    bool fitsBoard(int width, int height) const override;
+
+    Direction chooseDirection(const Simulation& sim) override;
+    const char* getName() const override;
+};
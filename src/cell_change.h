@@ -0,0 +1,47 @@
+#pragma once
+#include "food_field.h"
+
+// What now occupies a play-area cell
+enum CellKind {
+    CELL_EMPTY,         // Back to the level background (blank or portal)
+    CELL_SNAKE_HEAD,
+    CELL_SNAKE_BODY,
+    CELL_FOOD,          // Main pellet
+    CELL_ITEM_NORMAL,   // Extra items, in FoodKind order
+    CELL_ITEM_BONUS,
+    CELL_ITEM_SHRINK,
+    CELL_ITEM_SPEED
+};
+
+// Neighbours a snake cell is joined to, one bit per Direction. The low four
+// bits point towards the head (on the head itself: where it is heading), the
+// high four towards the tail (none on the tail). Zero where not known.
+enum CellLink {
+    LINK_UP = 1,
+    LINK_DOWN = 2,
+    LINK_LEFT = 4,
+    LINK_RIGHT = 8,
+    LINK_HEADWARD = 0x0F,
+    LINK_TAILWARD = 0xF0
+};
+
+inline uint8_t linkTowards(Direction direction) {
+    return static_cast<uint8_t>(1 << direction);
+}
+
+inline uint8_t linkBack(Direction direction) {
+    // UP/DOWN and LEFT/RIGHT differ only in the lowest bit
+    return static_cast<uint8_t>(1 << ((direction ^ 1) + 4));
+}
+
+// One cell that changed during a tick, in play-area coordinates
+struct CellChange {
+    int x;
+    int y;
+    CellKind kind;
+    uint8_t links; // CellLink bits, snake cells only
+};
+
+inline CellKind cellKindForItem(FoodKind kind) {
+    return static_cast<CellKind>(CELL_ITEM_NORMAL + kind);
+}
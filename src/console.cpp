@@ -1,7 +1,19 @@
 #include "console.h"
+#include "latency_histogram.h"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 
-Console::Console() : hConsole(nullptr), hInput(nullptr), bytesWritten(0), bytesRead(0), numEvents(0) {
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+Console::Console()
+    : hConsole(nullptr), hInput(nullptr), bytesWritten(0), bytesRead(0), numEvents(0),
+      recorder(nullptr), recordDirty(false), keyTime(0), flushTime(0), offscreen(false) {
     cursorPosition.X = 0;
     cursorPosition.Y = 0;
 }
@@ -65,11 +77,18 @@ void Console::clearScreen() {
     DWORD cCharsWritten;
     CONSOLE_SCREEN_BUFFER_INFO csbi;
     
-    GetConsoleScreenBufferInfo(hConsole, &csbi);
-    DWORD dwConSize = csbi.dwSize.X * csbi.dwSize.Y;
+    if (!offscreen) {
+        GetConsoleScreenBufferInfo(hConsole, &csbi);
+        DWORD dwConSize = csbi.dwSize.X * csbi.dwSize.Y;
+        
+        FillConsoleOutputCharacter(hConsole, ' ', dwConSize, coordScreen, &cCharsWritten);
+        SetConsoleCursorPosition(hConsole, coordScreen);
+    }
     
-    FillConsoleOutputCharacter(hConsole, ' ', dwConSize, coordScreen, &cCharsWritten);
-    SetConsoleCursorPosition(hConsole, coordScreen);
+    if (recorder) {
+        std::fill(recordGrid.begin(), recordGrid.end(), FrameCell{ ' ', WHITE });
+        recordDirty = true;
+    }
 }
 
 void Console::setCursorPosition(int x, int y) {
@@ -86,6 +105,11 @@ void Console::getCursorPosition(int& x, int& y) {
 }
 
 void Console::getConsoleSize(int& width, int& height) {
+    if (offscreen) {
+        width = 80;
+        height = 25;
+        return;
+    }
     CONSOLE_SCREEN_BUFFER_INFO csbi;
     GetConsoleScreenBufferInfo(hConsole, &csbi);
     width = csbi.srWindow.Right - csbi.srWindow.Left + 1;
@@ -114,6 +138,10 @@ void Console::setColor(int foreground, int background) {
 }
 
 void Console::drawChar(int x, int y, char ch, int color) {
+    recordCell(x, y, ch, color);
+    if (offscreen) {
+        return;
+    }
     COORD coord;
     coord.X = static_cast<SHORT>(x);
     coord.Y = static_cast<SHORT>(y);
@@ -123,36 +151,27 @@ void Console::drawChar(int x, int y, char ch, int color) {
     WriteConsoleA(hConsole, &ch, 1, &written, nullptr);
 }
 
-void Console::drawString(int x, int y, const std::string& str, int color) {
+void Console::drawGlyph(int x, int y, int glyph, char ch, int color) {
+    // WriteConsoleA takes single-byte characters, so the console keeps the classic look
+    (void)glyph;
+    drawChar(x, y, ch, color);
+}
+
+void Console::drawString(int x, int y, const char* str, int color) {
+    size_t length = std::strlen(str);
+    for (size_t i = 0; i < length; ++i) {
+        recordCell(x + static_cast<int>(i), y, str[i], color);
+    }
+    if (offscreen) {
+        return;
+    }
     COORD coord;
     coord.X = static_cast<SHORT>(x);
     coord.Y = static_cast<SHORT>(y);
     DWORD written;
     SetConsoleCursorPosition(hConsole, coord);
     SetConsoleTextAttribute(hConsole, static_cast<WORD>(color));
-    WriteConsoleA(hConsole, str.c_str(), static_cast<DWORD>(str.length()), &written, nullptr);
-}
-
-void Console::drawBox(int x, int y, int width, int height, char border, int color) {
-    // Draw top border
-    for (int i = 0; i < width; i++) {
-        drawChar(x + i, y, border, color);
-    }
-    
-    // Draw bottom border
-    for (int i = 0; i < width; i++) {
-        drawChar(x + i, y + height - 1, border, color);
-    }
-    
-    // Draw left border
-    for (int i = 1; i < height - 1; i++) {
-        drawChar(x, y + i, border, color);
-    }
-    
-    // Draw right border
-    for (int i = 1; i < height - 1; i++) {
-        drawChar(x + width - 1, y + i, border, color);
-    }
+    WriteConsoleA(hConsole, str, static_cast<DWORD>(length), &written, nullptr);
 }
 
 bool Console::isKeyPressed() {
@@ -166,6 +185,7 @@ int Console::getKeyPressed() {
         FlushConsoleInputBuffer(hInput);
         for (DWORD i = 0; i < events; ++i) {
             if (inputBuffer[i].EventType == KEY_EVENT && inputBuffer[i].Event.KeyEvent.bKeyDown) {
+                keyTime = LatencyHistogram::now();
                 return inputBuffer[i].Event.KeyEvent.wVirtualKeyCode;
             }
         }
@@ -182,6 +202,7 @@ void Console::flushInputBuffer() {
 }
 
 void Console::sleep(int milliseconds) {
+    recordFrame();
     Sleep(milliseconds);
 }
 
@@ -194,4 +215,313 @@ void Console::setConsoleMode() {
 
 void Console::playBeep(int frequency, int duration) {
     Beep(frequency, duration);
-}
\ No newline at end of file
+}
+
+void Console::flush() {
+    // Console API calls are unbuffered on Windows
+    flushTime = LatencyHistogram::now();
+}
+#else
+Console::Console() : rawMode(false), recorder(nullptr), recordDirty(false), keyTime(0), flushTime(0), offscreen(false) {
+    encoder.setGlyphTable(&glyphs);
+}
+
+Console::~Console() {
+    cleanup();
+}
+
+bool Console::initialize() {
+    if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO)) {
+        return false;
+    }
+    
+    // Set terminal mode for input
+    setConsoleMode();
+    
+    // Size the encoder's copy of the screen
+    int width = 0;
+    int height = 0;
+    getConsoleSize(width, height);
+    
+    // Set console title
+    setConsoleTitle("Console Snake C++");
+    
+    // Hide cursor initially
+    hideCursor();
+    flush();
+    
+    return true;
+}
+
+void Console::cleanup() {
+    if (!rawMode) {
+        return;
+    }
+    showCursor();
+    resetColors();
+    clearScreen();
+    flush();
+    tcsetattr(STDIN_FILENO, TCSAFLUSH, &originalTermios);
+    rawMode = false;
+}
+
+void Console::write(const std::string& text) {
+    encoder.appendRaw(text);
+}
+
+void Console::flush() {
+    // One write per frame; the encoder buffer keeps its capacity
+    encoder.commit();
+    const std::string& output = encoder.getBuffer();
+    size_t offset = offscreen ? output.size() : 0;
+    while (offset < output.size()) {
+        ssize_t written = ::write(STDOUT_FILENO, output.data() + offset, output.size() - offset);
+        if (written <= 0) {
+            break;
+        }
+        offset += static_cast<size_t>(written);
+    }
+    encoder.clearBuffer();
+    flushTime = LatencyHistogram::now();
+}
+
+void Console::setConsoleTitle(const std::string& title) {
+    write("\033]0;" + title + "\007");
+}
+
+void Console::hideCursor() {
+    write("\033[?25l");
+}
+
+void Console::showCursor() {
+    write("\033[?25h");
+}
+
+void Console::clearScreen() {
+    encoder.setColor(WHITE);
+    encoder.clearScreen();
+    
+    if (recorder) {
+        std::fill(recordGrid.begin(), recordGrid.end(), FrameCell{ ' ', WHITE });
+        recordDirty = true;
+    }
+}
+
+void Console::setCursorPosition(int x, int y) {
+    encoder.setCursor(x, y);
+}
+
+void Console::getCursorPosition(int& x, int& y) {
+    x = encoder.getCursorX();
+    y = encoder.getCursorY();
+}
+
+void Console::getConsoleSize(int& width, int& height) {
+    struct winsize size;
+    if (!offscreen && ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0) {
+        width = size.ws_col;
+        height = size.ws_row;
+    } else {
+        width = 80;
+        height = 25;
+    }
+    if (width != encoder.getWidth() || height != encoder.getHeight()) {
+        encoder.resize(width, height);
+    }
+}
+
+void Console::setTextColor(int color) {
+    encoder.setColor(color);
+}
+
+void Console::setBackgroundColor(int color) {
+    int current = encoder.getColor() < 0 ? WHITE : encoder.getColor();
+    encoder.setColor((current & 0x0F) | ((color & 0x0F) << 4));
+}
+
+void Console::resetColors() {
+    encoder.resetColor();
+}
+
+void Console::setColor(int foreground, int background) {
+    encoder.setColor(foreground | (background << 4));
+}
+
+void Console::drawChar(int x, int y, char ch, int color) {
+    encoder.put(x, y, ch, color);
+    recordCell(x, y, ch, color);
+}
+
+void Console::drawGlyph(int x, int y, int glyph, char ch, int color) {
+    encoder.putGlyph(x, y, glyph, ch, color);
+    recordCell(x, y, ch, color);
+}
+
+void Console::drawString(int x, int y, const char* str, int color) {
+    encoder.putString(x, y, str, color);
+    for (int i = 0; str[i] != '\0'; ++i) {
+        recordCell(x + i, y, str[i], color);
+    }
+}
+
+int Console::readByte(int timeoutMs) {
+    struct pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+    if (poll(&pfd, 1, timeoutMs) <= 0) {
+        return -1;
+    }
+    unsigned char byte;
+    if (read(STDIN_FILENO, &byte, 1) != 1) {
+        return -1;
+    }
+    return byte;
+}
+
+bool Console::isKeyPressed() {
+    flush();
+    struct pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+    return poll(&pfd, 1, 0) > 0;
+}
+
+int Console::getKeyPressed() {
+    int byte = readByte(0);
+    if (byte < 0) {
+        return 0;
+    }
+    keyTime = LatencyHistogram::now();
+    
+    // Arrow keys arrive as ESC [ A..D
+    if (byte == 0x1B) {
+        if (readByte(10) != '[') {
+            return VK_ESCAPE;
+        }
+        switch (readByte(10)) {
+            case 'A': return VK_UP;
+            case 'B': return VK_DOWN;
+            case 'C': return VK_RIGHT;
+            case 'D': return VK_LEFT;
+        }
+        return 0;
+    }
+    if (byte == '\n' || byte == '\r') {
+        return VK_RETURN;
+    }
+    if (byte == 0x7F) {
+        return VK_BACK;
+    }
+    // Letters report as upper case, like Windows virtual key codes
+    if (byte >= 'a' && byte <= 'z') {
+        return byte - 'a' + 'A';
+    }
+    return byte;
+}
+
+bool Console::isArrowKey(int key) {
+    return key == VK_UP || key == VK_DOWN || key == VK_LEFT || key == VK_RIGHT;
+}
+
+void Console::flushInputBuffer() {
+    tcflush(STDIN_FILENO, TCIFLUSH);
+}
+
+void Console::sleep(int milliseconds) {
+    recordFrame();
+    flush();
+    usleep(static_cast<useconds_t>(milliseconds) * 1000);
+}
+
+void Console::setConsoleMode() {
+    if (tcgetattr(STDIN_FILENO, &originalTermios) != 0) {
+        return;
+    }
+    struct termios raw = originalTermios;
+    raw.c_lflag &= ~(ICANON | ECHO);
+    raw.c_cc[VMIN] = 0;
+    raw.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw);
+    rawMode = true;
+}
+
+void Console::playBeep(int frequency, int duration) {
+    (void)frequency;
+    (void)duration;
+    write("\007");
+}
+#endif
+
+void Console::drawBox(int x, int y, int width, int height, char border, int color) {
+    // Draw top border
+    for (int i = 0; i < width; i++) {
+        drawChar(x + i, y, border, color);
+    }
+    
+    // Draw bottom border
+    for (int i = 0; i < width; i++) {
+        drawChar(x + i, y + height - 1, border, color);
+    }
+    
+    // Draw left border
+    for (int i = 1; i < height - 1; i++) {
+        drawChar(x, y + i, border, color);
+    }
+    
+    // Draw right border
+    for (int i = 1; i < height - 1; i++) {
+        drawChar(x + width - 1, y + i, border, color);
+    }
+}
+
+bool Console::setTheme(const std::string& name) {
+    if (!glyphs.load(name)) {
+        return false;
+    }
+#ifndef _WIN32
+    encoder.setGlyphTable(&glyphs);
+#endif
+    return true;
+}
+
+const GlyphTable& Console::getGlyphs() const {
+    return glyphs;
+}
+
+void Console::setOffscreen(bool enabled) {
+    offscreen = enabled;
+    int width = 0;
+    int height = 0;
+    getConsoleSize(width, height);
+}
+
+void Console::setRecorder(FrameRecorder* frameRecorder) {
+    recorder = frameRecorder;
+    recordGrid.clear();
+    if (recorder) {
+        // Start blank; the game clears the screen before drawing anyway
+        recordGrid.assign(static_cast<size_t>(recorder->getWidth()) * recorder->getHeight(),
+                          FrameCell{ ' ', WHITE });
+        recordDirty = true;
+    }
+}
+
+int64_t Console::getKeyTime() const {
+    return keyTime;
+}
+
+int64_t Console::getFlushTime() const {
+    return flushTime;
+}
+
+void Console::recordCell(int x, int y, char ch, int color) {
+    if (!recorder || x < 0 || y < 0 || x >= recorder->getWidth() || y >= recorder->getHeight()) {
+        return;
+    }
+    recordGrid[static_cast<size_t>(y) * recorder->getWidth() + x] = FrameCell{ ch, static_cast<uint8_t>(color) };
+    recordDirty = true;
+}
+
+void Console::recordFrame() {
+    // Frames end where the game sleeps; nothing is captured while idle
+    if (recorder && recordDirty) {
+        recorder->capture(recordGrid);
+        recordDirty = false;
+    }
+}
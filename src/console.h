@@ -1,9 +1,28 @@
 #pragma once
-#include <windows.h>
+#include "ansi_encoder.h"
+#include "recording.h"
+#include <cstdint>
 #include <string>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <termios.h>
+
+// Virtual key codes returned by getKeyPressed (same values as on Windows)
+#define VK_BACK   0x08
+#define VK_RETURN 0x0D
+#define VK_ESCAPE 0x1B
+#define VK_SPACE  0x20
+#define VK_LEFT   0x25
+#define VK_UP     0x26
+#define VK_RIGHT  0x27
+#define VK_DOWN   0x28
+#endif
+
 class Console {
 private:
+#ifdef _WIN32
     HANDLE hConsole;
     HANDLE hInput;
     CONSOLE_SCREEN_BUFFER_INFO csbi;
@@ -12,6 +31,33 @@ private:
     DWORD bytesRead;
     INPUT_RECORD inputBuffer[128];
     DWORD numEvents;
+#else
+    // ANSI terminal backend
+    struct termios originalTermios;
+    bool rawMode;
+    AnsiEncoder encoder; // Output waiting for flush()
+    
+    void write(const std::string& text);
+    int readByte(int timeoutMs);
+#endif
+    
+    // Board theme; the Windows console always shows the classic look
+    GlyphTable glyphs;
+    
+    // Session recording: copy of everything drawn, handed over once per frame
+    FrameRecorder* recorder;
+    std::vector<FrameCell> recordGrid;
+    bool recordDirty;
+    
+    void recordCell(int x, int y, char ch, int color);
+    void recordFrame();
+    
+    // Latency stamps in LatencyHistogram::now() microseconds
+    int64_t keyTime;   // When the key last returned by getKeyPressed() was read
+    int64_t flushTime; // When the last flush() finished
+    
+    // Drawing still goes through the encoder, but nothing reaches the terminal
+    bool offscreen;
 
 public:
     Console();
@@ -20,6 +66,7 @@ public:
     // Console setup and cleanup
     bool initialize();
     void cleanup();
+    void setOffscreen(bool enabled); // Draw without a terminal, at a fixed 80x25 (--alloc-check)
     void setConsoleTitle(const std::string& title);
     void hideCursor();
     void showCursor();
@@ -38,14 +85,24 @@ public:
     
     // Drawing functions
     void drawChar(int x, int y, char ch, int color = 7);
-    void drawString(int x, int y, const std::string& str, int color = 7);
+    void drawString(int x, int y, const char* str, int color = 7); // No std::string built for fixed buffers
+    void drawString(int x, int y, const std::string& str, int color = 7) { drawString(x, y, str.c_str(), color); }
     void drawBox(int x, int y, int width, int height, char border = '#', int color = 7);
+    void flush();
+    
+    // Themed board cells. ch and color are the classic look, which the
+    // Windows console and recordings use.
+    bool setTheme(const std::string& name); // False for an unknown theme
+    const GlyphTable& getGlyphs() const;
+    void drawGlyph(int x, int y, int glyph, char ch, int color);
     
     // Input handling
     bool isKeyPressed();
     int getKeyPressed();
     bool isArrowKey(int key);
     void flushInputBuffer();
+    int64_t getKeyTime() const;
+    int64_t getFlushTime() const;
     
     // Sound effects
     void playBeep(int frequency = 800, int duration = 100);
@@ -53,6 +110,9 @@ public:
     void playGameOverSound();
     void playMoveSound();
     
+    // Recording (menus included); pass nullptr to stop
+    void setRecorder(FrameRecorder* frameRecorder);
+    
     // Utility functions
     void sleep(int milliseconds);
     void setConsoleMode();
@@ -0,0 +1,52 @@
+#include "file_lock.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+FileLock::FileLock(const std::string& filename, bool exclusive) {
+    ZeroMemory(&overlapped, sizeof(overlapped));
+    std::string lockName = filename + ".lock";
+    handle = CreateFileA(lockName.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                         nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle != INVALID_HANDLE_VALUE &&
+        !LockFileEx(handle, exclusive ? LOCKFILE_EXCLUSIVE_LOCK : 0, 0, 1, 0, &overlapped)) {
+        CloseHandle(handle);
+        handle = INVALID_HANDLE_VALUE;
+    }
+}
+
+FileLock::~FileLock() {
+    if (handle != INVALID_HANDLE_VALUE) {
+        UnlockFileEx(handle, 0, 1, 0, &overlapped);
+        CloseHandle(handle);
+    }
+}
+
+bool FileLock::isLocked() const {
+    return handle != INVALID_HANDLE_VALUE;
+}
+#else
+FileLock::FileLock(const std::string& filename, bool exclusive) {
+    std::string lockName = filename + ".lock";
+    descriptor = open(lockName.c_str(), O_RDWR | O_CREAT, 0644);
+    if (descriptor >= 0 && flock(descriptor, exclusive ? LOCK_EX : LOCK_SH) != 0) {
+        close(descriptor);
+        descriptor = -1;
+    }
+}
+
+FileLock::~FileLock() {
+    if (descriptor >= 0) {
+        flock(descriptor, LOCK_UN);
+        close(descriptor);
+    }
+}
+
+bool FileLock::isLocked() const {
+    return descriptor >= 0;
+}
+#endif
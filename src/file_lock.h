@@ -0,0 +1,29 @@
+#pragma once
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Advisory lock on <file>.lock, shared by every process that uses the same
+// file. The lock lives in its own file so the data file can be replaced
+// (high score compaction) or truncated (telemetry repair) while held.
+// Held from construction until destruction.
+class FileLock {
+private:
+#ifdef _WIN32
+    HANDLE handle;
+    OVERLAPPED overlapped;
+#else
+    int descriptor;
+#endif
+
+public:
+    FileLock(const std::string& filename, bool exclusive);
+    ~FileLock();
+
+    FileLock(const FileLock&) = delete;
+    FileLock& operator=(const FileLock&) = delete;
+
+    bool isLocked() const; // False if the lock file could not be opened or locked
+};
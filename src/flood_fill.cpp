@@ -0,0 +1,221 @@
+#include "flood_fill.h"
+#include <algorithm>
+
+namespace {
+    // Spreads set bits of `seeds` toward higher bits along runs of `mask`.
+    // Each step doubles the distance covered, so a word takes six steps.
+    uint64_t fillUp(uint64_t seeds, uint64_t mask) {
+        seeds |= mask & (seeds << 1);
+        mask &= mask << 1;
+        seeds |= mask & (seeds << 2);
+        mask &= mask << 2;
+        seeds |= mask & (seeds << 4);
+        mask &= mask << 4;
+        seeds |= mask & (seeds << 8);
+        mask &= mask << 8;
+        seeds |= mask & (seeds << 16);
+        mask &= mask << 16;
+        return seeds | (mask & (seeds << 32));
+    }
+
+    uint64_t fillDown(uint64_t seeds, uint64_t mask) {
+        seeds |= mask & (seeds >> 1);
+        mask &= mask >> 1;
+        seeds |= mask & (seeds >> 2);
+        mask &= mask >> 2;
+        seeds |= mask & (seeds >> 4);
+        mask &= mask >> 4;
+        seeds |= mask & (seeds >> 8);
+        mask &= mask >> 8;
+        seeds |= mask & (seeds >> 16);
+        mask &= mask >> 16;
+        return seeds | (mask & (seeds >> 32));
+    }
+}
+
+FloodFill::FloodFill() : top(0), bottom(-1) {
+}
+
+void FloodFill::spreadRow(uint64_t* row, const uint64_t* mask, bool wrap) const {
+    const int words = region.getWordsPerRow();
+    const int last = region.getWidth() - 1;
+    const uint64_t lastFlag = uint64_t(1) << (last & 63);
+
+    // Most rows filled from a neighbour are already closed under sideways
+    // moves; only spread if some open cell next to the row is still unset
+    uint64_t frontier = 0;
+    for (int w = 0; w < words; ++w) {
+        uint64_t left = (row[w] << 1) | (w > 0 ? row[w - 1] >> 63 : 0);
+        uint64_t right = (row[w] >> 1) | (w + 1 < words ? row[w + 1] << 63 : 0);
+        frontier |= (left | right) & mask[w] & ~row[w];
+    }
+    if (!frontier && !wrap) {
+        return;
+    }
+
+    while (true) {
+        // Upward pass carries each run's top bit into the next word, then the
+        // downward pass carries bit 0 back. Together they fill every run that
+        // holds a seed, however many words it crosses.
+        uint64_t carry = 0;
+        for (int w = 0; w < words; ++w) {
+            row[w] = fillUp(row[w] | (carry & mask[w]), mask[w]);
+            carry = row[w] >> 63;
+        }
+        carry = 0;
+        for (int w = words - 1; w >= 0; --w) {
+            row[w] = fillDown(row[w] | ((carry << 63) & mask[w]), mask[w]);
+            carry = row[w] & 1;
+        }
+
+        // Across the board edge: at most one more round
+        if (!wrap) {
+            return;
+        }
+        bool lastSet = (row[last >> 6] & lastFlag) != 0;
+        bool firstSet = (row[0] & 1) != 0;
+        if (lastSet && !firstSet && (mask[0] & 1)) {
+            row[0] |= 1;
+        } else if (firstSet && !lastSet && (mask[last >> 6] & lastFlag)) {
+            row[last >> 6] |= lastFlag;
+        } else {
+            return;
+        }
+    }
+}
+
+void FloodFill::grow(const Bitboard& mask, int startY, bool wrap) {
+    const int height = region.getHeight();
+    const int words = region.getWordsPerRow();
+    uint64_t* rows = region.data();
+    const uint64_t* masks = mask.data();
+
+    // Takes in the rows above and below; returns whether the row gained cells
+    auto dilate = [&](int y) {
+        uint64_t* row = rows + static_cast<size_t>(y) * words;
+        const uint64_t* rowMask = masks + static_cast<size_t>(y) * words;
+        // A missing neighbour row is stood in for by the row itself, which adds nothing
+        const uint64_t* above = y > 0 ? row - words : (wrap ? rows + static_cast<size_t>(height - 1) * words : row);
+        const uint64_t* below = y + 1 < height ? row + words : (wrap ? rows : row);
+
+        uint64_t gained = 0;
+        for (int w = 0; w < words; ++w) {
+            uint64_t grown = row[w] | ((above[w] | below[w]) & rowMask[w]);
+            gained |= grown ^ row[w];
+            row[w] = grown;
+        }
+        if (gained) {
+            spreadRow(row, rowMask, wrap);
+        }
+        return gained != 0;
+    };
+
+    spreadRow(rows + static_cast<size_t>(startY) * words, masks + static_cast<size_t>(startY) * words, wrap);
+
+    // Only rows next to the region so far can change; wrapping joins the edges
+    top = wrap ? 0 : startY;
+    bottom = wrap ? height - 1 : startY;
+    // Sweep down and up in turn; every row looks at both neighbours, so the
+    // first sweep that changes nothing means the region is complete
+    bool changed = true;
+    for (bool down = true; changed; down = !down) {
+        changed = false;
+        int first = down ? std::max(top - 1, 0) : std::min(bottom + 1, height - 1);
+        for (int y = first; y >= std::max(top - 1, 0) && y <= std::min(bottom + 1, height - 1); y += down ? 1 : -1) {
+            if (dilate(y)) {
+                changed = true;
+                top = std::min(top, y);
+                bottom = std::max(bottom, y);
+            }
+        }
+    }
+}
+
+int FloodFill::fill(const Bitboard& mask, int x, int y, bool wrap) {
+    const int words = mask.getWordsPerRow();
+    if (region.getWidth() != mask.getWidth() || region.getHeight() != mask.getHeight()) {
+        region.resize(mask.getWidth(), mask.getHeight());
+    } else if (bottom >= top) {
+        // Only the rows the last region reached can be dirty
+        std::fill(region.data() + static_cast<size_t>(top) * words, region.data() + static_cast<size_t>(bottom + 1) * words, 0);
+    }
+    top = 0;
+    bottom = -1;
+    if (x < 0 || y < 0 || x >= mask.getWidth() || y >= mask.getHeight() || !mask.test(x, y)) {
+        return 0;
+    }
+
+    region.set(x, y);
+    grow(mask, y, wrap);
+
+    int size = 0;
+    for (size_t i = static_cast<size_t>(top) * words; i < static_cast<size_t>(bottom + 1) * words; ++i) {
+        size += Bitboard::popCount(region.data()[i]);
+    }
+    return size;
+}
+
+int FloodFill::countComponents(const Bitboard& mask, bool wrap, int& largest) {
+    remaining = mask;
+    largest = 0;
+    int components = 0;
+
+    const int words = remaining.getWordsPerRow();
+    const size_t total = remaining.wordCount();
+    uint64_t* left = remaining.data();
+    for (size_t word = 0; word < total; ++word) {
+        while (left[word]) {
+            int x = static_cast<int>(word % words) * 64 + Bitboard::lowestBit(left[word]);
+            int size = fill(remaining, x, static_cast<int>(word / words), wrap);
+            if (size > largest) {
+                largest = size;
+            }
+            components++;
+
+            const uint64_t* taken = region.data();
+            for (size_t i = static_cast<size_t>(top) * words; i < static_cast<size_t>(bottom + 1) * words; ++i) {
+                left[i] &= ~taken[i];
+            }
+        }
+    }
+    return components;
+}
+
+int FloodFill::reachable(const Simulation& sim, const Position& from) {
+    const int width = sim.getWidth();
+    const int height = sim.getHeight();
+    if (open.getWidth() != width || open.getHeight() != height) {
+        open.resize(width, height);
+    }
+
+    // Free = on the board and neither snake nor wall
+    const Bitboard& occupied = sim.getOccupancy();
+    const Bitboard& walls = sim.getLevel().getWalls();
+    const int words = open.getWordsPerRow();
+    uint64_t lastWord = width % 64 == 0 ? ~uint64_t(0) : (uint64_t(1) << (width % 64)) - 1;
+    uint64_t* cells = open.data();
+    for (int y = 0; y < height; ++y) {
+        for (int w = 0; w < words; ++w) {
+            size_t index = static_cast<size_t>(y) * words + w;
+            cells[index] = ~(occupied.data()[index] | walls.data()[index]) & (w + 1 == words ? lastWord : ~uint64_t(0));
+        }
+    }
+
+    // The start counts as open for the fill but only as room if it really is free
+    bool startFree = open.test(from.x - 1, from.y - 1);
+    open.set(from.x - 1, from.y - 1);
+    int size = fill(open, from.x - 1, from.y - 1, sim.getMode() == MODE_WRAP);
+    if (!startFree) {
+        open.reset(from.x - 1, from.y - 1);
+        size--;
+    }
+    return size;
+}
+
+const Bitboard& FloodFill::getOpen() const {
+    return open;
+}
+
+const Bitboard& FloodFill::getRegion() const {
+    return region;
+}
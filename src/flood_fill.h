@@ -0,0 +1,40 @@
+#pragma once
+#include "bitboard.h"
+#include "simulation.h"
+
+// Reachability on packed bitboards. A region grows by dilating whole rows,
+// 64 cells per word operation: each row takes in the rows above and below,
+// then spreads sideways along its open runs, all masked by the open cells.
+// Rows are swept down and then up, using the rows already updated, until a
+// full sweep changes nothing. Buffers are kept between calls.
+//
+// Wrap-around boards connect opposite edges; portals are not followed.
+class FloodFill {
+private:
+    Bitboard region;
+    Bitboard remaining;  // Open cells not yet assigned to a component
+    Bitboard open;       // Free cells of the last simulation queried
+    int top;             // Rows the last region spans
+    int bottom;
+
+    void spreadRow(uint64_t* row, const uint64_t* mask, bool wrap) const;
+    void grow(const Bitboard& mask, int startY, bool wrap);
+
+public:
+    FloodFill();
+
+    // Cells reachable from (x, y) (0-based) through set cells of `mask`,
+    // counting the start. Returns 0 if the start is not open.
+    int fill(const Bitboard& mask, int x, int y, bool wrap);
+
+    // Separate open regions of `mask`; the biggest one's size goes to `largest`
+    int countComponents(const Bitboard& mask, bool wrap, int& largest);
+
+    // Free cells reachable from `from` in the current world, `from` itself
+    // included only if it is free (so from the head this is the room left)
+    int reachable(const Simulation& sim, const Position& from);
+
+    // Free cells of the world passed to the last reachable() call
+    const Bitboard& getOpen() const;
+    const Bitboard& getRegion() const;
+};
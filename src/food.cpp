@@ -32,6 +32,25 @@ void Food::generate(int maxX, int maxY, const Snake& snake) {
     }
 }
 
+void Food::generate(int maxX, int maxY, const Bitboard& occupied, const Bitboard& blocked, Random& random) {
+    if (maxX <= 0 || maxY <= 0) {
+        active = false;
+        return;
+    }
+    
+    int attempts = 0;
+    const int maxAttempts = 100;
+    
+    // Same search as above, but snake cells and level obstacles are both a single bit test
+    do {
+        position.x = random.range(1, maxX);
+        position.y = random.range(1, maxY);
+        attempts++;
+    } while (occupied.testUnion(blocked, position.x - 1, position.y - 1) && attempts < maxAttempts);
+    
+    active = attempts < maxAttempts;
+}
+
 void Food::reset() {
     active = false;
     position = Position(0, 0);
@@ -77,4 +96,12 @@ void Food::draw(Console& console) const {
 
 int Food::getPoints() const {
     return points;
+}
+
+char Food::getSymbol() const {
+    return symbol;
+}
+
+int Food::getColor() const {
+    return color;
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 #include "snake.h"
 #include "console.h"
+#include "bitboard.h"
+#include "random.h"
 #include <vector>
 
 class Food {
@@ -16,6 +18,7 @@ public:
     
     // Food management
     void generate(int maxX, int maxY, const Snake& snake);
+    void generate(int maxX, int maxY, const Bitboard& occupied, const Bitboard& blocked, Random& random);
     void reset();
     void setPosition(int x, int y);
     Position getPosition() const;
@@ -31,4 +34,6 @@ public:
     
     // Getters
     int getPoints() const;
+    char getSymbol() const;
+    int getColor() const;
 };
\ No newline at end of file
@@ -0,0 +1,175 @@
+#include "food_field.h"
+#include "console.h"
+#include "zobrist.h"
+#include <algorithm>
+
+namespace {
+    uint64_t itemKey(const FoodItem& item) {
+        return Zobrist::key(static_cast<ZobristFeature>(ZOBRIST_ITEM + item.kind), item.position.x, item.position.y);
+    }
+}
+
+FoodField::FoodField() : width(0), height(0), count(0), hash(0) {
+}
+
+void FoodField::resize(int newWidth, int newHeight, int capacity) {
+    width = newWidth;
+    height = newHeight;
+    items.assign(static_cast<size_t>(capacity), FoodItem{ Position(0, 0), FOOD_NORMAL, 0, false });
+    cellIndex.assign(static_cast<size_t>(width) * height, -1);
+    expiry.resize(capacity);
+    expired.reserve(static_cast<size_t>(capacity));
+    clear();
+}
+
+void FoodField::clear() {
+    // Only cells holding an active item are indexed, so there is no need to
+    // sweep the whole board (resets stay cheap on large boards)
+    for (FoodItem& item : items) {
+        if (item.active) {
+            cellIndex[cellOf(item.position.x, item.position.y)] = -1;
+            item.active = false;
+        }
+    }
+    expiry.clear();
+    expired.clear();
+
+    // Hand out low slots first
+    freeSlots.clear();
+    for (int slot = static_cast<int>(items.size()) - 1; slot >= 0; --slot) {
+        freeSlots.push_back(slot);
+    }
+    count = 0;
+    hash = 0;
+}
+
+bool FoodField::spawn(FoodKind kind, const Position& pos, int lifetime) {
+    if (freeSlots.empty() || pos.x < 1 || pos.x > width || pos.y < 1 || pos.y > height) {
+        return false;
+    }
+    int cell = cellOf(pos.x, pos.y);
+    if (cellIndex[cell] >= 0) {
+        return false;
+    }
+
+    int slot = freeSlots.back();
+    freeSlots.pop_back();
+    items[slot] = FoodItem{ pos, kind, getPoints(kind), true };
+    cellIndex[cell] = slot;
+    count++;
+    hash ^= itemKey(items[slot]);
+
+    if (lifetime > 0) {
+        expiry.schedule(slot, expiry.getNow() + static_cast<uint64_t>(lifetime));
+    }
+    return true;
+}
+
+bool FoodField::spawnRandom(FoodKind kind, const Bitboard& occupied, const Bitboard& blocked, int lifetime,
+                            Random& random, Position& placed) {
+    const int maxAttempts = 100;
+    for (int attempt = 0; attempt < maxAttempts; ++attempt) {
+        Position pos(random.range(1, width), random.range(1, height));
+        if (!occupied.testUnion(blocked, pos.x - 1, pos.y - 1) && !isFoodAt(pos.x, pos.y)) {
+            placed = pos;
+            return spawn(kind, pos, lifetime);
+        }
+    }
+    return false;
+}
+
+void FoodField::remove(int slot) {
+    FoodItem& item = items[slot];
+    cellIndex[cellOf(item.position.x, item.position.y)] = -1;
+    item.active = false;
+    freeSlots.push_back(slot);
+    count--;
+    hash ^= itemKey(item);
+}
+
+bool FoodField::consume(int x, int y, FoodItem& eaten) {
+    int slot = cellIndex[cellOf(x, y)];
+    if (slot < 0) {
+        return false;
+    }
+    eaten = items[slot];
+    expiry.cancel(slot);
+    remove(slot);
+    return true;
+}
+
+void FoodField::tick() {
+    expired.clear();
+    for (int slot : expiry.advance()) {
+        expired.push_back(items[slot].position);
+        remove(slot);
+    }
+}
+
+int FoodField::getCount() const {
+    return count;
+}
+
+uint64_t FoodField::getHash() const {
+    return hash;
+}
+
+int FoodField::getCapacity() const {
+    return static_cast<int>(items.size());
+}
+
+const std::vector<FoodItem>& FoodField::getItems() const {
+    return items;
+}
+
+const std::vector<Position>& FoodField::getExpired() const {
+    return expired;
+}
+
+int FoodField::getPoints(FoodKind kind) {
+    switch (kind) {
+        case FOOD_NORMAL:
+            return 10;
+        case FOOD_BONUS:
+            return 50;
+        case FOOD_SHRINK:
+            return 5;
+        case FOOD_SPEED:
+            return 20;
+        default:
+            break;
+    }
+    return 0;
+}
+
+char FoodField::getSymbol(FoodKind kind) {
+    switch (kind) {
+        case FOOD_NORMAL:
+            return '*';
+        case FOOD_BONUS:
+            return '$';
+        case FOOD_SHRINK:
+            return '-';
+        case FOOD_SPEED:
+            return '>';
+        default:
+            break;
+    }
+    return '?';
+}
+
+int FoodField::getColor(FoodKind kind) {
+    switch (kind) {
+        case FOOD_NORMAL:
+            return RED;
+        case FOOD_BONUS:
+            return BRIGHT_YELLOW;
+        case FOOD_SHRINK:
+            return BRIGHT_CYAN;
+        case FOOD_SPEED:
+            return BRIGHT_MAGENTA;
+        default:
+            break;
+    }
+    return WHITE;
+}
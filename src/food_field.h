@@ -0,0 +1,66 @@
+#pragma once
+#include "bitboard.h"
+#include "random.h"
+#include "snake.h"
+#include "timing_wheel.h"
+#include <vector>
+
+enum FoodKind {
+    FOOD_NORMAL,
+    FOOD_BONUS,   // Worth more, disappears after a while
+    FOOD_SHRINK,  // Removes tail segments, disappears after a while
+    FOOD_SPEED,   // Temporary speed boost
+    FOOD_KIND_COUNT
+};
+
+struct FoodItem {
+    Position position;
+    FoodKind kind;
+    int points;
+    bool active;
+};
+
+// Extra food items on top of the main pellet. Items are indexed by cell so
+// the head lookup is O(1), and timed items expire through a timing wheel so
+// the per-tick cost does not depend on how many items are on the board.
+class FoodField {
+private:
+    int width;
+    int height;
+    std::vector<FoodItem> items;
+    std::vector<int> freeSlots;
+    std::vector<int> cellIndex;        // Item slot per cell, -1 if empty
+    std::vector<Position> expired;     // Cells cleared by expiry on the last tick
+    TimingWheel expiry;
+    int count;
+    uint64_t hash;                     // XOR of the active items' Zobrist keys
+
+    int cellOf(int x, int y) const { return (y - 1) * width + (x - 1); }
+    void remove(int slot);
+
+public:
+    FoodField();
+
+    // Setup
+    void resize(int newWidth, int newHeight, int capacity);
+    void clear();
+
+    // Item management (lifetime 0 means the item never expires)
+    bool spawn(FoodKind kind, const Position& pos, int lifetime);
+    bool spawnRandom(FoodKind kind, const Bitboard& occupied, const Bitboard& blocked, int lifetime, Random& random,
+                     Position& placed);
+    bool consume(int x, int y, FoodItem& eaten);
+    void tick();
+
+    // Queries
+    bool isFoodAt(int x, int y) const { return cellIndex[cellOf(x, y)] >= 0; }
+    int getCount() const;
+    uint64_t getHash() const;
+    int getCapacity() const;
+    const std::vector<FoodItem>& getItems() const;
+    const std::vector<Position>& getExpired() const;
+
+    static int getPoints(FoodKind kind);
+    static char getSymbol(FoodKind kind);
+    static int getColor(FoodKind kind);
+};
@@ -0,0 +1,47 @@
+#pragma once
+#include "cell_change.h"
+#include <cstdint>
+#include <vector>
+
+// Picture of the world after one tick. The simulation thread fills one and
+// publishes it; the renderer only ever reads published snapshots. At high
+// tick rates one snapshot covers several ticks.
+struct FrameSnapshot {
+    uint64_t tick;
+    uint64_t changesFrom;            // Tick `changes` start from; if it is on screen they alone bring it up to date
+    int width;
+    int height;
+    std::vector<uint8_t> cells;      // CellKind per play cell, row-major from (1, 1)
+    std::vector<uint8_t> links;      // CellLink bits per play cell (snake cells only), same layout; empty without link tracking
+    std::vector<CellChange> changes; // Cells changed since changesFrom, oldest first
+    char foodSymbol;
+    int foodColor;
+
+    // Side panel
+    int score;
+    int level;
+    int highScore;
+    int tickRate;                    // Ticks per second
+    bool turbo;
+    bool alive;
+    bool trapped;                    // Head cannot reach room for the whole body
+
+    // Latest direction change the simulation applied, for input latency
+    uint32_t turnCount;
+    int64_t turnKeyTime;  // When the key was read
+    int64_t turnTickTime; // When the tick that applied it ran
+
+    FrameSnapshot()
+        : tick(0), changesFrom(0), width(0), height(0), foodSymbol('@'), foodColor(0),
+          score(0), level(1), highScore(0), tickRate(0), turbo(false), alive(true), trapped(false),
+          turnCount(0), turnKeyTime(0), turnTickTime(0) {
+    }
+
+    CellKind getCell(int x, int y) const {
+        return static_cast<CellKind>(cells[static_cast<size_t>(y - 1) * width + (x - 1)]);
+    }
+
+    uint8_t getLinks(int x, int y) const {
+        return links.empty() ? 0 : links[static_cast<size_t>(y - 1) * width + (x - 1)];
+    }
+};
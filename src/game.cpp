@@ -1,12 +1,58 @@
 #include "game.h"
+#include "allocation_counter.h"
 #include <iostream>
 #include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+
+namespace {
+    // Built-in level files (base names under levels/); empty means open field
+    const char* LEVEL_FILES[] = { "", "box", "cross", "portals" };
+    const int LEVEL_COUNT = 4;
+    
+    // A direction key waiting for the simulation thread, packed so both
+    // halves are handed over by one atomic: key time above, direction + 1 in
+    // the low three bits (0 means no key)
+    uint64_t packInput(Direction direction, int64_t keyTime) {
+        return (static_cast<uint64_t>(keyTime) << 3) | static_cast<uint64_t>(direction + 1);
+    }
+    
+    // Latency panel rows under the HUD, padded so shorter text erases longer
+    const int LATENCY_ROW = 8;
+    const int LATENCY_ROWS = 5;
+    const size_t LATENCY_WIDTH = 26;
+    
+    // Tick rate, and the warning row between the HUD and the latency panel
+    const int SPEED_ROW = 6;
+    const int TRAPPED_ROW = 7;
+    
+    // Side panel text is formatted into fixed buffers, so redrawing it during play never allocates
+    const int HUD_TEXT_SIZE = 48;
+}
 
 Game::Game() 
     : state(MENU), difficulty(NORMAL), score(0), highScore(0), level(1), speed(1),
       gameWidth(40), gameHeight(20), borderWidth(42), borderHeight(22),
-      frameDelay(150), frameCounter(0), frameReady(false), snake(gameWidth / 2, gameHeight / 2) {
+      simulation(gameWidth, gameHeight), renderer(console), drawnScore(-1), drawnLevel(-1), drawnHighScore(-1),
+      drawnTickRate(-1), drawnTurbo(false), drawnTrapped(false),
+      tickInterval(80000), boostTicks(0), tickCount(0), publishedTick(0), turbo(false),
+      simulationRunning(false), pendingInput(0),
+      turnCount(0), turnKeyTime(0), turnTickTime(0), measuredTurns(0), showLatency(false), drawnLatencyCount(0),
+      scoreRecorded(false), scoreRank(0), telemetryFile(Utils::getTelemetryFileName()), gameSeed(0),
+      gameFood(0), gameInputs(0), gameCause(DEATH_NONE), gameTickNanos(0), telemetryRecorded(false) {
     Utils::seedRandom();
+    simulation.seed(static_cast<uint64_t>(std::time(nullptr)));
+    
+    // A handful of bonus/shrink/speed items appear alongside the main food
+    simulation.setExtraFood(8, 60);
+    
+    // The renderer only redraws the cells each tick touched, and joins the
+    // snake's segments up in themes that draw them
+    simulation.setChangeTracking(true);
+    simulation.setLinkTracking(true);
 }
 
 Game::~Game() {
@@ -14,12 +60,23 @@ Game::~Game() {
 }
 
 bool Game::initialize() {
+    // Box drawing and colours when the terminal looks able to show them
+    console.setTheme("auto");
     if (!console.initialize()) {
         return false;
     }
     
-    // Load high score
-    highScore = Utils::getHighestScore();
+    // Start the background mixer; fall back to silence if no audio device
+    if (!sound.start(SoundSystem::createDefaultSink())) {
+        sound.start(std::unique_ptr<SoundSink>(new NullSoundSink()));
+    }
+    
+    // Load high scores once; the leaderboard answers every later query
+    leaderboard.load(Utils::loadHighScores());
+    highScore = leaderboard.getTopScore();
+    
+    // Score saving and compaction run in the background
+    scoreStore.start();
     
     // Setup game area
     setupGameArea();
@@ -49,68 +106,314 @@ void Game::run() {
     }
 }
 
-void Game::cleanup() {
-    console.cleanup();
+bool Game::startRecording(const std::string& filename) {
+    // Record the whole window so menus and the side panel are included
+    int width = 0;
+    int height = 0;
+    console.getConsoleSize(width, height);
+    if (!recorder.start(filename, width, height)) {
+        return false;
+    }
+    console.setRecorder(&recorder);
+    return true;
 }
 
-void Game::gameLoop() {
-    while (state == PLAYING) {
-        // Frame timing
-        frameCounter++;
-        if (frameCounter >= frameDelay) {
-            frameCounter = 0;
-            frameReady = true;
-        }
+void Game::setLatencyLog(const std::string& filename) {
+    latencyLogFile = filename;
+}
 
-        // Handle input
-        handleInput();
+bool Game::setSpectatorFeed(const std::string& feedName) {
+    return spectatorFeed.create(feedName, gameWidth, gameHeight);
+}
 
-        if (frameReady) {
-            // Update game state
-            update();
+void Game::setTelemetryLog(const std::string& filename) {
+    telemetry.close();
+    telemetryFile = filename;
+}
 
-            // Render only on update ticks to reduce flicker
-            render();
-        }
+bool Game::setTheme(const std::string& themeName) {
+    if (!console.setTheme(themeName)) {
+        return false;
+    }
+    renderer.invalidate();
+    return true;
+}
 
-        // Small delay to prevent excessive CPU usage
-        console.sleep(10);
+bool Game::setAutopilot(const std::string& botName, const BotSettings& settings) {
+    autopilot = Bot::create(botName, settings);
+    if (autopilot && !autopilot->fitsBoard(gameWidth, gameHeight)) {
+        autopilot.reset();
     }
+    return autopilot != nullptr;
 }
 
-void Game::update() {
-    if (!frameReady) {
-        return;
+void Game::cleanup() {
+    sound.stop();
+    scoreStore.stop();
+    spectatorFeed.close();
+    telemetry.close();
+    console.cleanup();
+    logLatency();
+    
+    if (recorder.isRecording()) {
+        console.setRecorder(nullptr);
+        recorder.stop();
+        Utils::logInfo("Recorded " + std::to_string(recorder.getFrameCount()) + " frames, " +
+                       std::to_string(recorder.getBytesWritten() / 1024) + " KB (" +
+                       std::to_string(static_cast<int>(recorder.getCompressionRatio())) + "x smaller), " +
+                       std::to_string(static_cast<int>(recorder.getAverageCaptureMicros())) + " us per frame");
+    }
+}
+
+uint64_t Game::checkAllocations(Bot* bot, long long ticks, long long warmupTicks, long long& checkedTicks,
+                                long long& games) {
+    // A policy trained for the headless board size cannot steer this one
+    if (bot && !bot->fitsBoard(gameWidth, gameHeight)) {
+        bot = nullptr;
     }
+    console.setOffscreen(true);
+    showLatency = true;
+    initializeGame();
+    renderer.invalidate();
+    publishFrame(true);
+    measuredTurns = turnCount;
+    
+    uint64_t allocations = 0;
+    checkedTicks = 0;
+    games = 1;
+    for (long long tick = 1; tick <= ticks; tick++) {
+        // Handed over like a key press, so turns go through the latency panel
+        if (bot) {
+            pendingInput.store(packInput(bot->chooseDirection(simulation), LatencyHistogram::now()));
+        }
+        
+        // One frame per tick, in the order the two play threads run it
+        uint64_t allocationsBefore = AllocationCounter::getCount();
+        bool alive = update();
+        publishFrame(alive);
+        frames.update();
+        const FrameSnapshot& frame = frames.getFront();
+        render(frame);
+        console.flush();
+        measureLatency(frame);
+        if (!alive) {
+            initializeGame();
+            renderer.invalidate();
+            publishFrame(true);
+            games++;
+        }
+        if (tick > warmupTicks) {
+            allocations += AllocationCounter::getCount() - allocationsBefore;
+            checkedTicks++;
+        }
+    }
+    
+    // Nothing to report from cleanup()
+    keyToTick.clear();
+    tickToFlush.clear();
+    keyToFlush.clear();
+    return allocations;
+}
+
+void Game::gameLoop() {
+    // Menus and the pause overlay draw over the board, so start with a full repaint
+    renderer.invalidate();
+    spectatorFeed.setLevel(simulation.getLevel());
+    publishFrame(true);
+    drawnLatencyCount = 0;
+    measuredTurns = turnCount;
+    
+    pendingInput.store(0);
+    simulationRunning = true;
+    simulationThread = std::thread(&Game::simulationLoop, this);
     
-    frameReady = false;
+    while (state == PLAYING) {
+        // Handle input (directions are handed to the simulation thread)
+        handleInput();
+        
+        // Draw the newest tick; frames published in between are skipped
+        frames.update();
+        const FrameSnapshot& frame = frames.getFront();
+        render(frame);
+        if (!frame.alive) {
+            setState(GAME_OVER);
+        }
+        
+        // Small delay to prevent excessive CPU usage (flushes the frame first)
+        console.sleep(10);
+        measureLatency(frame);
+    }
     
-    // Update snake
-    snake.update();
+    {
+        std::lock_guard<std::mutex> lock(simulationMutex);
+        simulationRunning = false;
+    }
+    simulationWake.notify_one();
+    simulationThread.join();
     
-    // Check collisions
-    processCollisions();
+    // The snake may have died while the player was pausing
+    frames.update();
+    if (!frames.getFront().alive) {
+        setState(GAME_OVER);
+    }
+}
+
+void Game::simulationLoop() {
+    // Ticks are scheduled against absolute deadlines, so neither rendering
+    // nor a slow terminal can stretch the interval between them. Faster than
+    // the display rate, each wake-up runs every tick that has come due and
+    // publishes one frame for all of them.
+    const auto frameInterval = std::chrono::microseconds(1000000 / DISPLAY_RATE);
+    const auto stallLimit = std::chrono::milliseconds(250);
+    auto lastWake = std::chrono::steady_clock::now();
+    auto nextTick = lastWake + std::chrono::microseconds(getTickInterval());
+    std::unique_lock<std::mutex> lock(simulationMutex);
     
-    // Check game over conditions
-    checkGameOver();
+    while (true) {
+        auto wakeAt = std::max(nextTick, lastWake + frameInterval);
+        if (simulationWake.wait_until(lock, wakeAt, [this] { return !simulationRunning; })) {
+            return;
+        }
+        
+        // After a stall (debugger, suspended process) resume from now rather than catching up
+        auto now = std::chrono::steady_clock::now();
+        lastWake = now;
+        if (now > nextTick + stallLimit) {
+            nextTick = now;
+        }
+        
+        bool alive = true;
+        while (alive && nextTick <= now) {
+            alive = update();
+            nextTick += std::chrono::microseconds(getTickInterval());
+            
+            // Ticks slower than their interval (a thinking bot) must not starve the display
+            if (std::chrono::steady_clock::now() - now >= frameInterval) {
+                nextTick = std::max(nextTick, std::chrono::steady_clock::now());
+                break;
+            }
+        }
+        
+        publishFrame(alive);
+        if (!alive) {
+            return;
+        }
+    }
 }
 
-void Game::render() {
-    // Clear game area
-    clearGameArea();
+bool Game::update() {
+    auto startTime = std::chrono::steady_clock::now();
+    uint64_t input = pendingInput.exchange(0);
+    if (autopilot) {
+        if (simulation.getSnake().setDirection(autopilot->chooseDirection(simulation))) {
+            gameInputs++;
+        }
+    } else if (input != 0) {
+        Direction direction = static_cast<Direction>((input & 7) - 1);
+        if (simulation.getSnake().setDirection(direction)) {
+            turnCount++;
+            turnKeyTime = static_cast<int64_t>(input >> 3);
+            turnTickTime = LatencyHistogram::now();
+            gameInputs++;
+        }
+    }
     
-    // Draw border
-    drawBorder();
+    // Advance the world one tick under the active rules
+    StepResult result = simulation.step();
+    tickCount++;
     
-    // Draw snake
-    snake.draw(console);
+    // React to what happened this tick
+    processCollisions(result);
+    gameTickNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - startTime).count();
+    return result.alive;
+}
+
+void Game::publishFrame(bool alive) {
+    FrameSnapshot& frame = frames.getBack();
+    simulation.captureFrame(frame);
+    simulation.clearChanges();
+    frame.tick = tickCount;
+    frame.changesFrom = publishedTick;
+    publishedTick = tickCount;
+    frame.score = score;
+    frame.level = level;
+    frame.highScore = highScore;
+    frame.tickRate = 1000000 / getTickInterval();
+    frame.turbo = turbo.load();
+    frame.alive = alive;
+    frame.trapped = alive && isTrapped();
+    frame.turnCount = turnCount;
+    frame.turnKeyTime = turnKeyTime;
+    frame.turnTickTime = turnTickTime;
+    spectatorFeed.publish(frame);
+    frames.publish();
+}
+
+bool Game::isTrapped() {
+    const Snake& snake = simulation.getSnake();
+    if (trapFill.reachable(simulation, snake.getHead()) >= snake.getLength()) {
+        return false;
+    }
     
-    // Draw food
-    food.draw(console);
+    // The tail moves out of the way every tick, so a pocket that reaches it
+    // is not a trap yet
+    const Bitboard& region = trapFill.getRegion();
+    Position tail = snake.getTail();
+    const int width = simulation.getWidth();
+    const int height = simulation.getHeight();
+    const bool wrap = simulation.getMode() == MODE_WRAP;
+    const int dx[4] = { 0, 0, -1, 1 };
+    const int dy[4] = { -1, 1, 0, 0 };
+    for (int i = 0; i < 4; i++) {
+        int x = tail.x - 1 + dx[i];
+        int y = tail.y - 1 + dy[i];
+        if (wrap) {
+            x = (x + width) % width;
+            y = (y + height) % height;
+        }
+        if (x >= 0 && y >= 0 && x < width && y < height && region.test(x, y)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Game::render(const FrameSnapshot& frame) {
+    // Board: full repaint when needed, otherwise just the changed cells
+    bool repainted = renderer.render(frame, simulation.getLevel());
     
-    // Draw UI
-    drawScore();
-    drawGameInfo();
+    // Side panel: only when a value changed
+    if (repainted || frame.score != drawnScore) {
+        drawScore(frame.score);
+    }
+    if (repainted || frame.level != drawnLevel || frame.highScore != drawnHighScore) {
+        drawGameInfo(frame.level, frame.highScore);
+    }
+    if (repainted || frame.tickRate != drawnTickRate || frame.turbo != drawnTurbo) {
+        drawSpeed(frame.tickRate, frame.turbo);
+    }
+    if (repainted || frame.trapped != drawnTrapped) {
+        drawTrapped(frame.trapped);
+    }
+    if (repainted) {
+        drawnLatencyCount = 0;
+    }
+    if (showLatency && keyToFlush.getCount() != drawnLatencyCount) {
+        drawLatency();
+    }
+}
+
+void Game::measureLatency(const FrameSnapshot& frame) {
+    // A turn counts once, on the first flushed frame that shows it
+    if (frame.turnCount == measuredTurns) {
+        return;
+    }
+    measuredTurns = frame.turnCount;
+    int64_t flushTime = console.getFlushTime();
+    keyToTick.record(frame.turnTickTime - frame.turnKeyTime);
+    tickToFlush.record(flushTime - frame.turnTickTime);
+    keyToFlush.record(flushTime - frame.turnKeyTime);
 }
 
 void Game::handleInput() {
@@ -122,16 +425,25 @@ void Game::handleInput() {
     
     switch (key) {
         case VK_UP:
-            snake.setDirection(UP);
+            pendingInput.store(packInput(UP, console.getKeyTime()));
             break;
         case VK_DOWN:
-            snake.setDirection(DOWN);
+            pendingInput.store(packInput(DOWN, console.getKeyTime()));
             break;
         case VK_LEFT:
-            snake.setDirection(LEFT);
+            pendingInput.store(packInput(LEFT, console.getKeyTime()));
             break;
         case VK_RIGHT:
-            snake.setDirection(RIGHT);
+            pendingInput.store(packInput(RIGHT, console.getKeyTime()));
+            break;
+        case 'T':
+            // Turbo: the simulation picks it up from the next tick
+            turbo = !turbo.load();
+            break;
+        case 'L':
+            // Toggle the latency panel
+            showLatency = !showLatency;
+            drawLatency();
             break;
         case VK_ESCAPE:
             setState(PAUSED);
@@ -144,46 +456,29 @@ void Game::handleInput() {
     }
 }
 
-void Game::processCollisions() {
-    // Check food collision
-    checkFoodCollision();
-    
-    // Check wall collision
-    if (snake.checkWallCollision(gameWidth, gameHeight)) {
-        setState(GAME_OVER);
-        console.playBeep(200, 500);
-        return;
+void Game::processCollisions(const StepResult& result) {
+    // Food eaten
+    if (result.ateFood) {
+        gameFood++;
+        increaseScore(result.points);
+        sound.playEatSound();
+        if (result.foodKind == FOOD_SPEED) {
+            boostTicks = 40;
+        }
+    }
+    if (boostTicks > 0) {
+        boostTicks--;
     }
     
-    // Check self collision
-    if (snake.checkSelfCollision()) {
-        setState(GAME_OVER);
-        console.playBeep(200, 500);
-        return;
+    // Wall or self collision; the main thread sees it in the published frame
+    if (!result.alive) {
+        gameCause = result.cause;
+        sound.playGameOverSound();
     }
 }
 
 void Game::showMainMenu() {
-    console.clearScreen();
-    
-    int centerX = 40;
-    int centerY = 10;
-    
-    // Title
-    console.drawString(centerX - 8, centerY - 4, "SNAKE GAME", BRIGHT_GREEN);
-    console.drawString(centerX - 12, centerY - 3, "====================", BRIGHT_GREEN);
-    
-    // Menu options
-    console.drawString(centerX - 6, centerY, "1. Start Game", WHITE);
-    console.drawString(centerX - 6, centerY + 1, "2. Difficulty", WHITE);
-    console.drawString(centerX - 6, centerY + 2, "3. High Scores", WHITE);
-    console.drawString(centerX - 6, centerY + 3, "4. Exit", WHITE);
-    
-    // Current difficulty
-    console.drawString(centerX - 8, centerY + 5, "Difficulty: " + getDifficultyName(), BRIGHT_CYAN);
-    
-    // Instructions
-    console.drawString(centerX - 15, centerY + 7, "Use number keys to select option", BRIGHT_YELLOW);
+    drawMainMenu();
     
     // Wait for input
     while (state == MENU) {
@@ -198,30 +493,24 @@ void Game::showMainMenu() {
                 case '2':
                     showDifficultyMenu();
                     // Redraw main menu after returning from the difficulty menu
-                    console.clearScreen();
-                    console.drawString(centerX - 8, centerY - 4, "SNAKE GAME", BRIGHT_GREEN);
-                    console.drawString(centerX - 12, centerY - 3, "====================", BRIGHT_GREEN);
-                    console.drawString(centerX - 6, centerY, "1. Start Game", WHITE);
-                    console.drawString(centerX - 6, centerY + 1, "2. Difficulty", WHITE);
-                    console.drawString(centerX - 6, centerY + 2, "3. High Scores", WHITE);
-                    console.drawString(centerX - 6, centerY + 3, "4. Exit", WHITE);
-                    console.drawString(centerX - 8, centerY + 5, "Difficulty: " + getDifficultyName(), BRIGHT_CYAN);
-                    console.drawString(centerX - 15, centerY + 7, "Use number keys to select option", BRIGHT_YELLOW);
+                    drawMainMenu();
                     break;
                 case '3':
+                    showModeMenu();
+                    // Redraw main menu after returning from the mode menu
+                    drawMainMenu();
+                    break;
+                case '4':
+                    showLevelMenu();
+                    // Redraw main menu after returning from the level menu
+                    drawMainMenu();
+                    break;
+                case '5':
                     showHighScores();
                     // Redraw main menu after returning from the high scores screen
-                    console.clearScreen();
-                    console.drawString(centerX - 8, centerY - 4, "SNAKE GAME", BRIGHT_GREEN);
-                    console.drawString(centerX - 12, centerY - 3, "====================", BRIGHT_GREEN);
-                    console.drawString(centerX - 6, centerY, "1. Start Game", WHITE);
-                    console.drawString(centerX - 6, centerY + 1, "2. Difficulty", WHITE);
-                    console.drawString(centerX - 6, centerY + 2, "3. High Scores", WHITE);
-                    console.drawString(centerX - 6, centerY + 3, "4. Exit", WHITE);
-                    console.drawString(centerX - 8, centerY + 5, "Difficulty: " + getDifficultyName(), BRIGHT_CYAN);
-                    console.drawString(centerX - 15, centerY + 7, "Use number keys to select option", BRIGHT_YELLOW);
+                    drawMainMenu();
                     break;
-                case '4':
+                case '6':
                     setState(EXIT);
                     break;
             }
@@ -230,6 +519,33 @@ void Game::showMainMenu() {
     }
 }
 
+void Game::drawMainMenu() {
+    console.clearScreen();
+    
+    int centerX = 40;
+    int centerY = 10;
+    
+    // Title
+    console.drawString(centerX - 8, centerY - 4, "SNAKE GAME", BRIGHT_GREEN);
+    console.drawString(centerX - 12, centerY - 3, "====================", BRIGHT_GREEN);
+    
+    // Menu options
+    console.drawString(centerX - 6, centerY, "1. Start Game", WHITE);
+    console.drawString(centerX - 6, centerY + 1, "2. Difficulty", WHITE);
+    console.drawString(centerX - 6, centerY + 2, "3. Game Mode", WHITE);
+    console.drawString(centerX - 6, centerY + 3, "4. Level", WHITE);
+    console.drawString(centerX - 6, centerY + 4, "5. High Scores", WHITE);
+    console.drawString(centerX - 6, centerY + 5, "6. Exit", WHITE);
+    
+    // Current settings
+    console.drawString(centerX - 8, centerY + 7, "Difficulty: " + getDifficultyName(), BRIGHT_CYAN);
+    console.drawString(centerX - 8, centerY + 8, std::string("Mode: ") + Simulation::getModeName(getGameMode()), BRIGHT_CYAN);
+    console.drawString(centerX - 8, centerY + 9, "Level: " + simulation.getLevel().getName(), BRIGHT_CYAN);
+    
+    // Instructions
+    console.drawString(centerX - 15, centerY + 11, "Use number keys to select option", BRIGHT_YELLOW);
+}
+
 void Game::showDifficultyMenu() {
     console.clearScreen();
     
@@ -270,6 +586,76 @@ void Game::showDifficultyMenu() {
     }
 }
 
+void Game::showModeMenu() {
+    console.clearScreen();
+    
+    int centerX = 40;
+    int centerY = 10;
+    
+    console.drawString(centerX - 8, centerY - 2, "SELECT GAME MODE", BRIGHT_GREEN);
+    console.drawString(centerX - 12, centerY, "====================", BRIGHT_GREEN);
+    
+    console.drawString(centerX - 6, centerY + 2, "1. Classic (Walls kill)", WHITE);
+    console.drawString(centerX - 6, centerY + 3, "2. Wrap Around (No walls)", WHITE);
+    console.drawString(centerX - 6, centerY + 4, "3. Marathon (Grow x3, Slower)", WHITE);
+    console.drawString(centerX - 6, centerY + 5, "4. Back to Menu", WHITE);
+    
+    while (state == MENU) {
+        if (console.isKeyPressed()) {
+            int key = console.getKeyPressed();
+            
+            switch (key) {
+                case '1':
+                    setGameMode(MODE_CLASSIC);
+                    return; // return to main menu
+                case '2':
+                    setGameMode(MODE_WRAP);
+                    return; // return to main menu
+                case '3':
+                    setGameMode(MODE_MARATHON);
+                    return; // return to main menu
+                case '4':
+                    return; // return to main menu
+            }
+        }
+        console.sleep(50);
+    }
+}
+
+void Game::showLevelMenu() {
+    console.clearScreen();
+    
+    int centerX = 40;
+    int centerY = 10;
+    
+    console.drawString(centerX - 8, centerY - 2, "SELECT LEVEL", BRIGHT_GREEN);
+    console.drawString(centerX - 12, centerY, "====================", BRIGHT_GREEN);
+    
+    console.drawString(centerX - 6, centerY + 2, "1. Open Field", WHITE);
+    console.drawString(centerX - 6, centerY + 3, "2. Box", WHITE);
+    console.drawString(centerX - 6, centerY + 4, "3. Cross Roads", WHITE);
+    console.drawString(centerX - 6, centerY + 5, "4. Portals", WHITE);
+    console.drawString(centerX - 6, centerY + 6, "5. Back to Menu", WHITE);
+    
+    while (state == MENU) {
+        if (console.isKeyPressed()) {
+            int key = console.getKeyPressed();
+            
+            if (key >= '1' && key < '1' + LEVEL_COUNT) {
+                if (!selectLevel(LEVEL_FILES[key - '1'])) {
+                    console.drawString(centerX - 12, centerY + 8, "Could not load level file!", BRIGHT_RED);
+                    continue;
+                }
+                return; // return to main menu
+            }
+            if (key == '5') {
+                return; // return to main menu
+            }
+        }
+        console.sleep(50);
+    }
+}
+
 void Game::showPauseMenu() {
     int centerX = 40;
     int centerY = 10;
@@ -305,10 +691,22 @@ void Game::showGameOverMenu() {
     console.drawString(centerX - 8, centerY, "Final Score: " + std::to_string(score), WHITE);
     console.drawString(centerX - 8, centerY + 1, "High Score: " + std::to_string(highScore), BRIGHT_CYAN);
     
-    if (Utils::isNewHighScore(score)) {
-        console.drawString(centerX - 8, centerY + 3, "NEW HIGH SCORE!", BRIGHT_YELLOW);
-        setState(HIGH_SCORE_ENTRY);
-        return;
+    if (!telemetryRecorded) {
+        recordTelemetry();
+    }
+    
+    // A watched bot's games stay off the leaderboard
+    if (!scoreRecorded && score > 0 && !autopilot) {
+        if (score > leaderboard.getTopScore()) {
+            console.drawString(centerX - 8, centerY + 3, "NEW HIGH SCORE!", BRIGHT_YELLOW);
+            setState(HIGH_SCORE_ENTRY);
+            return;
+        }
+        recordScore();
+    }
+    if (scoreRecorded) {
+        console.drawString(centerX - 8, centerY + 2, "You ranked #" + std::to_string(scoreRank) + " of " +
+                           std::to_string(leaderboard.getCount()), BRIGHT_GREEN);
     }
     
     console.drawString(centerX - 8, centerY + 4, "Press ENTER to play again", WHITE);
@@ -350,8 +748,7 @@ void Game::showHighScoreEntry() {
     playerName = Utils::sanitizePlayerName(name);
     
     // Save high score
-    HighScore newScore(playerName, score, Utils::getCurrentDate());
-    Utils::saveHighScore(newScore);
+    recordScore();
     
     console.hideCursor();
     setState(GAME_OVER);
@@ -365,18 +762,31 @@ void Game::showHighScores() {
     
     console.drawString(centerX - 6, centerY - 2, "HIGH SCORES", BRIGHT_GREEN);
     
-    std::vector<HighScore> scores = Utils::loadHighScores();
+    std::vector<HighScore> scores = leaderboard.getTop(10);
     
     if (scores.empty()) {
         console.drawString(centerX - 8, centerY, "No high scores yet!", WHITE);
     } else {
-        for (size_t i = 0; i < std::min(scores.size(), size_t(10)); i++) {
+        for (size_t i = 0; i < scores.size(); i++) {
             std::string line = std::to_string(i + 1) + ". " + scores[i].playerName + " - " + std::to_string(scores[i].score);
             console.drawString(centerX - 8, centerY + static_cast<int>(i), line, WHITE);
         }
+        
+        // Personal and daily summary
+        HighScore best;
+        std::string name = playerName.empty() ? "Player" : playerName;
+        if (leaderboard.getPersonalBest(name, best)) {
+            console.drawString(centerX - 8, centerY + 10, name + " best: " + std::to_string(best.score) + " (#" +
+                               std::to_string(leaderboard.getRank(best.score)) + " of " +
+                               std::to_string(leaderboard.getCount()) + ", " +
+                               std::to_string(leaderboard.getHistory(name).size()) + " games)", BRIGHT_CYAN);
+        }
+        std::string today = Utils::getCurrentDate();
+        console.drawString(centerX - 8, centerY + 11, "Games today: " +
+                           std::to_string(leaderboard.getByDateRange(today, today).size()), BRIGHT_CYAN);
     }
     
-    console.drawString(centerX - 10, centerY + 12, "Press ENTER to go back", BRIGHT_YELLOW);
+    console.drawString(centerX - 10, centerY + 13, "Press ENTER to go back", BRIGHT_YELLOW);
     
     // Fix: Wait for ENTER key and return to menu
     while (state == MENU) {
@@ -392,19 +802,64 @@ void Game::showHighScores() {
 }
 
 
+void Game::recordScore() {
+    HighScore newScore(playerName.empty() ? "Player" : playerName, score, Utils::getCurrentDate());
+    scoreStore.submit(newScore);
+    scoreRank = leaderboard.add(newScore);
+    scoreRecorded = true;
+}
+
+void Game::recordTelemetry() {
+    telemetryRecorded = true;
+    if (telemetryFile.empty()) {
+        return;
+    }
+    if (!telemetry.isOpen() && !telemetry.open(telemetryFile)) {
+        telemetryFile.clear(); // Reported once; the game goes on without it
+        return;
+    }
+
+    TelemetryRow row;
+    row.seed = gameSeed;
+    row.time = static_cast<int64_t>(std::time(nullptr));
+    row.ticks = static_cast<uint32_t>(tickCount);
+    row.length = static_cast<uint32_t>(simulation.getSnake().getLength());
+    row.score = static_cast<uint32_t>(score);
+    row.foodEaten = gameFood;
+    row.inputs = gameInputs;
+    row.meanTickNanos = tickCount > 0 ? static_cast<uint32_t>(gameTickNanos / static_cast<int64_t>(tickCount)) : 0;
+    row.difficulty = static_cast<uint8_t>(difficulty);
+    row.mode = static_cast<uint8_t>(simulation.getMode());
+    row.cause = static_cast<uint8_t>(gameCause);
+    row.controller = static_cast<uint8_t>(TelemetryLog::findController(autopilot ? autopilot->getName() : ""));
+    telemetry.append(row);
+}
+
 void Game::initializeGame() {
     resetGame();
     setDifficulty(difficulty);
-    
-    // Place initial food
-    food.generate(gameWidth, gameHeight, snake);
 }
 
 void Game::resetGame() {
     score = 0;
+    scoreRecorded = false;
+    scoreRank = 0;
     level = 1;
-    snake.reset(gameWidth / 2, gameHeight / 2);
-    food.reset();
+    boostTicks = 0;
+    tickCount = 0;
+    publishedTick = 0;
+    gameFood = 0;
+    gameInputs = 0;
+    gameCause = DEATH_NONE;
+    gameTickNanos = 0;
+    telemetryRecorded = false;
+    
+    // A fresh seed per game, kept for the telemetry row
+    gameSeed = static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+    simulation.seed(gameSeed);
+    
+    // Re-center the snake and place initial food
+    simulation.reset();
     console.clearScreen();
 }
 
@@ -414,43 +869,80 @@ void Game::setupGameArea() {
     // We'll rely on the default console size for now
 }
 
-void Game::drawBorder() {
-    console.drawBox(0, 0, borderWidth, borderHeight, '#', BRIGHT_WHITE);
+void Game::drawScore(int value) {
+    char text[HUD_TEXT_SIZE];
+    std::snprintf(text, sizeof(text), "Score: %d", value);
+    console.drawString(borderWidth + 2, 2, text, BRIGHT_YELLOW);
+    drawnScore = value;
 }
 
-void Game::drawScore() {
-    console.setCursorPosition(borderWidth + 2, 2);
-    console.drawString(borderWidth + 2, 2, "Score: " + std::to_string(score), BRIGHT_YELLOW);
+void Game::drawGameInfo(int levelValue, int highScoreValue) {
+    char text[HUD_TEXT_SIZE];
+    std::snprintf(text, sizeof(text), "Level: %d", levelValue);
+    console.drawString(borderWidth + 2, 4, text, BRIGHT_CYAN);
+    std::snprintf(text, sizeof(text), "High Score: %d", highScoreValue);
+    console.drawString(borderWidth + 2, 5, text, BRIGHT_MAGENTA);
+    drawnLevel = levelValue;
+    drawnHighScore = highScoreValue;
 }
 
-void Game::drawGameInfo() {
-    console.setCursorPosition(borderWidth + 2, 4);
-    console.drawString(borderWidth + 2, 4, "Level: " + std::to_string(level), BRIGHT_CYAN);
-    console.drawString(borderWidth + 2, 5, "High Score: " + std::to_string(highScore), BRIGHT_MAGENTA);
+void Game::drawSpeed(int tickRate, bool turboOn) {
+    char text[HUD_TEXT_SIZE];
+    std::snprintf(text, sizeof(text), "Speed: %d ticks/s%s", tickRate, turboOn ? " TURBO" : "");
+    drawPanelRow(SPEED_ROW, text, turboOn ? BRIGHT_YELLOW : CYAN);
+    drawnTickRate = tickRate;
+    drawnTurbo = turboOn;
 }
 
-void Game::clearGameArea() {
-    // Fill the inner game area with spaces
-    for (int y = 1; y < gameHeight + 1; y++) {
-        for (int x = 1; x < gameWidth + 1; x++) {
-            console.drawChar(x, y, ' ', BLACK);
-        }
-    }
+void Game::drawTrapped(bool trapped) {
+    drawPanelRow(TRAPPED_ROW, trapped ? "TRAPPED! Not enough room" : "", BRIGHT_RED);
+    drawnTrapped = trapped;
 }
 
-void Game::checkFoodCollision() {
-    if (food.checkCollision(snake.getHead().x, snake.getHead().y)) {
-        increaseScore(food.getPoints());
-        snake.grow();
-        console.playBeep(400, 50);
-        food.generate(gameWidth, gameHeight, snake);
+void Game::drawLatency() {
+    char lines[LATENCY_ROWS][HUD_TEXT_SIZE] = {};
+    if (showLatency) {
+        std::snprintf(lines[0], HUD_TEXT_SIZE, "Key to screen ms (%llu)",
+                      static_cast<unsigned long long>(keyToFlush.getCount()));
+        std::snprintf(lines[1], HUD_TEXT_SIZE, "p50 %.1f  p95 %.1f",
+                      keyToFlush.getPercentile(0.50) / 1000.0, keyToFlush.getPercentile(0.95) / 1000.0);
+        std::snprintf(lines[2], HUD_TEXT_SIZE, "p99 %.1f  max %.1f",
+                      keyToFlush.getPercentile(0.99) / 1000.0, keyToFlush.getMax() / 1000.0);
+        std::snprintf(lines[3], HUD_TEXT_SIZE, "tick wait p50 %.1f", keyToTick.getPercentile(0.50) / 1000.0);
+        std::snprintf(lines[4], HUD_TEXT_SIZE, "output    p50 %.1f", tickToFlush.getPercentile(0.50) / 1000.0);
+    }
+    for (int i = 0; i < LATENCY_ROWS; i++) {
+        drawPanelRow(LATENCY_ROW + i, lines[i], BRIGHT_BLACK);
     }
+    drawnLatencyCount = keyToFlush.getCount();
 }
 
-void Game::checkGameOver() {
-    if (snake.checkWallCollision(gameWidth, gameHeight) || snake.checkSelfCollision()) {
-        setState(GAME_OVER);
+void Game::drawPanelRow(int row, const char* text, int color) {
+    // Padded so shorter text erases longer, and cut to the panel width
+    char padded[HUD_TEXT_SIZE];
+    std::snprintf(padded, sizeof(padded), "%-*.*s", static_cast<int>(LATENCY_WIDTH), static_cast<int>(LATENCY_WIDTH),
+                  text);
+    console.drawString(borderWidth + 2, row, padded, color);
+}
+
+void Game::logLatency() {
+    if (keyToFlush.getCount() == 0) {
+        return;
+    }
+    
+    std::string report = std::to_string(keyToFlush.getCount()) + " turns, ms: key to screen " + keyToFlush.summary() +
+                         "; key to tick " + keyToTick.summary() + "; tick to screen " + tickToFlush.summary();
+    Utils::logInfo("Input latency over " + report);
+    if (!latencyLogFile.empty()) {
+        std::ofstream log(latencyLogFile, std::ios::app);
+        log << Utils::getCurrentDate() << " " << Utils::getCurrentTime() << " " << Simulation::getModeName(getGameMode())
+            << " " << getDifficultyName() << ": " << report << "\n";
     }
+    
+    // cleanup() also runs from the destructor; report once
+    keyToTick.clear();
+    tickToFlush.clear();
+    keyToFlush.clear();
 }
 
 void Game::increaseScore(int points) {
@@ -470,17 +962,16 @@ void Game::increaseLevel() {
 
 void Game::setDifficulty(Difficulty diff) {
     difficulty = diff;
-    switch (difficulty) {
-        case EASY:
-            frameDelay = 8;
-            break;
-        case NORMAL:
-            frameDelay = 6;
-            break;
-        case HARD:
-            frameDelay = 4;
-            break;
+    tickInterval = simulation.getTickInterval(difficulty, level);
+}
+
+int Game::getTickInterval() const {
+    // Speed items halve the interval for a while
+    int interval = boostTicks > 0 ? tickInterval / 2 : tickInterval;
+    if (turbo.load()) {
+        interval /= TURBO_FACTOR;
     }
+    return std::max(interval, 1);
 }
 
 std::string Game::getDifficultyName() const {
@@ -522,6 +1013,26 @@ Difficulty Game::getDifficulty() const {
     return difficulty;
 }
 
+void Game::setGameMode(GameMode mode) {
+    simulation.setMode(mode);
+    setDifficulty(difficulty); // Speed curve depends on the rule set
+}
+
+GameMode Game::getGameMode() const {
+    return simulation.getMode();
+}
+
+bool Game::selectLevel(const std::string& levelName) {
+    if (levelName.empty()) {
+        simulation.clearLevel();
+        return true;
+    }
+    
+    // Prefer the compiled form, fall back to the authoring text
+    std::string basePath = Utils::getResourcePath("levels/" + levelName);
+    return simulation.loadLevel(basePath + ".lvl") || simulation.loadLevel(basePath + ".txt");
+}
+
 void Game::setPlayerName(const std::string& name) {
     playerName = name;
 }
@@ -1,9 +1,26 @@
 #pragma once
-#include "snake.h"
-#include "food.h"
+#include "simulation.h"
+#include "renderer.h"
 #include "console.h"
 #include "utils.h"
+#include "sound.h"
+#include "recording.h"
+#include "leaderboard.h"
+#include "score_store.h"
+#include "frame_snapshot.h"
+#include "triple_buffer.h"
+#include "latency_histogram.h"
+#include "flood_fill.h"
+#include "bot.h"
+#include "spectator_feed.h"
+#include "telemetry_log.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 
 enum GameState {
     MENU,
@@ -14,17 +31,11 @@ enum GameState {
     EXIT
 };
 
-enum Difficulty {
-    EASY,
-    NORMAL,
-    HARD
-};
-
 class Game {
 private:
     Console console;
-    Snake snake;
-    Food food;
+    SoundSystem sound;
+    FrameRecorder recorder;
     GameState state;
     Difficulty difficulty;
     
@@ -38,28 +49,103 @@ private:
     int borderWidth;
     int borderHeight;
     
+    // World state and active rule set
+    Simulation simulation;
+    Renderer renderer;
+    
+    // HUD values last drawn, so the side panel is only redrawn when they change
+    int drawnScore;
+    int drawnLevel;
+    int drawnHighScore;
+    int drawnTickRate;
+    bool drawnTurbo;
+    bool drawnTrapped;
+    
+    // Room the head can still reach, for the trapped warning (simulation thread)
+    FloodFill trapFill;
+    
     // Timing
-    int frameDelay;
-    int frameCounter;
-    bool frameReady;
+    int tickInterval; // Microseconds per tick on the speed curve at this level
+    int boostTicks;   // Remaining ticks of a speed item boost
+    uint64_t tickCount;
+    uint64_t publishedTick; // Last tick handed to the renderer
+    std::atomic<bool> turbo; // TURBO_FACTOR times the tick rate, toggled with T
+    
+    // Plays instead of the arrow keys when watching a bot (simulation thread)
+    std::unique_ptr<Bot> autopilot;
+    
+    // Every published frame also goes to shared memory for local viewers
+    SpectatorFeed spectatorFeed;
+    
+    // While playing, the simulation thread owns the world, score and sound and
+    // publishes a snapshot per tick, or per display frame when ticks come
+    // faster than that; the main thread owns the console and renderer and
+    // only ever reads published snapshots
+    static const int DISPLAY_RATE = 60; // Snapshots per second at most
+    static const int TURBO_FACTOR = 10;
+    TripleBuffer<FrameSnapshot> frames;
+    std::thread simulationThread;
+    std::mutex simulationMutex;
+    std::condition_variable simulationWake;
+    bool simulationRunning;            // Guarded by simulationMutex
+    std::atomic<uint64_t> pendingInput; // Last direction key and when it was read, 0 if none
+    
+    // Input-to-photon latency: the simulation thread stamps each turn it
+    // applies, the main thread closes the sample once the frame is flushed
+    uint32_t turnCount;
+    int64_t turnKeyTime;
+    int64_t turnTickTime;
+    uint32_t measuredTurns;
+    LatencyHistogram keyToTick;
+    LatencyHistogram tickToFlush;
+    LatencyHistogram keyToFlush;
+    bool showLatency;
+    uint64_t drawnLatencyCount;
+    std::string latencyLogFile;
     
     // Player info
     std::string playerName;
     
+    // High score table and where the last finished game landed in it
+    Leaderboard leaderboard;
+    ScoreStore scoreStore;
+    bool scoreRecorded;
+    int scoreRank;
+    
+    // Every finished game also appends a telemetry row. The simulation
+    // thread keeps the per-game counts while playing.
+    TelemetryLog telemetry;
+    std::string telemetryFile; // Opened on the first finished game; empty once it failed
+    uint64_t gameSeed;
+    uint32_t gameFood;
+    uint32_t gameInputs;
+    DeathCause gameCause;
+    int64_t gameTickNanos;
+    bool telemetryRecorded;
+    
     // Game loop
     void gameLoop();
-    void update();
-    void render();
+    void simulationLoop();
+    bool update(); // One tick; false once the snake has died (publishes nothing)
+    void publishFrame(bool alive);
+    bool isTrapped();
+    void render(const FrameSnapshot& frame);
+    void measureLatency(const FrameSnapshot& frame);
     void handleInput();
-    void processCollisions();
+    void processCollisions(const StepResult& result);
     
     // Menu system
     void showMainMenu();
+    void drawMainMenu();
     void showDifficultyMenu();
+    void showModeMenu();
+    void showLevelMenu();
     void showPauseMenu();
     void showGameOverMenu();
     void showHighScoreEntry();
     void showHighScores();
+    void recordScore();
+    void recordTelemetry();
     
     // Game initialization
     void initializeGame();
@@ -68,19 +154,20 @@ private:
     
     // Difficulty management
     void setDifficulty(Difficulty diff);
-    int getFrameDelay() const;
+    int getTickInterval() const; // Microseconds, with speed boost and turbo
     std::string getDifficultyName() const;
     
     // UI rendering
-    void drawBorder();
-    void drawScore();
-    void drawGameInfo();
+    void drawScore(int value);
+    void drawGameInfo(int levelValue, int highScoreValue);
+    void drawSpeed(int tickRate, bool turboOn);
+    void drawTrapped(bool trapped);
+    void drawLatency();
+    void drawPanelRow(int row, const char* text, int color); // Side panel row at the latency panel width
+    void logLatency();
     void drawInstructions();
-    void clearGameArea();
     
     // Game logic
-    void checkFoodCollision();
-    void checkGameOver();
     void increaseScore(int points);
     void increaseLevel();
     
@@ -90,9 +177,23 @@ public:
     
     // Main game functions
     bool initialize();
+    bool startRecording(const std::string& filename);
+    void setLatencyLog(const std::string& filename);
+    bool setAutopilot(const std::string& botName, const BotSettings& settings); // Watch a bot play; false as Bot::create, or if it does not fit the board
+    bool setSpectatorFeed(const std::string& feedName);
+    bool setTheme(const std::string& themeName); // Board look; false if unknown
+    void setTelemetryLog(const std::string& filename);
     void run();
     void cleanup();
     
+    // Plays one frame per tick through the whole play path (ticks, frame
+    // publishing, board and HUD drawing, screen encoding) on an offscreen
+    // console, starting a new game after every death, and returns the heap
+    // allocations made after warm-up. The bot stands in for the player, so
+    // its thinking is left out; without one the snake runs straight.
+    uint64_t checkAllocations(Bot* bot, long long ticks, long long warmupTicks, long long& checkedTicks,
+                              long long& games);
+    
     // Game state management
     void setState(GameState newState);
     GameState getState() const;
@@ -102,6 +203,9 @@ public:
     int getHighScore() const;
     int getLevel() const;
     Difficulty getDifficulty() const;
+    void setGameMode(GameMode mode);
+    GameMode getGameMode() const;
+    bool selectLevel(const std::string& levelName);
     
     // Player management
     void setPlayerName(const std::string& name);
@@ -0,0 +1,238 @@
+#include "glyph_table.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+    // What a glyph shows, for picking its colour from a theme palette
+    enum Role {
+        ROLE_EMPTY,
+        ROLE_BORDER,
+        ROLE_WALL,
+        ROLE_PORTAL,
+        ROLE_HEAD,
+        ROLE_BODY,
+        ROLE_FOOD,
+        ROLE_ITEM_NORMAL,
+        ROLE_ITEM_BONUS,
+        ROLE_ITEM_SHRINK,
+        ROLE_ITEM_SPEED,
+        ROLE_COUNT
+    };
+
+    Role roleOf(int glyph) {
+        if (glyph == GLYPH_EMPTY) {
+            return ROLE_EMPTY;
+        }
+        if (glyph <= GLYPH_BORDER_BOTTOM_RIGHT) {
+            return ROLE_BORDER;
+        }
+        if (glyph == GLYPH_WALL) {
+            return ROLE_WALL;
+        }
+        if (glyph == GLYPH_PORTAL) {
+            return ROLE_PORTAL;
+        }
+        if (glyph < GLYPH_BODY) {
+            return ROLE_HEAD;
+        }
+        if (glyph < GLYPH_FOOD) {
+            return ROLE_BODY;
+        }
+        return static_cast<Role>(ROLE_FOOD + (glyph - GLYPH_FOOD));
+    }
+
+    // Foreground per role; every theme keeps the terminal's own background
+    // so empty cells never need painting
+    const int UNICODE_COLORS[ROLE_COUNT] = {
+        GlyphTable::COLOR_DEFAULT, 15, 7, 13, 10, 10, 9, 1, 11, 14, 13
+    };
+    const int XTERM_COLORS[ROLE_COUNT] = {
+        GlyphTable::COLOR_DEFAULT, 250, 240, 171, 118, 34, 196, 160, 220, 51, 201
+    };
+    const int TRUECOLOR_COLORS[ROLE_COUNT] = {
+        GlyphTable::COLOR_DEFAULT,
+        GlyphTable::rgb(200, 200, 210), GlyphTable::rgb(110, 110, 120), GlyphTable::rgb(190, 90, 255),
+        GlyphTable::rgb(170, 255, 90), GlyphTable::rgb(60, 190, 80), GlyphTable::rgb(255, 70, 70),
+        GlyphTable::rgb(230, 60, 60), GlyphTable::rgb(255, 215, 0), GlyphTable::rgb(0, 220, 230),
+        GlyphTable::rgb(255, 80, 220)
+    };
+
+    // Heavy lines for the snake, indexed by its CellLink bits; a segment
+    // joins at most two neighbours, so the other masks never show up
+    const char* const BODY_TEXT[16] = {
+        "\xE2\x96\xA0",                 // ■ links not known
+        "\xE2\x95\xB9",                 // ╹ tail, up
+        "\xE2\x95\xBB",                 // ╻ tail, down
+        "\xE2\x94\x83",                 // ┃
+        "\xE2\x95\xB8",                 // ╸ tail, left
+        "\xE2\x94\x9B",                 // ┛
+        "\xE2\x94\x93",                 // ┓
+        "\xE2\x96\xA0",
+        "\xE2\x95\xBA",                 // ╺ tail, right
+        "\xE2\x94\x97",                 // ┗
+        "\xE2\x94\x8F",                 // ┏
+        "\xE2\x96\xA0",
+        "\xE2\x94\x81",                 // ━
+        "\xE2\x96\xA0",
+        "\xE2\x96\xA0",
+        "\xE2\x96\xA0"
+    };
+
+    void unicodeTexts(const char* texts[GLYPH_COUNT]) {
+        texts[GLYPH_EMPTY] = " ";
+        texts[GLYPH_BORDER_HORIZONTAL] = "\xE2\x95\x90";   // ═
+        texts[GLYPH_BORDER_VERTICAL] = "\xE2\x95\x91";     // ║
+        texts[GLYPH_BORDER_TOP_LEFT] = "\xE2\x95\x94";     // ╔
+        texts[GLYPH_BORDER_TOP_RIGHT] = "\xE2\x95\x97";    // ╗
+        texts[GLYPH_BORDER_BOTTOM_LEFT] = "\xE2\x95\x9A";  // ╚
+        texts[GLYPH_BORDER_BOTTOM_RIGHT] = "\xE2\x95\x9D"; // ╝
+        texts[GLYPH_WALL] = "\xE2\x96\x93";                // ▓
+        texts[GLYPH_PORTAL] = "\xE2\x97\x8B";              // ○
+        texts[GLYPH_HEAD] = "\xE2\x97\x86";                // ◆
+        texts[GLYPH_HEAD_UP] = "\xE2\x96\xB2";             // ▲
+        texts[GLYPH_HEAD_DOWN] = "\xE2\x96\xBC";           // ▼
+        texts[GLYPH_HEAD_LEFT] = "\xE2\x97\x80";           // ◀
+        texts[GLYPH_HEAD_RIGHT] = "\xE2\x96\xB6";          // ▶
+        for (int mask = 0; mask < 16; mask++) {
+            texts[GLYPH_BODY + mask] = BODY_TEXT[mask];
+        }
+        texts[GLYPH_FOOD] = "\xE2\x97\x8F";                // ●
+        texts[GLYPH_ITEM_NORMAL] = "\xE2\x80\xA2";         // •
+        texts[GLYPH_ITEM_BONUS] = "\xE2\x97\x86";          // ◆
+        texts[GLYPH_ITEM_SHRINK] = "\xE2\x96\xBD";         // ▽
+        texts[GLYPH_ITEM_SPEED] = "\xC2\xBB";              // »
+    }
+
+    bool containsNoCase(const char* text, const char* part) {
+        std::string haystack = text;
+        std::transform(haystack.begin(), haystack.end(), haystack.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return haystack.find(part) != std::string::npos;
+    }
+}
+
+GlyphTable::GlyphTable() : plain(true), entries() {
+    load("classic");
+}
+
+bool GlyphTable::load(const std::string& themeName) {
+    if (themeName == "auto") {
+        return load(detectTheme());
+    }
+
+    const int* palette = nullptr;
+    if (themeName == "unicode") {
+        palette = UNICODE_COLORS;
+    } else if (themeName == "256") {
+        palette = XTERM_COLORS;
+    } else if (themeName == "truecolor") {
+        palette = TRUECOLOR_COLORS;
+    } else if (themeName != "classic") {
+        return false;
+    }
+
+    name = themeName;
+    plain = palette == nullptr;
+    bytes.clear();
+    for (Entry& entry : entries) {
+        entry = Entry{ 0, 0, 0, 0 };
+    }
+    if (plain) {
+        return true;
+    }
+
+    const char* texts[GLYPH_COUNT];
+    int foreground[GLYPH_COUNT];
+    int background[GLYPH_COUNT];
+    unicodeTexts(texts);
+    for (int glyph = 0; glyph < GLYPH_COUNT; glyph++) {
+        foreground[glyph] = palette[roleOf(glyph)];
+        background[glyph] = COLOR_DEFAULT;
+    }
+    encode(texts, foreground, background);
+    return true;
+}
+
+void GlyphTable::encode(const char* const* texts, const int* foreground, const int* background) {
+    std::vector<std::string> styles;
+    std::string sgr;
+    for (int glyph = 0; glyph < GLYPH_COUNT; glyph++) {
+        // Reset first, so no attribute or colour of the previous cell leaks in
+        sgr = "\033[0";
+        appendColor(sgr, foreground[glyph], false);
+        appendColor(sgr, background[glyph], true);
+        sgr += 'm';
+
+        size_t style = std::find(styles.begin(), styles.end(), sgr) - styles.begin();
+        if (style == styles.size()) {
+            styles.push_back(sgr);
+        }
+
+        Entry& entry = entries[glyph];
+        entry.offset = static_cast<uint32_t>(bytes.size());
+        entry.styleLength = static_cast<uint16_t>(sgr.size());
+        entry.textLength = static_cast<uint16_t>(std::char_traits<char>::length(texts[glyph]));
+        entry.style = static_cast<int>(style);
+        bytes += sgr;
+        bytes += texts[glyph];
+    }
+}
+
+void GlyphTable::appendColor(std::string& sgr, int color, bool background) {
+    char code[24];
+    if (color == COLOR_DEFAULT) {
+        return;
+    }
+    if (color & 0x1000000) {
+        std::snprintf(code, sizeof(code), ";%d;2;%d;%d;%d", background ? 48 : 38,
+                      (color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF);
+    } else if (color < 8) {
+        std::snprintf(code, sizeof(code), ";%d", (background ? 40 : 30) + color);
+    } else if (color < 16) {
+        std::snprintf(code, sizeof(code), ";%d", (background ? 100 : 90) + color - 8);
+    } else {
+        std::snprintf(code, sizeof(code), ";%d;5;%d", background ? 48 : 38, color);
+    }
+    sgr += code;
+}
+
+std::string GlyphTable::detectTheme() {
+#ifdef _WIN32
+    // The console API writes single-byte characters
+    return "classic";
+#else
+    // The first locale variable that is set decides, as for setlocale()
+    const char* locale = nullptr;
+    const char* variables[] = { "LC_ALL", "LC_CTYPE", "LANG" };
+    for (const char* variable : variables) {
+        const char* value = std::getenv(variable);
+        if (value && *value) {
+            locale = value;
+            break;
+        }
+    }
+    if (!locale || !(containsNoCase(locale, "utf-8") || containsNoCase(locale, "utf8"))) {
+        return "classic";
+    }
+
+    const char* colorTerm = std::getenv("COLORTERM");
+    if (colorTerm && (containsNoCase(colorTerm, "truecolor") || containsNoCase(colorTerm, "24bit"))) {
+        return "truecolor";
+    }
+    const char* term = std::getenv("TERM");
+    if (term && containsNoCase(term, "256color")) {
+        return "256";
+    }
+    return "unicode";
+#endif
+}
+
+const std::string& GlyphTable::getName() const {
+    return name;
+}
+
+bool GlyphTable::isPlain() const {
+    return plain;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Everything the board is drawn with. Snake bodies are GLYPH_BODY plus the
+// CellLink bits of the neighbours a segment joins (0 when not known).
+enum Glyph {
+    GLYPH_EMPTY,
+    GLYPH_BORDER_HORIZONTAL,
+    GLYPH_BORDER_VERTICAL,
+    GLYPH_BORDER_TOP_LEFT,
+    GLYPH_BORDER_TOP_RIGHT,
+    GLYPH_BORDER_BOTTOM_LEFT,
+    GLYPH_BORDER_BOTTOM_RIGHT,
+    GLYPH_WALL,
+    GLYPH_PORTAL,
+    GLYPH_HEAD,         // Heading not known
+    GLYPH_HEAD_UP,      // Heads in Direction order
+    GLYPH_HEAD_DOWN,
+    GLYPH_HEAD_LEFT,
+    GLYPH_HEAD_RIGHT,
+    GLYPH_BODY,
+    GLYPH_FOOD = GLYPH_BODY + 16,
+    GLYPH_ITEM_NORMAL,  // Extra items, in FoodKind order
+    GLYPH_ITEM_BONUS,
+    GLYPH_ITEM_SHRINK,
+    GLYPH_ITEM_SPEED,
+    GLYPH_COUNT
+};
+
+// How a theme looks, pre-encoded. Loading a theme turns every glyph into
+// the exact bytes a terminal needs - the SGR sequence for its colours
+// followed by its UTF-8 text - stored back to back in one buffer, so
+// drawing a cell is one append of a ready span and never formats a number
+// or encodes a character. Glyphs whose colours match share a style id, so
+// the encoder can leave the SGR part out when the terminal already has it.
+//
+// The "classic" theme has no table: callers pass every glyph's classic look
+// (one ASCII character and a console colour) along with it, which is also
+// what the Windows console and recordings show.
+class GlyphTable {
+public:
+    // Theme colours: 0-255 are xterm palette indices (0-15 the basic
+    // colours in ANSI order), rgb() gives 24-bit colours
+    static const int COLOR_DEFAULT = -1; // Whatever the terminal uses
+    static int rgb(int red, int green, int blue) { return 0x1000000 | (red << 16) | (green << 8) | blue; }
+
+private:
+    struct Entry {
+        uint32_t offset;     // Into bytes: SGR, then text
+        uint16_t styleLength;
+        uint16_t textLength;
+        int style;
+    };
+
+    std::string name;
+    bool plain;
+    std::string bytes;
+    Entry entries[GLYPH_COUNT];
+
+    void encode(const char* const* texts, const int* foreground, const int* background);
+    static void appendColor(std::string& sgr, int color, bool background);
+
+public:
+    GlyphTable();
+
+    // "classic", "unicode", "256", "truecolor", or "auto" to pick from the
+    // terminal's locale and colour support. False for an unknown name.
+    bool load(const std::string& themeName);
+    static std::string detectTheme();
+    const std::string& getName() const;
+
+    // Classic themes are drawn as ordinary characters
+    bool isPlain() const;
+
+    // SGR and text together, or the text alone when the style is already set
+    const char* getSequence(int glyph) const { return bytes.data() + entries[glyph].offset; }
+    size_t getSequenceLength(int glyph) const { return entries[glyph].styleLength + entries[glyph].textLength; }
+    const char* getText(int glyph) const { return getSequence(glyph) + entries[glyph].styleLength; }
+    size_t getTextLength(int glyph) const { return entries[glyph].textLength; }
+    int getStyle(int glyph) const { return entries[glyph].style; }
+};
@@ -0,0 +1,828 @@
+#include "headless.h"
+#include "allocation_counter.h"
+#include "ansi_encoder.h"
+#include "bot.h"
+#include "flood_fill.h"
+#include "game.h"
+#include "heatmap.h"
+#include "renderer.h"
+#include "simulation.h"
+#include "telemetry_log.h"
+#include "utils.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+namespace {
+    // Ticks before --alloc-check starts counting (first-use growth of reusable buffers)
+    const long long ALLOC_WARMUP_TICKS = 1000;
+
+    const char* deathCauseName(DeathCause cause) {
+        switch (cause) {
+            case DEATH_WALL:
+                return "wall";
+            case DEATH_SELF:
+                return "self";
+            case DEATH_OBSTACLE:
+                return "obstacle";
+            case DEATH_NONE:
+                break;
+        }
+        return "none";
+    }
+
+    // Text for inside a JSON string: quotes, backslashes and control
+    // characters escaped (level names and paths come from the user)
+    std::string jsonEscape(const std::string& text) {
+        std::string escaped;
+        escaped.reserve(text.size());
+        for (char c : text) {
+            switch (c) {
+                case '"':
+                    escaped += "\\\"";
+                    break;
+                case '\\':
+                    escaped += "\\\\";
+                    break;
+                case '\n':
+                    escaped += "\\n";
+                    break;
+                case '\r':
+                    escaped += "\\r";
+                    break;
+                case '\t':
+                    escaped += "\\t";
+                    break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        char code[8];
+                        std::snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned char>(c));
+                        escaped += code;
+                    } else {
+                        escaped += c;
+                    }
+                    break;
+            }
+        }
+        return escaped;
+    }
+
+    BotSettings botSettings(const HeadlessOptions& options) {
+        BotSettings settings;
+        settings.timeBudgetMs = options.thinkMs;
+        settings.threads = options.threads;
+        settings.policyFile = options.policy;
+        return settings;
+    }
+
+    // A bot that cannot play the board is an error before the first tick,
+    // not a game of fallback moves
+    bool checkBoardFit(const Bot* bot, const HeadlessOptions& options) {
+        if (bot && !bot->fitsBoard(options.width, options.height)) {
+            Utils::logError("Policy " + options.policy + " was not trained for a " + std::to_string(options.width) +
+                            "x" + std::to_string(options.height) + " board");
+            return false;
+        }
+        return true;
+    }
+
+    // Measures terminal output for a run: every tick's cell changes are
+    // encoded with AnsiEncoder and with the naive one-sequence-per-cell form.
+    // The encoder flushes each frame with one write; the naive form is counted
+    // as one write per cell, as unbuffered drawing would issue.
+    class AnsiBenchmark {
+    private:
+        AnsiEncoder encoder;
+        std::vector<AnsiCell> cells;
+        std::string naive;
+        FrameSnapshot frame; // What the game's render thread would receive
+        long long frames;
+        long long encodedBytes;
+        long long naiveBytes;
+        long long encodedWrites;
+        long long naiveWrites;
+        size_t fullEncodedBytes;
+        size_t fullNaiveBytes;
+
+        void encodeFrame() {
+            for (const AnsiCell& cell : cells) {
+                encoder.put(cell.x, cell.y, cell.ch, cell.color);
+            }
+            encoder.commit();
+            AnsiEncoder::encodeNaive(cells, naive);
+
+            frames++;
+            encodedBytes += static_cast<long long>(encoder.getBuffer().size());
+            naiveBytes += static_cast<long long>(naive.size());
+            encodedWrites += encoder.getBuffer().empty() ? 0 : 1;
+            naiveWrites += static_cast<long long>(cells.size());
+        }
+
+    public:
+        AnsiBenchmark()
+            : frames(0), encodedBytes(0), naiveBytes(0), encodedWrites(0), naiveWrites(0),
+              fullEncodedBytes(0), fullNaiveBytes(0) {
+        }
+
+        // Clear screen and paint the whole board, as after a menu
+        void fullFrame(const Simulation& sim) {
+            int width = sim.getWidth();
+            int height = sim.getHeight();
+            const Level& level = sim.getLevel();
+
+            encoder.resize(width + 2, height + 2);
+            encoder.clearBuffer();
+            encoder.setColor(WHITE);
+            encoder.clearScreen();
+            naive = "\033[2J\033[H";
+
+            cells.clear();
+            for (int y = 0; y < height + 2; ++y) {
+                for (int x = 0; x < width + 2; ++x) {
+                    AnsiCell cell = { x, y, ' ', BLACK };
+                    if (x == 0 || y == 0 || x == width + 1 || y == height + 1) {
+                        cell.ch = '#';
+                        cell.color = BRIGHT_WHITE;
+                    } else if (level.isWall(x, y)) {
+                        cell.ch = '#';
+                        cell.color = WHITE;
+                    } else if (level.isPortal(x, y)) {
+                        cell.ch = '%';
+                        cell.color = BRIGHT_MAGENTA;
+                    }
+                    cells.push_back(cell);
+                }
+            }
+            for (const FoodItem& item : sim.getItems().getItems()) {
+                if (item.active) {
+                    AnsiCell cell = { item.position.x, item.position.y,
+                                      FoodField::getSymbol(item.kind), FoodField::getColor(item.kind) };
+                    cells.push_back(cell);
+                }
+            }
+            Position food = sim.getFood().getPosition();
+            AnsiCell foodCell = { food.x, food.y, sim.getFood().getSymbol(), sim.getFood().getColor() };
+            cells.push_back(foodCell);
+            bool head = true;
+            sim.getSnake().forEachSegment([&](const Position& segment) {
+                AnsiCell cell = { segment.x, segment.y, head ? 'O' : 'o', BRIGHT_GREEN };
+                cells.push_back(cell);
+                head = false;
+            });
+
+            encodeFrame();
+            fullEncodedBytes = encoder.getBuffer().size();
+            fullNaiveBytes = naive.size();
+        }
+
+        // Only the cells the last tick changed
+        void changeFrame(const Simulation& sim) {
+            encoder.clearBuffer();
+            naive.clear();
+            cells.clear();
+            sim.captureFrame(frame);
+            for (const CellChange& change : frame.changes) {
+                AnsiCell cell = { change.x, change.y, ' ', BLACK };
+                Renderer::getCellGlyph(frame, sim.getLevel(), change, cell.ch, cell.color);
+                cells.push_back(cell);
+            }
+            encodeFrame();
+        }
+
+        void print(std::ostream& out) const {
+            double count = frames > 0 ? static_cast<double>(frames) : 1.0;
+            out << ", \"ansi_frames\": " << frames
+                << ", \"ansi_full_frame_bytes\": " << fullEncodedBytes
+                << ", \"naive_full_frame_bytes\": " << fullNaiveBytes
+                << ", \"ansi_bytes_per_frame\": " << encodedBytes / count
+                << ", \"naive_bytes_per_frame\": " << naiveBytes / count
+                << ", \"ansi_writes_per_frame\": " << encodedWrites / count
+                << ", \"naive_writes_per_frame\": " << naiveWrites / count;
+        }
+    };
+
+    // Times the per-tick space analysis a bot or the trapped warning would
+    // run: room reachable from the head, and how the free cells split up.
+    class FloodBenchmark {
+    private:
+        FloodFill flood;
+        long long ticks;
+        double micros;
+        int room;
+        int components;
+        int largest;
+        int minRoom;
+
+    public:
+        FloodBenchmark() : ticks(0), micros(0.0), room(0), components(0), largest(0), minRoom(-1) {}
+
+        void measure(const Simulation& sim) {
+            auto start = std::chrono::steady_clock::now();
+            room = flood.reachable(sim, sim.getSnake().getHead());
+            components = flood.countComponents(flood.getOpen(), sim.getMode() == MODE_WRAP, largest);
+            micros += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+            ticks++;
+            if (minRoom < 0 || room < minRoom) {
+                minRoom = room;
+            }
+        }
+
+        void print(std::ostream& out) const {
+            out << ", \"flood_ticks\": " << ticks
+                << ", \"flood_us_per_tick\": " << (ticks > 0 ? micros / ticks : 0.0)
+                << ", \"reachable\": " << room
+                << ", \"min_reachable\": " << minRoom
+                << ", \"components\": " << components
+                << ", \"largest_component\": " << largest;
+        }
+    };
+
+    // Per-tick world hashes as "tick hash" lines (tick 0 is the start
+    // position). Written for later runs to check against, and/or compared
+    // with a stream from an earlier run, stopping at the first difference.
+    class HashStream {
+    private:
+        std::ofstream out;
+        std::ifstream expected;
+        bool checking;
+        long long checked;
+        long long divergedAt;
+        std::string expectedHash;
+        uint64_t lastHash;
+
+        // Into a caller's buffer, so recording a tick does not allocate
+        static const int TEXT_SIZE = 24;
+        static void format(uint64_t hash, char* text) {
+            std::snprintf(text, TEXT_SIZE, "%016llx", static_cast<unsigned long long>(hash));
+        }
+
+    public:
+        HashStream() : checking(false), checked(0), divergedAt(-1), lastHash(0) {}
+
+        bool open(const std::string& outFile, const std::string& checkFile) {
+            if (!outFile.empty()) {
+                out.open(outFile, std::ios::trunc);
+                if (!out) {
+                    Utils::logError("Could not write hash stream " + outFile);
+                    return false;
+                }
+            }
+            if (!checkFile.empty()) {
+                expected.open(checkFile);
+                if (!expected) {
+                    Utils::logError("Could not read hash stream " + checkFile);
+                    return false;
+                }
+                checking = true;
+            }
+            return true;
+        }
+
+        // False once this run has left the expected stream
+        bool record(long long tick, uint64_t hash) {
+            lastHash = hash;
+            char text[TEXT_SIZE];
+            format(hash, text);
+            if (out.is_open()) {
+                out << tick << ' ' << text << '\n';
+            }
+            if (!checking) {
+                return true;
+            }
+
+            long long expectedTick = -1;
+            if (!(expected >> expectedTick >> expectedHash)) {
+                expectedHash = "end";
+            }
+            if (expectedTick != tick || expectedHash != text) {
+                divergedAt = tick;
+                return false;
+            }
+            checked++;
+            return true;
+        }
+
+        bool hasDiverged() const {
+            return divergedAt >= 0;
+        }
+
+        void print(std::ostream& stream) const {
+            char text[TEXT_SIZE];
+            format(lastHash, text);
+            stream << ", \"hash\": \"" << text << "\"";
+            if (checking) {
+                stream << ", \"hash_checked_ticks\": " << checked
+                       << ", \"hash_diverged_at\": " << divergedAt;
+                if (hasDiverged()) {
+                    stream << ", \"hash_expected\": \"" << expectedHash << "\"";
+                }
+            }
+        }
+    };
+
+    // Telemetry for a finished headless game; headless games have no difficulty
+    TelemetryRow telemetryRow(const HeadlessOptions& options, uint64_t seed, long long ticks, int length,
+                              long long score, long long foodEaten, long long inputs, DeathCause cause,
+                              double seconds) {
+        TelemetryRow row;
+        row.seed = seed;
+        row.time = static_cast<int64_t>(std::time(nullptr));
+        row.ticks = static_cast<uint32_t>(ticks);
+        row.length = static_cast<uint32_t>(length);
+        row.score = static_cast<uint32_t>(score);
+        row.foodEaten = static_cast<uint32_t>(foodEaten);
+        row.inputs = static_cast<uint32_t>(inputs);
+        row.meanTickNanos = ticks > 0 ? static_cast<uint32_t>(seconds * 1e9 / ticks) : 0;
+        row.difficulty = TELEMETRY_NO_DIFFICULTY;
+        row.mode = static_cast<uint8_t>(options.mode);
+        row.cause = static_cast<uint8_t>(cause);
+        row.controller = static_cast<uint8_t>(TelemetryLog::findController(options.bot));
+        return row;
+    }
+
+    // One thread's share of a heatmap run: its own world and bot, and totals
+    // that only it writes to until the threads are joined
+    struct HeatmapWorker {
+        long long games;
+        long long ticks;
+        long long score;
+        long long length;       // Sum of final lengths
+        long long causes[4];    // Games per DeathCause; DEATH_NONE = tick limit reached
+
+        HeatmapWorker() : games(0), ticks(0), score(0), length(0), causes() {}
+
+        // Telemetry rows go to a log shared by all workers, one locked append per game
+        void play(const HeadlessOptions& options, std::atomic<long long>& nextGame, Heatmap& heatmap,
+                  TelemetryLog& telemetry, std::mutex& telemetryMutex) {
+            Simulation simulation(options.width, options.height);
+            simulation.setMode(options.mode);
+            simulation.setExtraFood(options.items, options.itemInterval);
+            if (!options.level.empty()) {
+                simulation.loadLevel(options.level); // Already checked by the caller
+            }
+            heatmap.resize(options.width, options.height);
+            std::unique_ptr<Bot> bot = Bot::create(options.bot, botSettings(options));
+
+            long long game;
+            while ((game = nextGame.fetch_add(1)) < options.games) {
+                simulation.seed(options.seed + static_cast<uint64_t>(game));
+                simulation.reset();
+
+                StepResult result = { true, false, 0, FOOD_NORMAL, DEATH_NONE };
+                long long gameTicks = 0;
+                long long gameScore = 0;
+                long long gameFood = 0;
+                long long gameInputs = 0;
+                auto startTime = std::chrono::steady_clock::now();
+                while (gameTicks < options.ticks) {
+                    if (bot && simulation.getSnake().setDirection(bot->chooseDirection(simulation))) {
+                        gameInputs++;
+                    }
+                    result = simulation.step();
+                    gameTicks++;
+                    if (!result.alive) {
+                        break;
+                    }
+                    heatmap.visit(simulation.getSnake().getHead());
+                    if (result.ateFood) {
+                        gameScore += result.points;
+                        gameFood++;
+                    }
+                }
+
+                if (!result.alive) {
+                    // A head that left the board died on the cell it came from
+                    const Snake& snake = simulation.getSnake();
+                    Position head = snake.getHead();
+                    bool onBoard = head.x >= 1 && head.x <= options.width && head.y >= 1 && head.y <= options.height;
+                    heatmap.death(onBoard ? head : snake.getSegment(1));
+                }
+                DeathCause cause = result.alive ? DEATH_NONE : result.cause;
+                causes[cause]++;
+                games++;
+                ticks += gameTicks;
+                score += gameScore;
+                length += simulation.getSnake().getLength();
+
+                if (telemetry.isOpen()) {
+                    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+                    TelemetryRow row = telemetryRow(options, options.seed + static_cast<uint64_t>(game), gameTicks,
+                                                    simulation.getSnake().getLength(), gameScore, gameFood,
+                                                    gameInputs, cause, seconds);
+                    std::lock_guard<std::mutex> lock(telemetryMutex);
+                    telemetry.append(row);
+                }
+            }
+        }
+
+        void add(const HeatmapWorker& other) {
+            games += other.games;
+            ticks += other.ticks;
+            score += other.score;
+            length += other.length;
+            for (int cause = 0; cause < 4; cause++) {
+                causes[cause] += other.causes[cause];
+            }
+        }
+    };
+}
+
+HeadlessOptions::HeadlessOptions()
+    : seed(1), ticks(100000), bot("astar"), width(40), height(20), mode(MODE_CLASSIC),
+      items(0), itemInterval(60), thinkMs(10), threads(0), ansiBench(false), floodBench(false),
+      allocCheck(false), games(1000), workers(0) {
+}
+
+bool HeadlessRunner::isHeadless(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--headless") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HeadlessRunner::parseArguments(int argc, char* argv[], HeadlessOptions& options, std::string& error) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--headless") {
+            continue;
+        }
+        if (arg == "--ansi-bench") {
+            options.ansiBench = true;
+            continue;
+        }
+        if (arg == "--flood-bench") {
+            options.floodBench = true;
+            continue;
+        }
+        if (arg == "--alloc-check") {
+            options.allocCheck = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            error = "Missing value for " + arg;
+            return false;
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--seed") {
+            // All 64 bits: a truncated seed would replay some other seed's game
+            char* end = nullptr;
+            errno = 0;
+            unsigned long long seed = std::strtoull(value.c_str(), &end, 10);
+            if (value.empty() || value[0] == '-' || *end != '\0' || errno == ERANGE) {
+                error = "Seed must be a number from 0 to 18446744073709551615, got " + value;
+                return false;
+            }
+            options.seed = static_cast<uint64_t>(seed);
+        } else if (arg == "--ticks") {
+            options.ticks = std::atoll(value.c_str());
+        } else if (arg == "--bot") {
+            options.bot = value;
+        } else if (arg == "--board") {
+            if (std::sscanf(value.c_str(), "%dx%d", &options.width, &options.height) != 2) {
+                error = "Board must be WIDTHxHEIGHT, got " + value;
+                return false;
+            }
+        } else if (arg == "--mode") {
+            if (!Simulation::findMode(value, options.mode)) {
+                error = "Unknown mode " + value;
+                return false;
+            }
+        } else if (arg == "--level") {
+            options.level = value;
+        } else if (arg == "--items") {
+            options.items = std::atoi(value.c_str());
+        } else if (arg == "--item-interval") {
+            options.itemInterval = std::atoi(value.c_str());
+        } else if (arg == "--think-ms") {
+            options.thinkMs = std::atoi(value.c_str());
+        } else if (arg == "--threads") {
+            options.threads = std::atoi(value.c_str());
+        } else if (arg == "--policy") {
+            options.policy = value;
+        } else if (arg == "--hash-out") {
+            options.hashOut = value;
+        } else if (arg == "--hash-check") {
+            options.hashCheck = value;
+        } else if (arg == "--heatmap") {
+            options.heatmap = value;
+        } else if (arg == "--games") {
+            options.games = std::atoll(value.c_str());
+        } else if (arg == "--workers") {
+            options.workers = std::atoi(value.c_str());
+        } else if (arg == "--telemetry") {
+            options.telemetry = value;
+        } else {
+            error = "Unknown option " + arg;
+            return false;
+        }
+    }
+
+    if (options.width < Simulation::MIN_WIDTH || options.height < 2) {
+        error = "Board is too small (at least " + std::to_string(Simulation::MIN_WIDTH) + "x2)";
+        return false;
+    }
+    if (options.items < 0 || options.itemInterval < 1) {
+        error = "Items must be >= 0 and item interval >= 1";
+        return false;
+    }
+    if (options.ticks <= 0) {
+        error = "Ticks must be positive";
+        return false;
+    }
+    if (options.thinkMs < 1 || options.threads < 0) {
+        error = "Think time must be >= 1 ms and threads >= 0";
+        return false;
+    }
+    if (options.games < 1 || options.workers < 0) {
+        error = "Games must be >= 1 and workers >= 0";
+        return false;
+    }
+    if (!options.heatmap.empty() && (options.ansiBench || options.floodBench || options.allocCheck ||
+                                     !options.hashOut.empty() || !options.hashCheck.empty())) {
+        error = "--heatmap runs many games and cannot be combined with benchmarks or hash streams";
+        return false;
+    }
+    if (options.bot != "none" && !Bot::create(options.bot, botSettings(options))) {
+        error = options.bot == "mlp" ? "Could not load policy " + options.policy : "Unknown bot " + options.bot;
+        return false;
+    }
+    return true;
+}
+
+void HeadlessRunner::printUsage() {
+    std::cerr << "Usage: ConsoleSnakeCpp --headless [--seed S] [--ticks N] [--bot none|greedy|astar|mcts|mlp]" << std::endl;
+    std::cerr << "                       [--board WxH] [--mode classic|wrap|marathon] [--level FILE]" << std::endl;
+    std::cerr << "                       [--items N] [--item-interval T] [--ansi-bench] [--flood-bench]" << std::endl;
+    std::cerr << "                       [--think-ms MS] [--threads N]  (mcts bot)" << std::endl;
+    std::cerr << "                       [--policy FILE]  (mlp bot)" << std::endl;
+    std::cerr << "                       [--hash-out FILE] [--hash-check FILE] [--alloc-check]" << std::endl;
+    std::cerr << "                       [--heatmap PREFIX] [--games N] [--workers N]  (many games, --ticks per game)" << std::endl;
+    std::cerr << "                       [--telemetry FILE]  (append a row per game)" << std::endl;
+}
+
+int HeadlessRunner::run(const HeadlessOptions& options) {
+    if (!options.heatmap.empty()) {
+        return runHeatmap(options);
+    }
+
+    Simulation simulation(options.width, options.height);
+    simulation.seed(options.seed);
+    simulation.setMode(options.mode);
+    simulation.setExtraFood(options.items, options.itemInterval);
+    if (!options.level.empty() && !simulation.loadLevel(options.level)) {
+        Utils::logError("Could not load level " + options.level + " for a " +
+                        std::to_string(options.width) + "x" + std::to_string(options.height) + " board");
+        return 1;
+    }
+    simulation.setChangeTracking(options.ansiBench);
+    simulation.reset();
+
+    AnsiBenchmark benchmark;
+    if (options.ansiBench) {
+        benchmark.fullFrame(simulation);
+    }
+
+    FloodBenchmark floodBenchmark;
+    HashStream hashes;
+    if (!hashes.open(options.hashOut, options.hashCheck)) {
+        return 1;
+    }
+    hashes.record(0, simulation.getHash());
+
+    TelemetryLog telemetry;
+    if (!options.telemetry.empty() && !telemetry.open(options.telemetry)) {
+        return 1;
+    }
+
+    std::unique_ptr<Bot> bot = Bot::create(options.bot, botSettings(options));
+    if (!checkBoardFit(bot.get(), options)) {
+        return 1;
+    }
+
+    long long ticks = 0;
+    long long score = 0;
+    long long foodEaten = 0;
+    long long inputs = 0;
+    DeathCause cause = DEATH_NONE;
+    
+    // The bot stands in for the player, so its thinking is left out of the count
+    long long allocCheckedTicks = 0;
+    long long allocGames = 1;
+    uint64_t steadyAllocations = 0;
+
+    auto startTime = std::chrono::steady_clock::now();
+    while (ticks < options.ticks && !hashes.hasDiverged()) {
+        if (bot && simulation.getSnake().setDirection(bot->chooseDirection(simulation))) {
+            inputs++;
+        }
+
+        uint64_t allocationsBefore = AllocationCounter::getCount();
+        StepResult result = simulation.step();
+        ticks++;
+        hashes.record(ticks, simulation.getHash());
+
+        if (options.ansiBench) {
+            benchmark.changeFrame(simulation);
+            simulation.clearChanges();
+        }
+
+        if (options.floodBench && result.alive) {
+            floodBenchmark.measure(simulation);
+        }
+
+        if (result.ateFood) {
+            score += result.points;
+            foodEaten++;
+        }
+        // An allocation check plays game after game, so it covers every tick
+        // asked for and the resets in between
+        bool restart = !result.alive && options.allocCheck;
+        if (restart) {
+            simulation.reset();
+            allocGames++;
+            if (options.ansiBench) {
+                benchmark.fullFrame(simulation);
+            }
+        }
+        if (options.allocCheck && ticks > ALLOC_WARMUP_TICKS) {
+            steadyAllocations += AllocationCounter::getCount() - allocationsBefore;
+            allocCheckedTicks++;
+        }
+        if (!result.alive && !restart) {
+            cause = result.cause;
+            break;
+        }
+    }
+    auto endTime = std::chrono::steady_clock::now();
+
+    // The same again through the interactive game: frame publishing, board
+    // and HUD drawing and screen encoding, on the game's own board
+    long long renderCheckedTicks = 0;
+    long long renderGames = 0;
+    uint64_t renderAllocations = 0;
+    if (options.allocCheck) {
+        std::unique_ptr<Bot> player = Bot::create(options.bot, botSettings(options));
+        Game game;
+        renderAllocations = game.checkAllocations(player.get(), options.ticks, ALLOC_WARMUP_TICKS,
+                                                  renderCheckedTicks, renderGames);
+    }
+
+    double seconds = std::chrono::duration<double>(endTime - startTime).count();
+    double ticksPerSecond = seconds > 0.0 ? ticks / seconds : 0.0;
+    if (telemetry.isOpen()) {
+        telemetry.append(telemetryRow(options, options.seed, ticks, simulation.getSnake().getLength(), score,
+                                      foodEaten, inputs, cause, seconds));
+        if (!telemetry.flush()) {
+            return 1;
+        }
+    }
+
+    std::cout << "{"
+              << "\"seed\": " << options.seed
+              << ", \"board\": \"" << options.width << "x" << options.height << "\""
+              << ", \"mode\": \"" << Simulation::getModeName(options.mode) << "\""
+              << ", \"level\": \"" << jsonEscape(simulation.getLevel().getName()) << "\""
+              << ", \"bot\": \"" << options.bot << "\""
+              << ", \"score\": " << score
+              << ", \"length\": " << simulation.getSnake().getLength()
+              << ", \"food_eaten\": " << foodEaten
+              << ", \"items_on_board\": " << simulation.getItems().getCount()
+              << ", \"ticks\": " << ticks
+              << ", \"death_cause\": \"" << (cause != DEATH_NONE ? deathCauseName(cause) : hashes.hasDiverged() ? "hash_diverged" : "tick_limit") << "\""
+              << ", \"elapsed_sec\": " << seconds
+              << ", \"ticks_per_sec\": " << static_cast<long long>(ticksPerSecond)
+              << ", \"peak_rss_kb\": " << Utils::getPeakMemoryKB();
+    if (options.ansiBench) {
+        benchmark.print(std::cout);
+    }
+    if (options.floodBench) {
+        floodBenchmark.print(std::cout);
+    }
+    hashes.print(std::cout);
+    if (options.allocCheck) {
+        std::cout << ", \"alloc_games\": " << allocGames
+                  << ", \"alloc_checked_ticks\": " << allocCheckedTicks
+                  << ", \"steady_allocations\": " << steadyAllocations
+                  << ", \"render_games\": " << renderGames
+                  << ", \"render_checked_ticks\": " << renderCheckedTicks
+                  << ", \"render_allocations\": " << renderAllocations;
+    }
+    std::cout << "}" << std::endl;
+    if (hashes.hasDiverged()) {
+        return 2;
+    }
+    return steadyAllocations > 0 || renderAllocations > 0 ? 3 : 0;
+}
+
+int HeadlessRunner::runHeatmap(const HeadlessOptions& options) {
+    // Set up once here to report a bad level before any thread starts
+    Simulation reference(options.width, options.height);
+    reference.setMode(options.mode);
+    if (!options.level.empty() && !reference.loadLevel(options.level)) {
+        Utils::logError("Could not load level " + options.level + " for a " +
+                        std::to_string(options.width) + "x" + std::to_string(options.height) + " board");
+        return 1;
+    }
+    if (!checkBoardFit(Bot::create(options.bot, botSettings(options)).get(), options)) {
+        return 1;
+    }
+
+    int workerCount = options.workers > 0 ? options.workers : static_cast<int>(std::thread::hardware_concurrency());
+    workerCount = static_cast<int>(std::max(1LL, std::min(static_cast<long long>(workerCount), options.games)));
+    std::vector<HeatmapWorker> workers(workerCount);
+    std::vector<Heatmap> heatmaps(workerCount);
+
+    TelemetryLog telemetry;
+    std::mutex telemetryMutex;
+    if (!options.telemetry.empty() && !telemetry.open(options.telemetry)) {
+        return 1;
+    }
+
+    // Workers take the next unplayed seed until none are left
+    std::atomic<long long> nextGame(0);
+    auto startTime = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < workerCount; i++) {
+        HeatmapWorker* worker = &workers[i];
+        Heatmap* heatmap = &heatmaps[i];
+        threads.emplace_back([&options, &nextGame, &telemetry, &telemetryMutex, worker, heatmap] {
+            worker->play(options, nextGame, *heatmap, telemetry, telemetryMutex);
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    auto playedTime = std::chrono::steady_clock::now();
+
+    HeatmapWorker total;
+    for (const HeatmapWorker& worker : workers) {
+        total.add(worker);
+    }
+    Heatmap heatmap;
+    Heatmap::reduce(heatmaps, heatmap, workerCount);
+    auto endTime = std::chrono::steady_clock::now();
+    if (!heatmap.save(options.heatmap, reference.getLevel()) || (telemetry.isOpen() && !telemetry.flush())) {
+        return 1;
+    }
+
+    double seconds = std::chrono::duration<double>(playedTime - startTime).count();
+    double reduceMs = std::chrono::duration<double, std::milli>(endTime - playedTime).count();
+    double games = static_cast<double>(total.games);
+    HeatmapSummary summary = heatmap.summarize(reference.getLevel());
+    std::cout << "{"
+              << "\"seed\": " << options.seed
+              << ", \"board\": \"" << options.width << "x" << options.height << "\""
+              << ", \"mode\": \"" << Simulation::getModeName(options.mode) << "\""
+              << ", \"level\": \"" << jsonEscape(reference.getLevel().getName()) << "\""
+              << ", \"bot\": \"" << options.bot << "\""
+              << ", \"games\": " << total.games
+              << ", \"workers\": " << workerCount
+              << ", \"ticks\": " << total.ticks
+              << ", \"mean_ticks\": " << total.ticks / games
+              << ", \"mean_score\": " << total.score / games
+              << ", \"mean_length\": " << total.length / games;
+    for (int cause = DEATH_WALL; cause <= DEATH_OBSTACLE; cause++) {
+        std::cout << ", \"deaths_" << deathCauseName(static_cast<DeathCause>(cause)) << "\": " << total.causes[cause];
+    }
+    std::cout << ", \"tick_limit\": " << total.causes[DEATH_NONE]
+              << ", \"open_cells\": " << summary.openCells
+              << ", \"visited_cells\": " << summary.visitedCells
+              << ", \"hottest_cell\": \"" << summary.hottest.x << "," << summary.hottest.y << "\""
+              << ", \"hottest_visits\": " << summary.hottestVisits
+              << ", \"deadliest_cell\": \"" << summary.deadliest.x << "," << summary.deadliest.y << "\""
+              << ", \"deadliest_deaths\": " << summary.deadliestDeaths
+              << ", \"top_tenth_share\": " << summary.topTenthShare
+              << ", \"elapsed_sec\": " << seconds
+              << ", \"ticks_per_sec\": " << static_cast<long long>(seconds > 0.0 ? total.ticks / seconds : 0.0)
+              << ", \"reduce_ms\": " << reduceMs
+              << ", \"heatmap\": \"" << jsonEscape(options.heatmap) << "\"";
+    if (telemetry.isOpen()) {
+        std::cout << ", \"telemetry_rows\": " << telemetry.getWrittenRows();
+    }
+    std::cout
+              << "}" << std::endl;
+    return 0;
+}
+
+int HeadlessRunner::main(int argc, char* argv[]) {
+    HeadlessOptions options;
+    std::string error;
+    if (!parseArguments(argc, argv, options, error)) {
+        Utils::logError(error);
+        printUsage();
+        return 2;
+    }
+    return run(options);
+}
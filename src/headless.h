@@ -0,0 +1,43 @@
+#pragma once
+#include "rules.h"
+#include <cstdint>
+#include <string>
+
+// Settings for a non-interactive run
+struct HeadlessOptions {
+    uint64_t seed;
+    long long ticks;     // Upper bound on simulated ticks
+    std::string bot;     // "none", "greedy", "astar", "mcts" or "mlp"
+    int width;
+    int height;
+    GameMode mode;
+    std::string level;   // Optional level file (.txt or .lvl)
+    int items;           // Max extra food items on the board
+    int itemInterval;    // Ticks between extra item spawns
+    int thinkMs;         // Search bots: thinking time per move
+    int threads;         // Search bots: thread count, 0 = all hardware threads
+    std::string policy;  // Weights file for the mlp bot
+    std::string hashOut;   // Write the per-tick world hash stream here
+    std::string hashCheck; // Compare against this stream, stop at the first difference
+    bool ansiBench;      // Also encode every tick's screen changes and report output cost
+    bool floodBench;     // Also time reachable-room and free-region analysis every tick
+    bool allocCheck;     // Count heap allocations made by ticks and frames after warm-up; fail if there are any
+    std::string heatmap; // Play many games and write visit/death heatmaps under this prefix
+    long long games;     // Heatmap runs: games to play, seeds seed .. seed + games - 1
+    int workers;         // Heatmap runs: game threads, 0 = all hardware threads
+    std::string telemetry; // Append a telemetry row per game to this file
+
+    HeadlessOptions();
+};
+
+// Runs the simulation with no console and prints a JSON summary to stdout.
+// Used for scripted runs and performance regression checks.
+class HeadlessRunner {
+public:
+    static bool isHeadless(int argc, char* argv[]);
+    static bool parseArguments(int argc, char* argv[], HeadlessOptions& options, std::string& error);
+    static void printUsage();
+    static int run(const HeadlessOptions& options);
+    static int runHeatmap(const HeadlessOptions& options);
+    static int main(int argc, char* argv[]);
+};
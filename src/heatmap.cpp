@@ -0,0 +1,146 @@
+#include "heatmap.h"
+#include "utils.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+Heatmap::Heatmap() : width(0), height(0) {
+}
+
+void Heatmap::resize(int newWidth, int newHeight) {
+    width = newWidth;
+    height = newHeight;
+    visits.assign(static_cast<size_t>(width) * height, 0);
+    deaths.assign(visits.size(), 0);
+}
+
+void Heatmap::death(const Position& cell) {
+    ++deaths[static_cast<size_t>(cell.y - 1) * width + (cell.x - 1)];
+}
+
+void Heatmap::reduce(const std::vector<Heatmap>& parts, Heatmap& total, int threads) {
+    if (parts.empty()) {
+        return;
+    }
+    total.resize(parts.front().width, parts.front().height);
+
+    // Slices are disjoint, so the threads never write the same counter
+    auto sumSlice = [&parts, &total](size_t begin, size_t end) {
+        for (const Heatmap& part : parts) {
+            for (size_t cell = begin; cell < end; ++cell) {
+                total.visits[cell] += part.visits[cell];
+                total.deaths[cell] += part.deaths[cell];
+            }
+        }
+    };
+    size_t cells = total.visits.size();
+    size_t sliceCount = std::max<size_t>(1, std::min(static_cast<size_t>(std::max(threads, 1)), cells));
+    std::vector<std::thread> workers;
+    for (size_t slice = 1; slice < sliceCount; ++slice) {
+        workers.emplace_back(sumSlice, cells * slice / sliceCount, cells * (slice + 1) / sliceCount);
+    }
+    sumSlice(0, cells / sliceCount);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+uint64_t Heatmap::getVisits(int x, int y) const {
+    return visits[static_cast<size_t>(y - 1) * width + (x - 1)];
+}
+
+uint64_t Heatmap::getDeaths(int x, int y) const {
+    return deaths[static_cast<size_t>(y - 1) * width + (x - 1)];
+}
+
+int Heatmap::getWidth() const {
+    return width;
+}
+
+int Heatmap::getHeight() const {
+    return height;
+}
+
+HeatmapSummary Heatmap::summarize(const Level& level) const {
+    HeatmapSummary summary = { 0, 0, 0, 0, Position(), 0, Position(), 0, 0.0 };
+    std::vector<uint64_t> openVisits;
+    for (int y = 1; y <= height; y++) {
+        for (int x = 1; x <= width; x++) {
+            uint64_t cellVisits = getVisits(x, y);
+            uint64_t cellDeaths = getDeaths(x, y);
+            summary.totalVisits += cellVisits;
+            summary.totalDeaths += cellDeaths;
+            if (cellVisits > summary.hottestVisits) {
+                summary.hottest = Position(x, y);
+                summary.hottestVisits = cellVisits;
+            }
+            if (cellDeaths > summary.deadliestDeaths) {
+                summary.deadliest = Position(x, y);
+                summary.deadliestDeaths = cellDeaths;
+            }
+            if (!level.isWall(x, y)) {
+                openVisits.push_back(cellVisits);
+                if (cellVisits > 0) {
+                    summary.visitedCells++;
+                }
+            }
+        }
+    }
+    summary.openCells = static_cast<int>(openVisits.size());
+
+    // How concentrated play is: 0.1 would be perfectly even
+    size_t tenth = std::max<size_t>(1, openVisits.size() / 10);
+    if (summary.totalVisits > 0 && tenth <= openVisits.size()) {
+        std::nth_element(openVisits.begin(), openVisits.begin() + (tenth - 1), openVisits.end(),
+                         std::greater<uint64_t>());
+        uint64_t busiest = 0;
+        for (size_t i = 0; i < tenth; i++) {
+            busiest += openVisits[i];
+        }
+        summary.topTenthShare = static_cast<double>(busiest) / summary.totalVisits;
+    }
+    return summary;
+}
+
+bool Heatmap::writePgm(const std::string& filename, int width, int height, const std::vector<uint64_t>& counts) {
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        Utils::logError("Could not write heatmap " + filename);
+        return false;
+    }
+
+    // Counts span orders of magnitude, so brightness follows their logarithm
+    uint64_t highest = counts.empty() ? 0 : *std::max_element(counts.begin(), counts.end());
+    double scale = highest > 0 ? 255.0 / std::log1p(static_cast<double>(highest)) : 0.0;
+    std::vector<unsigned char> pixels(counts.size());
+    for (size_t i = 0; i < counts.size(); i++) {
+        pixels[i] = static_cast<unsigned char>(std::lround(std::log1p(static_cast<double>(counts[i])) * scale));
+    }
+    file << "P5\n" << width << " " << height << "\n255\n";
+    file.write(reinterpret_cast<const char*>(pixels.data()), static_cast<std::streamsize>(pixels.size()));
+    return static_cast<bool>(file);
+}
+
+bool Heatmap::save(const std::string& prefix, const Level& level) const {
+    if (!writePgm(prefix + "-visits.pgm", width, height, visits) ||
+        !writePgm(prefix + "-deaths.pgm", width, height, deaths)) {
+        return false;
+    }
+
+    std::string csvFile = prefix + ".csv";
+    std::ofstream csv(csvFile, std::ios::trunc);
+    if (!csv) {
+        Utils::logError("Could not write heatmap " + csvFile);
+        return false;
+    }
+    csv << "x,y,wall,visits,deaths\n";
+    for (int y = 1; y <= height; y++) {
+        for (int x = 1; x <= width; x++) {
+            csv << x << ',' << y << ',' << (level.isWall(x, y) ? 1 : 0) << ','
+                << getVisits(x, y) << ',' << getDeaths(x, y) << '\n';
+        }
+    }
+    return static_cast<bool>(csv);
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "level.h"
+#include "snake.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Headline numbers of a heatmap, for run summaries
+struct HeatmapSummary {
+    uint64_t totalVisits;
+    uint64_t totalDeaths;
+    int openCells;        // Cells that are not walls
+    int visitedCells;     // Open cells a head has been on
+    Position hottest;     // Most visited cell
+    uint64_t hottestVisits;
+    Position deadliest;   // Cell the most games ended on
+    uint64_t deadliestDeaths;
+    double topTenthShare; // Share of all visits on the busiest tenth of the open cells
+};
+
+// Where snake heads spend their ticks and where games end, counted per
+// play-area cell. Each worker thread fills a Heatmap of its own, so counting
+// is a plain increment with nothing shared; reduce() adds the parts up once
+// at the end. Sums do not depend on which worker played which game.
+class Heatmap {
+private:
+    int width;
+    int height;
+    std::vector<uint64_t> visits; // Ticks a head was on each cell, row-major from (1, 1)
+    std::vector<uint64_t> deaths; // Games that ended on each cell
+
+    static bool writePgm(const std::string& filename, int width, int height, const std::vector<uint64_t>& counts);
+
+public:
+    Heatmap();
+
+    // Sets the board size and clears all counts
+    void resize(int newWidth, int newHeight);
+
+    // Once per tick for the cell the head is on (must be on the board)
+    void visit(const Position& head) {
+        ++visits[static_cast<size_t>(head.y - 1) * width + (head.x - 1)];
+    }
+    void death(const Position& cell);
+
+    // Adds up equally sized parts into total, each of `threads` threads
+    // summing its own slice of the grid across all parts
+    static void reduce(const std::vector<Heatmap>& parts, Heatmap& total, int threads);
+
+    uint64_t getVisits(int x, int y) const;
+    uint64_t getDeaths(int x, int y) const;
+    int getWidth() const;
+    int getHeight() const;
+    HeatmapSummary summarize(const Level& level) const;
+
+    // Writes <prefix>-visits.pgm and <prefix>-deaths.pgm (log-scaled 8-bit
+    // greyscale, one pixel per cell) and <prefix>.csv with the raw counts
+    bool save(const std::string& prefix, const Level& level) const;
+};
@@ -0,0 +1,108 @@
+#include "latency_histogram.h"
+#include <chrono>
+#include <cstdio>
+
+LatencyHistogram::LatencyHistogram() {
+    clear();
+}
+
+void LatencyHistogram::clear() {
+    for (uint32_t& bucket : counts) {
+        bucket = 0;
+    }
+    count = 0;
+    total = 0;
+    max = 0;
+}
+
+int LatencyHistogram::bucketFor(int64_t micros) {
+    if (micros < SUB_BUCKETS) {
+        return micros < 0 ? 0 : static_cast<int>(micros);
+    }
+    // Shift the value down until it fits the sub-bucket range; the number of
+    // shifts picks the power of two, the remaining bits the linear bucket
+    uint64_t value = static_cast<uint64_t>(micros);
+    int range = 0;
+    while (value >= 2 * SUB_BUCKETS) {
+        value >>= 1;
+        range++;
+    }
+    if (range >= RANGES) {
+        return BUCKETS - 1;
+    }
+    return (range + 1) * SUB_BUCKETS + static_cast<int>(value - SUB_BUCKETS);
+}
+
+int64_t LatencyHistogram::bucketUpperBound(int bucket) {
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+    int range = bucket / SUB_BUCKETS - 1;
+    int64_t lower = static_cast<int64_t>(SUB_BUCKETS + bucket % SUB_BUCKETS) << range;
+    return lower + (int64_t(1) << range) - 1;
+}
+
+void LatencyHistogram::record(int64_t micros) {
+    counts[bucketFor(micros)]++;
+    count++;
+    total += micros;
+    if (micros > max) {
+        max = micros;
+    }
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (int i = 0; i < BUCKETS; i++) {
+        counts[i] += other.counts[i];
+    }
+    count += other.count;
+    total += other.total;
+    if (other.max > max) {
+        max = other.max;
+    }
+}
+
+uint64_t LatencyHistogram::getCount() const {
+    return count;
+}
+
+int64_t LatencyHistogram::getMax() const {
+    return max;
+}
+
+double LatencyHistogram::getMean() const {
+    return count > 0 ? static_cast<double>(total) / static_cast<double>(count) : 0.0;
+}
+
+int64_t LatencyHistogram::getPercentile(double fraction) const {
+    if (count == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(fraction * static_cast<double>(count) + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < BUCKETS; ++bucket) {
+        seen += counts[bucket];
+        if (seen >= rank) {
+            // The bucket bound can overshoot the largest sample
+            int64_t bound = bucketUpperBound(bucket);
+            return bound < max ? bound : max;
+        }
+    }
+    return max;
+}
+
+std::string LatencyHistogram::summary() const {
+    char text[96];
+    std::snprintf(text, sizeof(text), "p50 %.1f p95 %.1f p99 %.1f max %.1f",
+                  getPercentile(0.50) / 1000.0, getPercentile(0.95) / 1000.0,
+                  getPercentile(0.99) / 1000.0, getMax() / 1000.0);
+    return text;
+}
+
+int64_t LatencyHistogram::now() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
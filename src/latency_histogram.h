@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Fixed-size log-linear histogram of durations in microseconds. Each power
+// of two is split into 16 linear buckets, so percentiles are accurate to
+// about 6% with no allocation per sample. Max and mean are exact.
+class LatencyHistogram {
+private:
+    static const int SUB_BUCKET_BITS = 4;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int RANGES = 32; // Up to 2^35 us (~9.5 hours)
+    static const int BUCKETS = (RANGES + 1) * SUB_BUCKETS;
+
+    uint32_t counts[BUCKETS];
+    uint64_t count;
+    int64_t total;
+    int64_t max;
+
+    static int bucketFor(int64_t micros);
+    static int64_t bucketUpperBound(int bucket);
+
+public:
+    LatencyHistogram();
+
+    void clear();
+    void record(int64_t micros);
+    void merge(const LatencyHistogram& other); // Adds the other histogram's samples
+
+    uint64_t getCount() const;
+    int64_t getMax() const;
+    double getMean() const;
+
+    // Smallest value at or above the given fraction (0..1) of samples
+    int64_t getPercentile(double fraction) const;
+
+    // "p50 12.1 p95 20.3 p99 31.0 max 33.2" in milliseconds
+    std::string summary() const;
+
+    // Current steady clock time in microseconds, the unit every sample uses
+    static int64_t now();
+};
@@ -0,0 +1,214 @@
+#include "leaderboard.h"
+#include <algorithm>
+
+Leaderboard::Leaderboard() : root(-1), seed(0x9E3779B9u) {
+}
+
+void Leaderboard::clear() {
+    entries.clear();
+    nodes.clear();
+    root = -1;
+    playerHistory.clear();
+    playerBest.clear();
+    byDate.clear();
+}
+
+void Leaderboard::load(const std::vector<HighScore>& scores) {
+    clear();
+    entries.reserve(scores.size());
+    nodes.reserve(scores.size());
+    for (const HighScore& score : scores) {
+        add(score);
+    }
+}
+
+uint32_t Leaderboard::nextPriority() {
+    // xorshift32; only needs to be well spread, not unpredictable
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+bool Leaderboard::ranksBefore(int a, int b) const {
+    if (entries[a].score != entries[b].score) {
+        return entries[a].score > entries[b].score;
+    }
+    return a < b; // Earlier scores keep the better rank on ties
+}
+
+void Leaderboard::update(int node) {
+    nodes[node].size = 1 + sizeOf(nodes[node].left) + sizeOf(nodes[node].right);
+}
+
+void Leaderboard::split(int node, int entry, int& left, int& right) {
+    // left gets the nodes ranking before entry, right the rest
+    if (node < 0) {
+        left = -1;
+        right = -1;
+        return;
+    }
+    if (ranksBefore(node, entry)) {
+        split(nodes[node].right, entry, nodes[node].right, right);
+        left = node;
+    } else {
+        split(nodes[node].left, entry, left, nodes[node].left);
+        right = node;
+    }
+    update(node);
+}
+
+int Leaderboard::merge(int left, int right) {
+    if (left < 0) {
+        return right;
+    }
+    if (right < 0) {
+        return left;
+    }
+    if (nodes[left].priority > nodes[right].priority) {
+        nodes[left].right = merge(nodes[left].right, right);
+        update(left);
+        return left;
+    }
+    nodes[right].left = merge(left, nodes[right].left);
+    update(right);
+    return right;
+}
+
+int Leaderboard::countBefore(int entry) const {
+    int count = 0;
+    int node = root;
+    while (node >= 0) {
+        if (ranksBefore(node, entry)) {
+            count += sizeOf(nodes[node].left) + 1;
+            node = nodes[node].right;
+        } else {
+            node = nodes[node].left;
+        }
+    }
+    return count;
+}
+
+int Leaderboard::add(const HighScore& score) {
+    int id = static_cast<int>(entries.size());
+    entries.push_back(score);
+    Node node = { nextPriority(), -1, -1, 1 };
+    nodes.push_back(node);
+
+    int left = -1;
+    int right = -1;
+    split(root, id, left, right);
+    root = merge(merge(left, id), right);
+
+    // Player history and dates stay sorted by date, ties in arrival order
+    auto byDateOrder = [this](int a, int b) { return entries[a].date < entries[b].date; };
+    std::vector<int>& history = playerHistory[score.playerName];
+    history.insert(std::upper_bound(history.begin(), history.end(), id, byDateOrder), id);
+    byDate.insert(std::upper_bound(byDate.begin(), byDate.end(), id, byDateOrder), id);
+
+    auto best = playerBest.find(score.playerName);
+    if (best == playerBest.end() || ranksBefore(id, best->second)) {
+        playerBest[score.playerName] = id;
+    }
+
+    return countBefore(id) + 1;
+}
+
+int Leaderboard::getCount() const {
+    return static_cast<int>(entries.size());
+}
+
+int Leaderboard::getTopScore() const {
+    HighScore top;
+    return getByRank(1, top) ? top.score : 0;
+}
+
+std::vector<HighScore> Leaderboard::getTop(int count) const {
+    std::vector<HighScore> top;
+    std::vector<int> path;
+    int node = root;
+
+    // In-order walk that stops after `count` entries
+    while ((node >= 0 || !path.empty()) && static_cast<int>(top.size()) < count) {
+        while (node >= 0) {
+            path.push_back(node);
+            node = nodes[node].left;
+        }
+        node = path.back();
+        path.pop_back();
+        top.push_back(entries[node]);
+        node = nodes[node].right;
+    }
+    return top;
+}
+
+bool Leaderboard::getByRank(int rank, HighScore& score) const {
+    if (rank < 1 || rank > getCount()) {
+        return false;
+    }
+    int skip = rank - 1;
+    int node = root;
+    while (node >= 0) {
+        int leftSize = sizeOf(nodes[node].left);
+        if (skip < leftSize) {
+            node = nodes[node].left;
+        } else if (skip == leftSize) {
+            score = entries[node];
+            return true;
+        } else {
+            skip -= leftSize + 1;
+            node = nodes[node].right;
+        }
+    }
+    return false;
+}
+
+int Leaderboard::getRank(int score) const {
+    // One more than the number of strictly better scores
+    int better = 0;
+    int node = root;
+    while (node >= 0) {
+        if (entries[node].score > score) {
+            better += sizeOf(nodes[node].left) + 1;
+            node = nodes[node].right;
+        } else {
+            node = nodes[node].left;
+        }
+    }
+    return better + 1;
+}
+
+bool Leaderboard::getPersonalBest(const std::string& player, HighScore& best) const {
+    auto it = playerBest.find(player);
+    if (it == playerBest.end()) {
+        return false;
+    }
+    best = entries[it->second];
+    return true;
+}
+
+std::vector<HighScore> Leaderboard::getHistory(const std::string& player) const {
+    std::vector<HighScore> history;
+    auto it = playerHistory.find(player);
+    if (it != playerHistory.end()) {
+        history.reserve(it->second.size());
+        for (int id : it->second) {
+            history.push_back(entries[id]);
+        }
+    }
+    return history;
+}
+
+std::vector<HighScore> Leaderboard::getByDateRange(const std::string& from, const std::string& to) const {
+    auto first = std::lower_bound(byDate.begin(), byDate.end(), from,
+                                  [this](int id, const std::string& date) { return entries[id].date < date; });
+    auto last = std::upper_bound(first, byDate.end(), to,
+                                 [this](const std::string& date, int id) { return date < entries[id].date; });
+
+    std::vector<HighScore> scores;
+    scores.reserve(static_cast<size_t>(last - first));
+    for (auto it = first; it != last; ++it) {
+        scores.push_back(entries[*it]);
+    }
+    return scores;
+}
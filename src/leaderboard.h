@@ -0,0 +1,60 @@
+#pragma once
+#include "utils.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// In-memory high score table. Scores live in an order-statistic treap
+// (ordered by score, ties by arrival) so rank and top-N queries take
+// O(log n); per-player and per-date indexes are built once at load and
+// kept up to date as scores are added.
+class Leaderboard {
+private:
+    struct Node {
+        uint32_t priority;
+        int left;
+        int right;
+        int size; // Nodes in this subtree
+    };
+
+    std::vector<HighScore> entries; // Entry id == node index
+    std::vector<Node> nodes;
+    int root;
+    uint32_t seed;
+
+    // Secondary indexes (entry ids)
+    std::unordered_map<std::string, std::vector<int>> playerHistory; // In date order
+    std::unordered_map<std::string, int> playerBest;
+    std::vector<int> byDate;
+
+    bool ranksBefore(int a, int b) const;
+    int sizeOf(int node) const { return node < 0 ? 0 : nodes[node].size; }
+    void update(int node);
+    void split(int node, int entry, int& left, int& right);
+    int merge(int left, int right);
+    int countBefore(int entry) const;
+    uint32_t nextPriority();
+
+public:
+    Leaderboard();
+
+    // Loading
+    void clear();
+    void load(const std::vector<HighScore>& scores);
+
+    // Adds a score and returns its 1-based rank
+    int add(const HighScore& score);
+
+    // Ranking queries
+    int getCount() const;
+    int getTopScore() const;
+    std::vector<HighScore> getTop(int count) const;
+    bool getByRank(int rank, HighScore& score) const;
+    int getRank(int score) const; // Rank a new score would take
+
+    // Player and date queries (dates are YYYY-MM-DD, ranges inclusive)
+    bool getPersonalBest(const std::string& player, HighScore& best) const;
+    std::vector<HighScore> getHistory(const std::string& player) const;
+    std::vector<HighScore> getByDateRange(const std::string& from, const std::string& to) const;
+};
@@ -0,0 +1,351 @@
+#include "level.h"
+#include "mapped_file.h"
+#include "utils.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+
+namespace {
+    const char LEVEL_MAGIC[4] = { 'S', 'N', 'K', 'L' };
+    const uint16_t LEVEL_VERSION = 1;
+
+    bool endsWith(const std::string& str, const std::string& suffix) {
+        return str.size() >= suffix.size() &&
+               str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+}
+
+Level::Level() : width(0), height(0) {
+}
+
+void Level::makeEmpty(int newWidth, int newHeight) {
+    name = "Open Field";
+    width = newWidth;
+    height = newHeight;
+    walls.resize(width, height);
+    portalCells.resize(width, height);
+    spawns.clear();
+    portals.clear();
+    bake();
+}
+
+void Level::bake() {
+    portalCells.resize(width, height);
+    for (const Portal& portal : portals) {
+        portalCells.set(portal.a.x - 1, portal.a.y - 1);
+        portalCells.set(portal.b.x - 1, portal.b.y - 1);
+    }
+
+    foodBlocked = walls;
+    foodBlocked |= portalCells;
+}
+
+bool Level::load(const std::string& filename) {
+    if (endsWith(filename, ".lvl")) {
+        return loadBinary(filename);
+    }
+    return loadText(filename);
+}
+
+// Text format:
+//   ; comment
+//   NAME <level name>
+//   SIZE <width> <height>
+//   MAP
+//   <height rows of: '#' wall, '.' or ' ' empty, 'S' spawn, 'a'-'z' portal pair>
+bool Level::loadText(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::string levelName = "Untitled";
+    int levelWidth = 0;
+    int levelHeight = 0;
+    std::string line;
+
+    // Header
+    while (std::getline(file, line)) {
+        line = Utils::trim(line);
+        if (line.empty() || line[0] == ';') {
+            continue;
+        }
+        if (line.compare(0, 5, "NAME ") == 0) {
+            levelName = Utils::trim(line.substr(5));
+        } else if (line.compare(0, 5, "SIZE ") == 0) {
+            std::vector<std::string> parts = Utils::split(Utils::trim(line.substr(5)), ' ');
+            if (parts.size() != 2) {
+                Utils::logError("Bad SIZE line in level " + filename);
+                return false;
+            }
+            levelWidth = std::atoi(parts[0].c_str());
+            levelHeight = std::atoi(parts[1].c_str());
+        } else if (line == "MAP") {
+            break;
+        } else {
+            Utils::logError("Unknown level header line: " + line);
+            return false;
+        }
+    }
+
+    if (levelWidth <= 0 || levelHeight <= 0 || levelWidth > 0xFFFF || levelHeight > 0xFFFF) {
+        Utils::logError("Level " + filename + " has no valid SIZE");
+        return false;
+    }
+
+    Bitboard levelWalls(levelWidth, levelHeight);
+    std::vector<Position> levelSpawns;
+    std::map<char, std::vector<Position>> portalEnds;
+
+    // Map rows (short rows are padded with empty cells)
+    for (int y = 0; y < levelHeight; ++y) {
+        if (!std::getline(file, line)) {
+            break;
+        }
+        for (int x = 0; x < levelWidth && x < static_cast<int>(line.size()); ++x) {
+            char cell = line[x];
+            Position pos(x + 1, y + 1);
+            if (cell == '#') {
+                levelWalls.set(x, y);
+            } else if (cell == 'S') {
+                levelSpawns.push_back(pos);
+            } else if (cell >= 'a' && cell <= 'z') {
+                portalEnds[cell].push_back(pos);
+            }
+        }
+    }
+
+    std::vector<Portal> levelPortals;
+    for (const auto& entry : portalEnds) {
+        if (entry.second.size() != 2) {
+            Utils::logError(std::string("Portal '") + entry.first + "' needs exactly two cells");
+            return false;
+        }
+        levelPortals.push_back(Portal{ entry.second[0], entry.second[1] });
+    }
+
+    Position open;
+    for (const Position& spawn : levelSpawns) {
+        if (!fitsSnake(levelWalls, levelWidth, levelHeight, spawn)) {
+            Utils::logError("Spawn " + std::to_string(spawn.x) + "," + std::to_string(spawn.y) + " in level " +
+                            filename + " needs two open cells to its left");
+            return false;
+        }
+    }
+    if (levelSpawns.empty() && !findOpenSpawn(levelWalls, levelWidth, levelHeight, Position(1, 1), open)) {
+        Utils::logError("Level " + filename + " has no room for the snake");
+        return false;
+    }
+
+    name = levelName;
+    width = levelWidth;
+    height = levelHeight;
+    walls = levelWalls;
+    spawns = levelSpawns;
+    portals = levelPortals;
+    bake();
+    return true;
+}
+
+bool Level::loadBinary(const std::string& filename) {
+    MappedFile mapped;
+    if (!mapped.open(filename) || mapped.size() < sizeof(LevelFileHeader)) {
+        return false;
+    }
+
+    LevelFileHeader header;
+    std::memcpy(&header, mapped.data(), sizeof(header));
+    if (std::memcmp(header.magic, LEVEL_MAGIC, 4) != 0 || header.version != LEVEL_VERSION) {
+        Utils::logError("Not a compiled level: " + filename);
+        return false;
+    }
+
+    size_t wallWords = static_cast<size_t>(header.wordsPerRow) * header.height;
+    size_t expected = sizeof(LevelFileHeader) + wallWords * sizeof(uint64_t) +
+                      header.spawnCount * 2 * sizeof(uint16_t) +
+                      header.portalCount * 4 * sizeof(uint16_t);
+    if (mapped.size() < expected) {
+        Utils::logError("Truncated level file: " + filename);
+        return false;
+    }
+
+    Bitboard levelWalls(header.width, header.height);
+    if (levelWalls.getWordsPerRow() != header.wordsPerRow) {
+        Utils::logError("Corrupt level file: " + filename);
+        return false;
+    }
+
+    // Wall rows are stored in bitboard layout - copy them straight in
+    const unsigned char* cursor = mapped.data() + sizeof(LevelFileHeader);
+    std::memcpy(levelWalls.data(), cursor, wallWords * sizeof(uint64_t));
+    cursor += wallWords * sizeof(uint64_t);
+
+    uint16_t values[4];
+    std::vector<Position> levelSpawns;
+    for (int i = 0; i < header.spawnCount; ++i) {
+        std::memcpy(values, cursor, 2 * sizeof(uint16_t));
+        cursor += 2 * sizeof(uint16_t);
+        levelSpawns.emplace_back(values[0], values[1]);
+    }
+
+    std::vector<Portal> levelPortals;
+    for (int i = 0; i < header.portalCount; ++i) {
+        std::memcpy(values, cursor, 4 * sizeof(uint16_t));
+        cursor += 4 * sizeof(uint16_t);
+        levelPortals.push_back(Portal{ Position(values[0], values[1]), Position(values[2], values[3]) });
+    }
+
+    // Reject coordinates that would land outside the bitboards, and spawns
+    // the starting body would not fit at
+    auto inBounds = [&header](const Position& p) {
+        return p.x >= 1 && p.x <= header.width && p.y >= 1 && p.y <= header.height;
+    };
+    for (const Portal& portal : levelPortals) {
+        if (!inBounds(portal.a) || !inBounds(portal.b)) {
+            Utils::logError("Corrupt level file: " + filename);
+            return false;
+        }
+    }
+    Position open;
+    for (const Position& spawn : levelSpawns) {
+        if (!fitsSnake(levelWalls, header.width, header.height, spawn)) {
+            Utils::logError("Corrupt level file: " + filename);
+            return false;
+        }
+    }
+    if (levelSpawns.empty() && !findOpenSpawn(levelWalls, header.width, header.height, Position(1, 1), open)) {
+        Utils::logError("Level " + filename + " has no room for the snake");
+        return false;
+    }
+
+    header.name[sizeof(header.name) - 1] = '\0';
+    name = header.name;
+    width = header.width;
+    height = header.height;
+    walls = levelWalls;
+    spawns = levelSpawns;
+    portals = levelPortals;
+    bake();
+    return true;
+}
+
+bool Level::saveBinary(const std::string& filename) const {
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    LevelFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, LEVEL_MAGIC, 4);
+    header.version = LEVEL_VERSION;
+    header.width = static_cast<uint16_t>(width);
+    header.height = static_cast<uint16_t>(height);
+    header.wordsPerRow = static_cast<uint16_t>(walls.getWordsPerRow());
+    header.spawnCount = static_cast<uint16_t>(spawns.size());
+    header.portalCount = static_cast<uint16_t>(portals.size());
+    std::strncpy(header.name, name.c_str(), sizeof(header.name) - 1);
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(walls.data()),
+               static_cast<std::streamsize>(walls.wordCount() * sizeof(uint64_t)));
+
+    for (const Position& spawn : spawns) {
+        uint16_t values[2] = { static_cast<uint16_t>(spawn.x), static_cast<uint16_t>(spawn.y) };
+        file.write(reinterpret_cast<const char*>(values), sizeof(values));
+    }
+    for (const Portal& portal : portals) {
+        uint16_t values[4] = {
+            static_cast<uint16_t>(portal.a.x), static_cast<uint16_t>(portal.a.y),
+            static_cast<uint16_t>(portal.b.x), static_cast<uint16_t>(portal.b.y)
+        };
+        file.write(reinterpret_cast<const char*>(values), sizeof(values));
+    }
+
+    return file.good();
+}
+
+Position Level::getPortalExit(const Position& entry) const {
+    // Only called once the portal bitboard says this cell is a portal
+    for (const Portal& portal : portals) {
+        if (portal.a == entry) {
+            return portal.b;
+        }
+        if (portal.b == entry) {
+            return portal.a;
+        }
+    }
+    return entry;
+}
+
+bool Level::fitsSnake(const Bitboard& levelWalls, int levelWidth, int levelHeight, const Position& spawn) {
+    if (spawn.x < 3 || spawn.x > levelWidth || spawn.y < 1 || spawn.y > levelHeight) {
+        return false;
+    }
+    for (int x = spawn.x - 2; x <= spawn.x; ++x) {
+        if (levelWalls.test(x - 1, spawn.y - 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Level::findOpenSpawn(const Bitboard& levelWalls, int levelWidth, int levelHeight,
+                          const Position& start, Position& spawn) {
+    if (fitsSnake(levelWalls, levelWidth, levelHeight, start)) {
+        spawn = start;
+        return true;
+    }
+    for (int y = 1; y <= levelHeight; ++y) {
+        for (int x = 3; x <= levelWidth; ++x) {
+            if (fitsSnake(levelWalls, levelWidth, levelHeight, Position(x, y))) {
+                spawn = Position(x, y);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+Position Level::getSpawn(int startX, int startY) const {
+    // The loaders only keep spawns that fit
+    if (!spawns.empty()) {
+        return spawns[0];
+    }
+    Position spawn(startX, startY);
+    if (!findOpenSpawn(walls, width, height, Position(startX, startY), spawn)) {
+        // Only a board under three cells wide, which every driver refuses
+        spawn = Position(std::max(1, std::min(startX, width)), std::max(1, std::min(startY, height)));
+    }
+    return spawn;
+}
+
+const std::string& Level::getName() const {
+    return name;
+}
+
+int Level::getWidth() const {
+    return width;
+}
+
+int Level::getHeight() const {
+    return height;
+}
+
+const Bitboard& Level::getWalls() const {
+    return walls;
+}
+
+const Bitboard& Level::getFoodBlocked() const {
+    return foodBlocked;
+}
+
+const std::vector<Portal>& Level::getPortals() const {
+    return portals;
+}
+
+const std::vector<Position>& Level::getSpawns() const {
+    return spawns;
+}
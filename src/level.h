@@ -0,0 +1,76 @@
+#pragma once
+#include "bitboard.h"
+#include "snake.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Linked pair of cells: entering one moves the head onto the other
+struct Portal {
+    Position a;
+    Position b;
+};
+
+// Header of a compiled (.lvl) level. Wall rows follow immediately as
+// uint64 words, then spawn points (uint16 x, y) and portals (uint16 ax, ay, bx, by).
+struct LevelFileHeader {
+    char magic[4];        // "SNKL"
+    uint16_t version;
+    uint16_t width;
+    uint16_t height;
+    uint16_t wordsPerRow;
+    uint16_t spawnCount;
+    uint16_t portalCount;
+    char name[32];
+};
+
+// Static playfield layout: walls, portals and spawn points.
+// Everything is baked into bitboards at load so per-tick checks are O(1)
+// no matter how complex the map is.
+class Level {
+private:
+    std::string name;
+    int width;
+    int height;
+    Bitboard walls;        // Solid cells
+    Bitboard portalCells;  // Cells that teleport the head
+    Bitboard foodBlocked;  // Cells food may never spawn on (walls | portals)
+    std::vector<Position> spawns;
+    std::vector<Portal> portals;
+
+    void bake();
+
+    // Whether the starting body, which Snake::reset lays over x-2..x, fits
+    // on the board at this spawn without touching a wall
+    static bool fitsSnake(const Bitboard& levelWalls, int levelWidth, int levelHeight, const Position& spawn);
+
+    // The start cell if the snake fits there, else the first cell (row by
+    // row) where it does; false if it fits nowhere
+    static bool findOpenSpawn(const Bitboard& levelWalls, int levelWidth, int levelHeight,
+                              const Position& start, Position& spawn);
+
+public:
+    Level();
+
+    // Loading and saving
+    bool load(const std::string& filename);       // Picks format by extension
+    bool loadText(const std::string& filename);
+    bool loadBinary(const std::string& filename); // Memory-mapped
+    bool saveBinary(const std::string& filename) const;
+    void makeEmpty(int newWidth, int newHeight);
+
+    // Queries (play-area coordinates, 1-based like Snake positions)
+    bool isWall(int x, int y) const { return walls.test(x - 1, y - 1); }
+    bool isPortal(int x, int y) const { return portalCells.test(x - 1, y - 1); }
+    Position getPortalExit(const Position& entry) const;
+    Position getSpawn(int startX, int startY) const; // First spawn point, else an open cell near the start
+
+    // Getters
+    const std::string& getName() const;
+    int getWidth() const;
+    int getHeight() const;
+    const Bitboard& getWalls() const;
+    const Bitboard& getFoodBlocked() const;
+    const std::vector<Portal>& getPortals() const;
+    const std::vector<Position>& getSpawns() const;
+};
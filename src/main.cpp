@@ -1,20 +1,83 @@
 #include "game.h"
+#include "headless.h"
+#include "agent_runner.h"
 #include <iostream>
 #include <exception>
+#include <cstdlib>
+#include <cstring>
+#include <string>
 
-int main() {
+int main(int argc, char* argv[]) {
+    // Scripted runs: no console, JSON summary on stdout
+    if (HeadlessRunner::isHeadless(argc, argv)) {
+        return HeadlessRunner::main(argc, argv);
+    }
+    
+    // Tournament agent: protocol on stdin/stdout, no console
+    if (AgentRunner::isAgent(argc, argv)) {
+        return AgentRunner::main(argc, argv);
+    }
+    
     try {
         // Create and initialize the game
         Game game;
         
         if (!game.initialize()) {
             std::cerr << "Failed to initialize game!" << std::endl;
-            std::cerr << "Make sure you're running this in a Windows console." << std::endl;
+            std::cerr << "Make sure you're running this in a console or terminal." << std::endl;
             std::cout << "Press any key to exit..." << std::endl;
             std::cin.get();
             return 1;
         }
         
+        // Optional session recording: --record <file>
+        // Optional latency report appended at exit: --latency-log <file>
+        // Optional bot to watch instead of playing: --watch <bot>, tuned with
+        // --think-ms <ms> and --threads <n> (mcts) or --policy <file> (mlp)
+        // Optional shared-memory feed for SnakeSpectator: --spectator-feed <name>
+        // Optional board look: --theme classic|unicode|256|truecolor|auto
+        // Optional per-game telemetry file (default telemetry.snkt by the executable): --telemetry <file>
+        std::string watchBot;
+        BotSettings botSettings;
+        for (int i = 1; i + 1 < argc; ++i) {
+            if (std::strcmp(argv[i], "--record") == 0 && !game.startRecording(argv[i + 1])) {
+                std::cerr << "Could not record to " << argv[i + 1] << std::endl;
+            }
+            if (std::strcmp(argv[i], "--latency-log") == 0) {
+                game.setLatencyLog(argv[i + 1]);
+            }
+            if (std::strcmp(argv[i], "--spectator-feed") == 0 && !game.setSpectatorFeed(argv[i + 1])) {
+                std::cerr << "Could not create spectator feed " << argv[i + 1] << std::endl;
+            }
+            if (std::strcmp(argv[i], "--watch") == 0) {
+                watchBot = argv[i + 1];
+            }
+            if (std::strcmp(argv[i], "--think-ms") == 0) {
+                botSettings.timeBudgetMs = std::atoi(argv[i + 1]);
+            }
+            if (std::strcmp(argv[i], "--threads") == 0) {
+                botSettings.threads = std::atoi(argv[i + 1]);
+            }
+            if (std::strcmp(argv[i], "--policy") == 0) {
+                botSettings.policyFile = argv[i + 1];
+            }
+            if (std::strcmp(argv[i], "--theme") == 0 && !game.setTheme(argv[i + 1])) {
+                std::cerr << "Unknown theme " << argv[i + 1] << std::endl;
+            }
+            if (std::strcmp(argv[i], "--telemetry") == 0) {
+                game.setTelemetryLog(argv[i + 1]);
+            }
+        }
+        
+        // The bot is made once all of its settings are known
+        if (!watchBot.empty() && !game.setAutopilot(watchBot, botSettings)) {
+            if (watchBot == "mlp") {
+                std::cerr << "Could not load policy " << botSettings.policyFile << " for this board" << std::endl;
+            } else {
+                std::cerr << "Unknown bot " << watchBot << std::endl;
+            }
+        }
+        
         // Run the game
         game.run();
         
@@ -0,0 +1,306 @@
+#include "mcts_bot.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    const double VALUE_SCALE = 1 << 20;  // Fixed point for the atomic value sums
+    const double EXPLORATION = 0.7;      // UCT constant for scores in [0, 1]
+    const int ITERATIONS_PER_CLOCK_CHECK = 8;
+    const double CLOSENESS_WORTH = 0.5;   // Share of a pellet for ending the rollout right next to one
+    const double FOOD_DISCOUNT = 0.9;     // A pellet's worth shrinks by this for every tick it takes to reach
+    const double SURVIVAL_WORTH = 0.1;    // Score for a rollout that lives but finds no food
+    const int STEPS_AFTER_FOOD = 10;      // Rollout steps past the first pellet, to see the snake gets out
+}
+
+MctsBot::MctsBot(int timeBudgetMs, int threadCount)
+    : timeBudgetMs(timeBudgetMs > 0 ? timeBudgetMs : 1), nodes(new Node[MAX_NODES]), nodeCount(0),
+      current(nullptr), generation(0), busy(0), stopping(false), decisions(0), lastIterations(0) {
+    if (threadCount <= 0) {
+        threadCount = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    if (threadCount <= 0) {
+        threadCount = 1;
+    }
+
+    for (int i = 0; i < threadCount; ++i) {
+        std::unique_ptr<Worker> worker(new Worker());
+        worker->random.setSeed(0x5EA4C4ull + static_cast<uint64_t>(i));
+        worker->path.reserve(MAX_TREE_DEPTH + 1);
+        worker->iterations = 0;
+        worker->pelletWorth = 1.0;
+        workers.push_back(std::move(worker));
+    }
+    for (int i = 1; i < threadCount; ++i) {
+        threads.emplace_back(&MctsBot::workerLoop, this, i);
+    }
+}
+
+MctsBot::~MctsBot() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void MctsBot::workerLoop(int index) {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [&] { return stopping || generation != seen; });
+        if (stopping) {
+            return;
+        }
+        seen = generation;
+
+        lock.unlock();
+        search(*workers[index]);
+        lock.lock();
+
+        if (--busy == 0) {
+            finished.notify_one();
+        }
+    }
+}
+
+void MctsBot::initNode(int index) {
+    nodes[index].visits.store(0, std::memory_order_relaxed);
+    nodes[index].value.store(0, std::memory_order_relaxed);
+    nodes[index].best.store(0, std::memory_order_relaxed);
+    nodes[index].children.store(UNEXPANDED, std::memory_order_relaxed);
+}
+
+Direction MctsBot::chooseDirection(const Simulation& sim) {
+    nodeCount.store(1);
+    initNode(0);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current = &sim;
+        deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeBudgetMs);
+        generation++;
+        busy = static_cast<int>(threads.size());
+    }
+    wake.notify_all();
+
+    // The calling thread searches too, then waits for the rest
+    search(*workers[0]);
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this] { return busy == 0; });
+    }
+
+    lastIterations = 0;
+    for (const std::unique_ptr<Worker>& worker : workers) {
+        lastIterations += worker->iterations;
+    }
+    decisions++;
+
+    // Play the move with the best walk found below it, the most visited of
+    // those that tie. Only chance nodes (new food) make walks differ, so
+    // the best one is a line the snake can actually play, while the mean
+    // favours moves with many decent lines over the one shortest path.
+    int first = nodes[0].children.load(std::memory_order_acquire);
+    if (first < 0) {
+        return safestDirection(sim);
+    }
+    Direction heading = sim.getSnake().getDirection();
+    Direction best = heading;
+    int64_t bestValue = -1;
+    int bestVisits = -1;
+    for (int dir = UP; dir <= RIGHT; ++dir) {
+        if (isReverse(heading, static_cast<Direction>(dir))) {
+            continue;
+        }
+        int visits = nodes[first + dir].visits.load(std::memory_order_relaxed);
+        int64_t value = nodes[first + dir].best.load(std::memory_order_relaxed);
+        if (visits > 0 && (value > bestValue || (value == bestValue && visits > bestVisits))) {
+            bestValue = value;
+            bestVisits = visits;
+            best = static_cast<Direction>(dir);
+        }
+    }
+    return best;
+}
+
+void MctsBot::search(Worker& worker) {
+    // Seeds differ per decision so chance nodes (new food) are resampled
+    worker.state.load(*current, MAX_TREE_DEPTH + ROLLOUT_DEPTH, worker.random.next() ^ decisions);
+    worker.iterations = 0;
+
+    // A pellet reached by the shortest path is worth one whole pellet however
+    // far away it is, so distant food still separates good moves from bad
+    int distance = worker.state.getFoodDistance();
+    worker.pelletWorth = distance > 0 && distance < SearchState::NO_PATH ? std::pow(FOOD_DISCOUNT, -distance) : 1.0;
+    do {
+        for (int i = 0; i < ITERATIONS_PER_CLOCK_CHECK; ++i) {
+            iterate(worker);
+            worker.state.undoTo(0);
+            worker.iterations++;
+        }
+    } while (std::chrono::steady_clock::now() < deadline);
+}
+
+int MctsBot::selectChild(const Node& parent, const SearchState& state, Random& random) const {
+    int first = parent.children.load(std::memory_order_acquire);
+    double logVisits = std::log(static_cast<double>(std::max(1, parent.visits.load(std::memory_order_relaxed))));
+
+    // Moves that die on the spot are only tried when nothing else survives;
+    // otherwise every expansion beside a wall pays for a crash and the tree
+    // learns to keep away from pellets there
+    Direction heading = state.getDirection();
+    bool anySafe = false;
+    for (int dir = UP; dir <= RIGHT; ++dir) {
+        if (!isReverse(heading, static_cast<Direction>(dir)) && state.isSafe(static_cast<Direction>(dir))) {
+            anySafe = true;
+        }
+    }
+
+    int best = heading;
+    double bestScore = -1.0;
+    for (int dir = UP; dir <= RIGHT; ++dir) {
+        if (isReverse(heading, static_cast<Direction>(dir))) {
+            continue;
+        }
+        if (anySafe && !state.isSafe(static_cast<Direction>(dir))) {
+            continue;
+        }
+        const Node& child = nodes[first + dir];
+        int visits = child.visits.load(std::memory_order_relaxed);
+        double score;
+        if (visits == 0) {
+            // Untried moves first, in random order
+            score = 2.0 + random.range(0, 1000) / 1000.0;
+        } else {
+            // In-flight walks count as visits with no value (virtual loss)
+            double mean = child.value.load(std::memory_order_relaxed) / VALUE_SCALE / visits;
+            score = mean + EXPLORATION * std::sqrt(logVisits / visits);
+        }
+        if (score > bestScore) {
+            bestScore = score;
+            best = dir;
+        }
+    }
+    return best;
+}
+
+void MctsBot::iterate(Worker& worker) {
+    SearchState& state = worker.state;
+    worker.path.clear();
+    worker.path.push_back(0);
+    nodes[0].visits.fetch_add(VIRTUAL_LOSS, std::memory_order_relaxed);
+
+    // Selection: walk down by UCT, expanding the first leaf reached
+    int node = 0;
+    double pellets = 0.0;
+    double weight = worker.pelletWorth;
+    while (state.isAlive() && state.getDepth() < MAX_TREE_DEPTH) {
+        int first = nodes[node].children.load(std::memory_order_acquire);
+        bool expanded = false;
+        if (first == UNEXPANDED) {
+            int expected = UNEXPANDED;
+            if (!nodes[node].children.compare_exchange_strong(expected, EXPANDING)) {
+                break;
+            }
+            int block = nodeCount.fetch_add(4);
+            if (block + 4 > MAX_NODES) {
+                break; // Tree is full: stays EXPANDING, so it is a leaf for this decision
+            }
+            for (int i = 0; i < 4; ++i) {
+                initNode(block + i);
+            }
+            nodes[node].children.store(block, std::memory_order_release);
+            first = block;
+            expanded = true;
+        } else if (first < 0) {
+            break; // Another thread is expanding it
+        }
+
+        int dir = selectChild(nodes[node], state, worker.random);
+        node = first + dir;
+        nodes[node].visits.fetch_add(VIRTUAL_LOSS, std::memory_order_relaxed);
+        worker.path.push_back(node);
+        int eaten = state.getFoodEaten();
+        state.step(static_cast<Direction>(dir));
+        weight *= FOOD_DISCOUNT;
+        pellets += weight * (state.getFoodEaten() - eaten);
+        if (expanded) {
+            break;
+        }
+    }
+
+    // Simulation, then backpropagation (replacing the virtual loss with one real visit)
+    int64_t value = static_cast<int64_t>(rollout(worker, pellets) * VALUE_SCALE);
+    for (int index : worker.path) {
+        nodes[index].visits.fetch_add(1 - VIRTUAL_LOSS, std::memory_order_relaxed);
+        nodes[index].value.fetch_add(value, std::memory_order_relaxed);
+        int64_t best = nodes[index].best.load(std::memory_order_relaxed);
+        while (value > best && !nodes[index].best.compare_exchange_weak(best, value, std::memory_order_relaxed)) {
+        }
+    }
+}
+
+double MctsBot::rollout(Worker& worker, double pellets) {
+    SearchState& state = worker.state;
+    int steps = 0;
+    double weight = worker.pelletWorth * std::pow(FOOD_DISCOUNT, state.getDepth()); // What a pellet eaten now is worth
+    int eaten = state.getFoodEaten();
+    int stepsFed = 0; // Where the next pellet lands is chance, so walks stop soon after one
+    while (state.isAlive() && steps < ROLLOUT_DEPTH && stepsFed <= STEPS_AFTER_FOOD) {
+        // The move that survives the next tick and gets closest to the
+        // pellet, ties broken at random, straight on if none survives.
+        // Uniform random walks on a full-size board rarely reach a pellet.
+        Direction options[3];
+        int count = 0;
+        for (int dir = UP; dir <= RIGHT; ++dir) {
+            Direction candidate = static_cast<Direction>(dir);
+            if (!isReverse(state.getDirection(), candidate) && state.isSafe(candidate)) {
+                options[count++] = candidate;
+            }
+        }
+        Direction move = state.getDirection();
+        if (count > 0) {
+            move = options[worker.random.range(0, count - 1)];
+            int best = state.getFoodDistance(move);
+            for (int i = 0; i < count; ++i) {
+                int distance = state.getFoodDistance(options[i]);
+                if (distance < best) {
+                    best = distance;
+                    move = options[i];
+                }
+            }
+        }
+        state.step(move);
+        steps++;
+        weight *= FOOD_DISCOUNT;
+        pellets += weight * (state.getFoodEaten() - eaten);
+        eaten = state.getFoodEaten();
+        if (pellets > 0.0) {
+            stepsFed++;
+        }
+    }
+
+    // Food scaled by survival (partial credit for lasting longer), so a
+    // walk that eats and then dies scores little. Pellets count for less
+    // the later they were eaten, so the search takes the shortest way to
+    // the next one. A walk that found none gets part of one for ending
+    // close to it, so it still beats one that wandered off.
+    double survival = state.isAlive() ? 1.0 : static_cast<double>(state.getDepth()) / state.getMaxDepth();
+    int distance = state.getFoodDistance();
+    if (state.isAlive() && distance >= 0 && pellets == 0.0) {
+        double span = state.getWidth() + state.getHeight();
+        pellets += std::min(1.0, weight) * CLOSENESS_WORTH * std::max(0.0, 1.0 - distance / span);
+    }
+    return survival * (SURVIVAL_WORTH + (1.0 - SURVIVAL_WORTH) * std::min(1.0, pellets));
+}
+
+const char* MctsBot::getName() const {
+    return "mcts";
+}
+
+long long MctsBot::getLastIterations() const {
+    return lastIterations;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include "bot.h"
+#include "search_state.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Monte Carlo tree search. Every worker thread walks the shared tree on its
+// own SearchState, applying moves on the way down and undoing them after the
+// rollout, so expanding a node never copies the world. Virtual loss steers
+// concurrent walks apart. Each move gets a fixed wall-clock budget.
+class MctsBot : public Bot {
+private:
+    static const int MAX_NODES = 1 << 18;
+    static const int ROLLOUT_DEPTH = 48;
+    static const int MAX_TREE_DEPTH = 64;
+    static const int VIRTUAL_LOSS = 3;
+    static const int UNEXPANDED = -1;
+    static const int EXPANDING = -2;
+
+    struct Node {
+        std::atomic<int> visits;
+        std::atomic<int64_t> value;   // Sum of rollout scores, fixed point
+        std::atomic<int64_t> best;    // Highest rollout score below, fixed point
+        std::atomic<int> children;    // First of four child slots (one per Direction)
+    };
+
+    struct Worker {
+        SearchState state;
+        Random random;
+        std::vector<int> path;
+        long long iterations;
+        double pelletWorth;  // Score for eating right away this decision
+    };
+
+    int timeBudgetMs;
+    std::unique_ptr<Node[]> nodes;
+    std::atomic<int> nodeCount;
+    std::vector<std::unique_ptr<Worker>> workers; // Worker 0 runs on the calling thread
+
+    // Decision handed to the pool
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    const Simulation* current;
+    std::chrono::steady_clock::time_point deadline;
+    uint64_t generation;
+    int busy;
+    bool stopping;
+    uint64_t decisions;
+
+    long long lastIterations;
+
+    void workerLoop(int index);
+    void search(Worker& worker);
+    void iterate(Worker& worker);
+    double rollout(Worker& worker, double pellets); // Pellets: discounted food eaten in the tree
+    int selectChild(const Node& parent, const SearchState& state, Random& random) const;
+    void initNode(int index);
+
+public:
+    MctsBot(int timeBudgetMs, int threadCount);
+    ~MctsBot() override;
+
+    Direction chooseDirection(const Simulation& sim) override;
+    const char* getName() const override;
+
+    // Rollouts run for the last decision, across all threads
+    long long getLastIterations() const;
+};
@@ -0,0 +1,434 @@
+#include "mlp_policy.h"
+#include "mapped_file.h"
+#include "snake_env.h"
+#include "utils.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define MLP_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang compile each kernel for its own instruction set; MSVC accepts
+// the intrinsics anywhere
+#if defined(MLP_X86) && defined(__GNUC__)
+#define MLP_TARGET(isa) __attribute__((target(isa)))
+#else
+#define MLP_TARGET(isa)
+#endif
+
+namespace {
+    const char POLICY_MAGIC[4] = { 'S', 'N', 'K', 'P' };
+    const uint32_t POLICY_VERSION = 1;
+    const uint32_t MAX_LAYERS = 16;
+    const uint32_t MAX_LAYER_WIDTH = 1 << 20;
+    const int SIMD_WIDTH = 8;  // Floats per AVX2 register; rows are padded to this
+
+    struct PolicyFileHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t layerCount;
+    };
+
+    int padded(int n) {
+        return (n + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+    }
+
+    // output[0..length) += column[0..length), length a multiple of SIMD_WIDTH
+    typedef void (*AddKernel)(float* output, const float* column, int length);
+
+    // output[s][row] = bias[row] + dot(weights[row], input[s]) for `count` samples
+    // `sampleStride` apart, with optional ReLU. Padding outputs are zeroed.
+    typedef void (*DenseKernel)(const float* weights, const float* bias, int stride, int outputs,
+                                const float* input, int count, int sampleStride, float* output, bool relu);
+
+    void addScalar(float* output, const float* column, int length) {
+        for (int i = 0; i < length; ++i) {
+            output[i] += column[i];
+        }
+    }
+
+    void denseScalar(const float* weights, const float* bias, int stride, int outputs,
+                     const float* input, int count, int sampleStride, float* output, bool relu) {
+        for (int row = 0; row < outputs; ++row) {
+            const float* w = weights + static_cast<size_t>(row) * stride;
+            for (int s = 0; s < count; ++s) {
+                const float* x = input + static_cast<size_t>(s) * sampleStride;
+                float sum = bias[row];
+                for (int k = 0; k < stride; ++k) {
+                    sum += w[k] * x[k];
+                }
+                output[static_cast<size_t>(s) * sampleStride + row] = relu && sum < 0.0f ? 0.0f : sum;
+            }
+        }
+        for (int s = 0; s < count; ++s) {
+            std::fill(output + static_cast<size_t>(s) * sampleStride + outputs,
+                      output + static_cast<size_t>(s) * sampleStride + padded(outputs), 0.0f);
+        }
+    }
+
+#ifdef MLP_X86
+    MLP_TARGET("sse") float horizontalSum(__m128 v) {
+        __m128 shuffled = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+        __m128 sums = _mm_add_ps(v, shuffled);
+        shuffled = _mm_movehl_ps(shuffled, sums);
+        return _mm_cvtss_f32(_mm_add_ss(sums, shuffled));
+    }
+
+    MLP_TARGET("sse") void addSse(float* output, const float* column, int length) {
+        for (int i = 0; i < length; i += 4) {
+            _mm_storeu_ps(output + i, _mm_add_ps(_mm_loadu_ps(output + i), _mm_loadu_ps(column + i)));
+        }
+    }
+
+    MLP_TARGET("sse") void denseSse(const float* weights, const float* bias, int stride, int outputs,
+                                    const float* input, int count, int sampleStride, float* output, bool relu) {
+        for (int row = 0; row < outputs; ++row) {
+            const float* w = weights + static_cast<size_t>(row) * stride;
+            __m128 acc[MlpPolicy::BLOCK];
+            for (int s = 0; s < count; ++s) {
+                acc[s] = _mm_setzero_ps();
+            }
+            // Each weight load is shared by every sample in the block
+            for (int k = 0; k < stride; k += 4) {
+                __m128 wv = _mm_loadu_ps(w + k);
+                for (int s = 0; s < count; ++s) {
+                    acc[s] = _mm_add_ps(acc[s], _mm_mul_ps(wv, _mm_loadu_ps(input + static_cast<size_t>(s) * sampleStride + k)));
+                }
+            }
+            for (int s = 0; s < count; ++s) {
+                float sum = bias[row] + horizontalSum(acc[s]);
+                output[static_cast<size_t>(s) * sampleStride + row] = relu && sum < 0.0f ? 0.0f : sum;
+            }
+        }
+        for (int s = 0; s < count; ++s) {
+            std::fill(output + static_cast<size_t>(s) * sampleStride + outputs,
+                      output + static_cast<size_t>(s) * sampleStride + padded(outputs), 0.0f);
+        }
+    }
+
+    MLP_TARGET("avx2,fma") void addAvx2(float* output, const float* column, int length) {
+        for (int i = 0; i < length; i += 8) {
+            _mm256_storeu_ps(output + i, _mm256_add_ps(_mm256_loadu_ps(output + i), _mm256_loadu_ps(column + i)));
+        }
+    }
+
+    MLP_TARGET("avx2,fma") void denseAvx2(const float* weights, const float* bias, int stride, int outputs,
+                                          const float* input, int count, int sampleStride, float* output, bool relu) {
+        for (int row = 0; row < outputs; ++row) {
+            const float* w = weights + static_cast<size_t>(row) * stride;
+            __m256 acc[MlpPolicy::BLOCK];
+            for (int s = 0; s < count; ++s) {
+                acc[s] = _mm256_setzero_ps();
+            }
+            for (int k = 0; k < stride; k += 8) {
+                __m256 wv = _mm256_loadu_ps(w + k);
+                for (int s = 0; s < count; ++s) {
+                    acc[s] = _mm256_fmadd_ps(wv, _mm256_loadu_ps(input + static_cast<size_t>(s) * sampleStride + k), acc[s]);
+                }
+            }
+            for (int s = 0; s < count; ++s) {
+                __m128 half = _mm_add_ps(_mm256_castps256_ps128(acc[s]), _mm256_extractf128_ps(acc[s], 1));
+                float sum = bias[row] + horizontalSum(half);
+                output[static_cast<size_t>(s) * sampleStride + row] = relu && sum < 0.0f ? 0.0f : sum;
+            }
+        }
+        for (int s = 0; s < count; ++s) {
+            std::fill(output + static_cast<size_t>(s) * sampleStride + outputs,
+                      output + static_cast<size_t>(s) * sampleStride + padded(outputs), 0.0f);
+        }
+    }
+
+    bool cpuHasSse() {
+#if defined(_M_X64) || defined(__x86_64__)
+        return true;
+#elif defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        return (info[3] & (1 << 25)) != 0;
+#else
+        return __builtin_cpu_supports("sse");
+#endif
+    }
+
+    bool cpuHasAvx2() {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 1);
+        bool fma = (info[2] & (1 << 12)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        __cpuidex(info, 7, 0);
+        bool avx2 = (info[1] & (1 << 5)) != 0;
+        // The OS must also save the upper halves of the YMM registers
+        return fma && avx2 && osxsave && (_xgetbv(0) & 6) == 6;
+#else
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+    }
+#endif
+
+    struct Kernels {
+        const char* name;
+        AddKernel add;
+        DenseKernel dense;
+    };
+
+    // Best kernel set for this CPU. SNAKE_MLP_KERNEL=sse or scalar forces a
+    // lower one, e.g. to compare their outputs.
+    Kernels detectKernels() {
+        const char* forced = std::getenv("SNAKE_MLP_KERNEL");
+        std::string limit = forced ? forced : "";
+#ifdef MLP_X86
+        if (limit != "sse" && limit != "scalar" && cpuHasAvx2()) {
+            return Kernels{ "avx2", addAvx2, denseAvx2 };
+        }
+        if (limit != "scalar" && cpuHasSse()) {
+            return Kernels{ "sse", addSse, denseSse };
+        }
+#endif
+        return Kernels{ "scalar", addScalar, denseScalar };
+    }
+
+    const Kernels& kernels() {
+        static const Kernels selected = detectKernels();
+        return selected;
+    }
+}
+
+MlpPolicy::MlpPolicy() : maxWidth(0) {
+}
+
+bool MlpPolicy::load(const std::string& filename) {
+    MappedFile mapped;
+    if (!mapped.open(filename) || mapped.size() < sizeof(PolicyFileHeader)) {
+        return false;
+    }
+
+    PolicyFileHeader header;
+    std::memcpy(&header, mapped.data(), sizeof(header));
+    if (std::memcmp(header.magic, POLICY_MAGIC, 4) != 0 || header.version != POLICY_VERSION ||
+        header.layerCount == 0 || header.layerCount > MAX_LAYERS) {
+        Utils::logError("Not a policy file: " + filename);
+        return false;
+    }
+
+    // Layer shapes must chain and end in one score per direction
+    const unsigned char* cursor = mapped.data() + sizeof(header);
+    size_t expected = sizeof(header) + header.layerCount * 2 * sizeof(uint32_t);
+    if (mapped.size() < expected) {
+        Utils::logError("Truncated policy file: " + filename);
+        return false;
+    }
+    std::vector<Layer> shapes(header.layerCount);
+    for (Layer& layer : shapes) {
+        uint32_t shape[2];
+        std::memcpy(shape, cursor, sizeof(shape));
+        cursor += sizeof(shape);
+        if (shape[0] == 0 || shape[1] == 0 || shape[0] > MAX_LAYER_WIDTH || shape[1] > MAX_LAYER_WIDTH ||
+            (&layer != &shapes[0] && shape[0] != static_cast<uint32_t>((&layer - 1)->outputs))) {
+            Utils::logError("Corrupt policy file: " + filename);
+            return false;
+        }
+        layer.inputs = static_cast<int>(shape[0]);
+        layer.outputs = static_cast<int>(shape[1]);
+        expected += (static_cast<size_t>(shape[0]) + 1) * shape[1] * sizeof(float);
+    }
+    if (shapes.back().outputs != 4) {
+        Utils::logError("Policy must end in 4 outputs (one per direction): " + filename);
+        return false;
+    }
+    if (mapped.size() != expected) {
+        Utils::logError("Truncated policy file: " + filename);
+        return false;
+    }
+
+    // Copy into padded rows. The first layer is transposed so each input
+    // cell owns one contiguous column.
+    size_t total = 0;
+    maxWidth = 0;
+    for (size_t i = 0; i < shapes.size(); ++i) {
+        Layer& layer = shapes[i];
+        layer.stride = i == 0 ? padded(layer.outputs) : padded(layer.inputs);
+        layer.weights = total;
+        total += i == 0 ? static_cast<size_t>(layer.inputs) * layer.stride
+                        : static_cast<size_t>(layer.outputs) * layer.stride;
+        layer.bias = total;
+        total += static_cast<size_t>(padded(layer.outputs));
+        maxWidth = std::max(maxWidth, padded(std::max(i == 0 ? 0 : layer.inputs, layer.outputs)));
+    }
+
+    std::vector<float> values(total, 0.0f);
+    const float* source = reinterpret_cast<const float*>(cursor);
+    for (size_t i = 0; i < shapes.size(); ++i) {
+        const Layer& layer = shapes[i];
+        for (int row = 0; row < layer.outputs; ++row) {
+            for (int column = 0; column < layer.inputs; ++column) {
+                float value;
+                std::memcpy(&value, source++, sizeof(value));
+                size_t at = i == 0 ? static_cast<size_t>(column) * layer.stride + row
+                                   : static_cast<size_t>(row) * layer.stride + column;
+                values[layer.weights + at] = value;
+            }
+        }
+        std::memcpy(&values[layer.bias], source, layer.outputs * sizeof(float));
+        source += layer.outputs;
+    }
+
+    layers.swap(shapes);
+    parameters.swap(values);
+    activations[0].assign(static_cast<size_t>(BLOCK) * maxWidth, 0.0f);
+    activations[1].assign(static_cast<size_t>(BLOCK) * maxWidth, 0.0f);
+    active.assign(static_cast<size_t>(layers[0].inputs), 0);
+    return true;
+}
+
+bool MlpPolicy::isLoaded() const {
+    return !layers.empty();
+}
+
+int MlpPolicy::getInputSize() const {
+    return layers.empty() ? 0 : layers[0].inputs;
+}
+
+bool MlpPolicy::fits(int width, int height) const {
+    return isLoaded() && getInputSize() == SNAKE_ENV_PLANE_COUNT * width * height;
+}
+
+const char* MlpPolicy::getKernelName() {
+    return kernels().name;
+}
+
+void MlpPolicy::addColumns(const int* indices, int count, float* output) const {
+    const Layer& first = layers[0];
+    std::memcpy(output, &parameters[first.bias], first.stride * sizeof(float));
+    AddKernel add = kernels().add;
+    for (int i = 0; i < count; ++i) {
+        add(output, &parameters[first.weights + static_cast<size_t>(indices[i]) * first.stride], first.stride);
+    }
+}
+
+const float* MlpPolicy::forwardBlock(int count) {
+    // Layer 0 is already summed into activations[0]
+    float* current = activations[0].data();
+    float* next = activations[1].data();
+    if (layers.size() > 1) {
+        for (int s = 0; s < count; ++s) {
+            float* sample = current + static_cast<size_t>(s) * maxWidth;
+            for (int i = 0; i < layers[0].outputs; ++i) {
+                sample[i] = std::max(sample[i], 0.0f);
+            }
+        }
+    }
+
+    DenseKernel dense = kernels().dense;
+    for (size_t i = 1; i < layers.size(); ++i) {
+        const Layer& layer = layers[i];
+        dense(&parameters[layer.weights], &parameters[layer.bias], layer.stride, layer.outputs,
+              current, count, maxWidth, next, i + 1 < layers.size());
+        std::swap(current, next);
+    }
+    return current;
+}
+
+Direction MlpPolicy::pickAction(const float* scores, const Direction* reverse) {
+    int best = -1;
+    for (int dir = UP; dir <= RIGHT; ++dir) {
+        if (reverse && dir == *reverse) {
+            continue;
+        }
+        if (best < 0 || scores[dir] > scores[best]) {
+            best = dir;
+        }
+    }
+    return static_cast<Direction>(best);
+}
+
+bool MlpPolicy::choose(const Simulation& sim, Direction& action) {
+    int width = sim.getWidth();
+    int height = sim.getHeight();
+    int planeSize = width * height;
+    if (!fits(width, height)) {
+        return false;
+    }
+
+    // Same cells SnakeEnv would mark, straight from the world state
+    int count = 0;
+    auto mark = [&](int plane, const Position& pos) {
+        active[count++] = plane * planeSize + (pos.y - 1) * width + (pos.x - 1);
+    };
+    const Snake& snake = sim.getSnake();
+    bool head = true;
+    snake.forEachSegment([&](const Position& segment) {
+        if (!head) {
+            mark(SNAKE_ENV_PLANE_BODY, segment);
+        }
+        head = false;
+    });
+    mark(SNAKE_ENV_PLANE_HEAD, snake.getHead());
+    if (sim.getFood().isActive()) {
+        mark(SNAKE_ENV_PLANE_FOOD, sim.getFood().getPosition());
+    }
+    for (const FoodItem& item : sim.getItems().getItems()) {
+        if (item.active && !(sim.getFood().isActive() && item.position == sim.getFood().getPosition())) {
+            mark(SNAKE_ENV_PLANE_FOOD, item.position);
+        }
+    }
+    const Level& level = sim.getLevel();
+    for (int y = 1; y <= height; ++y) {
+        for (int x = 1; x <= width; ++x) {
+            if (level.isWall(x, y)) {
+                mark(SNAKE_ENV_PLANE_WALLS, Position(x, y));
+            }
+        }
+    }
+
+    addColumns(active.data(), count, activations[0].data());
+    Direction heading = sim.getSnake().getDirection();
+    Direction reverse = heading == UP ? DOWN : heading == DOWN ? UP : heading == LEFT ? RIGHT : LEFT;
+    action = pickAction(forwardBlock(1), &reverse);
+    return true;
+}
+
+void MlpPolicy::chooseBatch(const uint8_t* observations, int count, Direction* actions) {
+    if (!isLoaded()) {
+        return;
+    }
+    int inputs = getInputSize();
+    for (int first = 0; first < count; first += BLOCK) {
+        int blockSize = count - first < BLOCK ? count - first : BLOCK;
+        for (int s = 0; s < blockSize; ++s) {
+            // Boards are mostly empty: skip eight zero bytes at a time
+            const uint8_t* observation = observations + static_cast<size_t>(first + s) * inputs;
+            int set = 0;
+            int i = 0;
+            for (; i + 8 <= inputs; i += 8) {
+                uint64_t chunk;
+                std::memcpy(&chunk, observation + i, sizeof(chunk));
+                if (chunk == 0) {
+                    continue;
+                }
+                for (int j = 0; j < 8; ++j) {
+                    if (observation[i + j]) {
+                        active[set++] = i + j;
+                    }
+                }
+            }
+            for (; i < inputs; ++i) {
+                if (observation[i]) {
+                    active[set++] = i;
+                }
+            }
+            addColumns(active.data(), set, activations[0].data() + static_cast<size_t>(s) * maxWidth);
+        }
+
+        const float* scores = forwardBlock(blockSize);
+        for (int s = 0; s < blockSize; ++s) {
+            actions[first + s] = pickAction(scores + static_cast<size_t>(s) * maxWidth, nullptr);
+        }
+    }
+}
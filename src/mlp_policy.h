@@ -0,0 +1,67 @@
+#pragma once
+#include "simulation.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Small dense MLP that maps the board to a move. Input is the SnakeEnv
+// observation (body, head, food and walls planes, one 0/1 value per cell),
+// hidden layers use ReLU, and the last layer gives one score per Direction.
+//
+// Weights come from a flat little-endian file:
+//   char magic[4] "SNKP", uint32 version (1), uint32 layerCount,
+//   layerCount x { uint32 inputs, uint32 outputs },
+//   then per layer: float weights[outputs][inputs], float bias[outputs]
+//
+// Because the inputs are 0/1, the first layer adds up the weight columns of
+// the set cells instead of multiplying the whole grid. The later layers run
+// on AVX2, SSE or scalar kernels, picked once from the CPU. All buffers are
+// sized at load time, so evaluating never allocates. Not thread-safe: use
+// one policy per thread.
+class MlpPolicy {
+public:
+    static const int BLOCK = 4;  // Samples that share each pass over the weights
+
+private:
+    struct Layer {
+        int inputs;
+        int outputs;
+        int stride;          // Padded row length (layer 0: padded column length)
+        size_t weights;      // Offset into parameters
+        size_t bias;
+    };
+
+    std::vector<Layer> layers;
+    std::vector<float> parameters;  // Layer 0 is stored by column, the rest by row
+    int maxWidth;                   // Widest padded layer
+
+    // Scratch, sized by load()
+    std::vector<float> activations[2];  // BLOCK samples each
+    std::vector<int> active;            // Set inputs of one sample
+
+    void addColumns(const int* indices, int count, float* output) const;
+    const float* forwardBlock(int count);  // Scores of the last layer, maxWidth apart
+    static Direction pickAction(const float* scores, const Direction* reverse);
+
+public:
+    MlpPolicy();
+
+    bool load(const std::string& filename);
+    bool isLoaded() const;
+
+    // Observation bytes per sample; 4 * width * height for the board it was trained on
+    int getInputSize() const;
+
+    // True if the policy was trained on a board of this size
+    bool fits(int width, int height) const;
+
+    // One move for the live game; the reverse of the current heading is never picked.
+    // Returns false if the policy does not fit this board.
+    bool choose(const Simulation& sim, Direction& action);
+
+    // Moves for `count` observations laid out back to back as SnakeEnv writes them
+    void chooseBatch(const uint8_t* observations, int count, Direction* actions);
+
+    // "avx2", "sse" or "scalar"
+    static const char* getKernelName();
+};
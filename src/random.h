@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+
+// Small, fast random number generator (xorshift64*) so every simulation has
+// its own reproducible stream instead of sharing the global rand() state.
+class Random {
+private:
+    uint64_t state;
+
+public:
+    explicit Random(uint64_t seed = 1) { setSeed(seed); }
+
+    void setSeed(uint64_t seed) {
+        // splitmix64 spreads nearby seeds apart; the state must never be zero
+        uint64_t z = seed + 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        z ^= z >> 31;
+        state = z != 0 ? z : 0x9E3779B97F4A7C15ull;
+    }
+
+    uint64_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1Dull;
+    }
+
+    // Uniform integer in [min, max] (multiply-shift, no modulo bias worth noting)
+    int range(int min, int max) {
+        uint64_t span = static_cast<uint64_t>(max - min) + 1;
+        return min + static_cast<int>(((next() >> 32) * span) >> 32);
+    }
+
+    uint64_t getState() const { return state; }
+};
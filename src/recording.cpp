@@ -0,0 +1,453 @@
+#include "recording.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+    const char RECORDING_MAGIC[4] = { 'S', 'N', 'K', 'R' };
+    const uint16_t RECORDING_VERSION = 1;
+    const size_t HEADER_SIZE = 16;
+    const size_t RECORD_HEADER_SIZE = 9;
+    const size_t WRITE_BLOCK = 64 * 1024;
+
+    int64_t nowMicros() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void putLE16(std::string& out, uint16_t value) {
+        out += static_cast<char>(value & 0xFF);
+        out += static_cast<char>((value >> 8) & 0xFF);
+    }
+
+    void putLE32(std::string& out, uint32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            out += static_cast<char>((value >> (8 * i)) & 0xFF);
+        }
+    }
+
+    void putVarint(std::string& out, size_t value) {
+        while (value >= 0x80) {
+            out += static_cast<char>((value & 0x7F) | 0x80);
+            value >>= 7;
+        }
+        out += static_cast<char>(value);
+    }
+
+    uint16_t getLE16(const unsigned char* bytes) {
+        return static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+    }
+
+    uint32_t getLE32(const unsigned char* bytes) {
+        return static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8) |
+               (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+    }
+
+    bool getVarint(const unsigned char*& bytes, const unsigned char* end, size_t& value) {
+        value = 0;
+        for (int shift = 0; bytes < end && shift < 64; shift += 7) {
+            unsigned char byte = *bytes++;
+            value |= static_cast<size_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Runs of identical cells: varint count, ch, color
+    void putRuns(std::string& out, const FrameCell* cells, size_t count) {
+        size_t i = 0;
+        while (i < count) {
+            size_t run = 1;
+            while (i + run < count && cells[i + run] == cells[i]) {
+                run++;
+            }
+            putVarint(out, run);
+            out += cells[i].ch;
+            out += static_cast<char>(cells[i].color);
+            i += run;
+        }
+    }
+
+    bool getRuns(const unsigned char*& bytes, const unsigned char* end, FrameCell* cells, size_t count) {
+        size_t filled = 0;
+        while (filled < count) {
+            size_t run = 0;
+            if (!getVarint(bytes, end, run) || end - bytes < 2 || run == 0 || run > count - filled) {
+                return false;
+            }
+            FrameCell cell = { static_cast<char>(bytes[0]), bytes[1] };
+            bytes += 2;
+            std::fill(cells + filled, cells + filled + run, cell);
+            filled += run;
+        }
+        return true;
+    }
+}
+
+// RecordingWriter implementation
+RecordingWriter::RecordingWriter() : file(nullptr), stopping(false), bytesWritten(0) {
+}
+
+RecordingWriter::~RecordingWriter() {
+    close();
+}
+
+bool RecordingWriter::open(const std::string& filename) {
+    close();
+    file = std::fopen(filename.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    stopping = false;
+    bytesWritten = 0;
+    filling.reserve(WRITE_BLOCK * 2);
+    writing.reserve(WRITE_BLOCK * 2);
+    worker = std::thread(&RecordingWriter::writerLoop, this);
+    return true;
+}
+
+void RecordingWriter::append(const std::string& bytes) {
+    bool full = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        filling += bytes;
+        full = filling.size() >= WRITE_BLOCK;
+    }
+    if (full) {
+        ready.notify_one();
+    }
+}
+
+void RecordingWriter::writerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        ready.wait_for(lock, std::chrono::milliseconds(500), [this] {
+            return stopping || filling.size() >= WRITE_BLOCK;
+        });
+        bool finished = stopping;
+
+        // Swap buffers and write without holding the lock
+        writing.swap(filling);
+        lock.unlock();
+        if (!writing.empty()) {
+            bytesWritten += std::fwrite(writing.data(), 1, writing.size(), file);
+            std::fflush(file);
+            writing.clear();
+        }
+        lock.lock();
+
+        if (finished && filling.empty()) {
+            break;
+        }
+    }
+}
+
+void RecordingWriter::close() {
+    if (!file) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    ready.notify_one();
+    if (worker.joinable()) {
+        worker.join();
+    }
+    std::fclose(file);
+    file = nullptr;
+}
+
+bool RecordingWriter::isOpen() const {
+    return file != nullptr;
+}
+
+size_t RecordingWriter::getBytesWritten() const {
+    return bytesWritten;
+}
+
+// FrameRecorder implementation
+FrameRecorder::FrameRecorder()
+    : width(0), height(0), startTime(0), lastKeyframe(0), recording(false),
+      frameCount(0), keyframeCount(0), rawBytes(0), encodedBytes(0), captureMicros(0) {
+}
+
+FrameRecorder::~FrameRecorder() {
+    stop();
+}
+
+bool FrameRecorder::start(const std::string& filename, int gridWidth, int gridHeight) {
+    stop();
+    if (gridWidth <= 0 || gridHeight <= 0 || gridWidth > 0xFFFF || gridHeight > 0xFFFF) {
+        return false;
+    }
+    if (!writer.open(filename)) {
+        return false;
+    }
+
+    width = gridWidth;
+    height = gridHeight;
+    previous.clear();
+    frameCount = 0;
+    keyframeCount = 0;
+    rawBytes = 0;
+    encodedBytes = 0;
+    captureMicros = 0;
+    startTime = nowMicros();
+    recording = true;
+
+    std::string header(RECORDING_MAGIC, sizeof(RECORDING_MAGIC));
+    putLE16(header, RECORDING_VERSION);
+    putLE16(header, static_cast<uint16_t>(width));
+    putLE16(header, static_cast<uint16_t>(height));
+    putLE16(header, 0);
+    putLE32(header, 0);
+    writer.append(header);
+    return true;
+}
+
+void FrameRecorder::stop() {
+    if (!recording) {
+        return;
+    }
+    recording = false;
+    writer.close();
+}
+
+bool FrameRecorder::isRecording() const {
+    return recording;
+}
+
+void FrameRecorder::capture(const std::vector<FrameCell>& grid) {
+    if (!recording || grid.size() != static_cast<size_t>(width) * height) {
+        return;
+    }
+
+    int64_t begin = nowMicros();
+    int64_t elapsed = begin - startTime;
+    record.clear();
+    if (previous.empty() || elapsed - lastKeyframe >= KEYFRAME_INTERVAL_MS * 1000) {
+        encodeKeyframe(grid);
+        lastKeyframe = elapsed;
+    } else if (!encodeDelta(grid)) {
+        captureMicros += nowMicros() - begin;
+        return;
+    }
+
+    // Record header goes in front of the payload
+    uint32_t payload = static_cast<uint32_t>(record.size() - RECORD_HEADER_SIZE);
+    uint32_t timeMs = static_cast<uint32_t>(elapsed / 1000);
+    for (int i = 0; i < 4; ++i) {
+        record[1 + i] = static_cast<char>((timeMs >> (8 * i)) & 0xFF);
+        record[5 + i] = static_cast<char>((payload >> (8 * i)) & 0xFF);
+    }
+    writer.append(record);
+    previous = grid;
+
+    frameCount++;
+    rawBytes += grid.size() * sizeof(FrameCell);
+    encodedBytes += record.size();
+    captureMicros += nowMicros() - begin;
+}
+
+void FrameRecorder::encodeKeyframe(const std::vector<FrameCell>& grid) {
+    record.assign(RECORD_HEADER_SIZE, '\0');
+    record[0] = static_cast<char>(RECORD_KEYFRAME);
+    putRuns(record, grid.data(), grid.size());
+    keyframeCount++;
+}
+
+bool FrameRecorder::encodeDelta(const std::vector<FrameCell>& grid) {
+    record.assign(RECORD_HEADER_SIZE, '\0');
+    record[0] = static_cast<char>(RECORD_DELTA);
+
+    size_t count = grid.size();
+    size_t i = 0;
+    size_t unchangedFrom = 0;
+    bool changed = false;
+    while (i < count) {
+        if (grid[i] == previous[i]) {
+            i++;
+            continue;
+        }
+
+        // A changed span ends at the first run of 4 unchanged cells, which
+        // costs less to skip than to repeat
+        size_t start = i;
+        size_t end = i + 1;
+        size_t same = 0;
+        while (end < count && same < 4) {
+            same = grid[end] == previous[end] ? same + 1 : 0;
+            end++;
+        }
+        if (same > 0) {
+            end -= same;
+        }
+
+        putVarint(record, start - unchangedFrom);
+        putVarint(record, end - start);
+        putRuns(record, grid.data() + start, end - start);
+        unchangedFrom = end;
+        i = end;
+        changed = true;
+    }
+    return changed;
+}
+
+int FrameRecorder::getWidth() const {
+    return width;
+}
+
+int FrameRecorder::getHeight() const {
+    return height;
+}
+
+size_t FrameRecorder::getFrameCount() const {
+    return frameCount;
+}
+
+size_t FrameRecorder::getBytesWritten() const {
+    return writer.getBytesWritten();
+}
+
+double FrameRecorder::getCompressionRatio() const {
+    return encodedBytes > 0 ? static_cast<double>(rawBytes) / encodedBytes : 0.0;
+}
+
+double FrameRecorder::getAverageCaptureMicros() const {
+    return frameCount > 0 ? static_cast<double>(captureMicros) / frameCount : 0.0;
+}
+
+// RecordingReader implementation
+RecordingReader::RecordingReader() : width(0), height(0) {
+}
+
+bool RecordingReader::open(const std::string& filename) {
+    records.clear();
+    keyframes.clear();
+    if (!file.open(filename)) {
+        return false;
+    }
+
+    const unsigned char* bytes = file.data();
+    size_t size = file.size();
+    if (size < HEADER_SIZE || std::memcmp(bytes, RECORDING_MAGIC, sizeof(RECORDING_MAGIC)) != 0 ||
+        getLE16(bytes + 4) != RECORDING_VERSION) {
+        return false;
+    }
+    width = getLE16(bytes + 6);
+    height = getLE16(bytes + 8);
+    if (width == 0 || height == 0) {
+        return false;
+    }
+
+    // Index every complete record; a torn record at the end is ignored
+    size_t offset = HEADER_SIZE;
+    while (size - offset >= RECORD_HEADER_SIZE) {
+        RecordInfo info;
+        unsigned char type = bytes[offset];
+        info.timeMs = getLE32(bytes + offset + 1);
+        info.size = getLE32(bytes + offset + 5);
+        info.offset = offset + RECORD_HEADER_SIZE;
+        if ((type != RECORD_KEYFRAME && type != RECORD_DELTA) || info.size > size - info.offset) {
+            break;
+        }
+        info.type = static_cast<RecordType>(type);
+
+        // Frames before the first keyframe cannot be decoded
+        if (info.type == RECORD_KEYFRAME) {
+            keyframes.push_back(records.size());
+        }
+        if (!keyframes.empty()) {
+            records.push_back(info);
+        }
+        offset = info.offset + info.size;
+    }
+    return !records.empty();
+}
+
+int RecordingReader::getWidth() const {
+    return width;
+}
+
+int RecordingReader::getHeight() const {
+    return height;
+}
+
+size_t RecordingReader::getFrameCount() const {
+    return records.size();
+}
+
+uint32_t RecordingReader::getFrameTime(size_t index) const {
+    return index < records.size() ? records[index].timeMs : 0;
+}
+
+uint32_t RecordingReader::getDuration() const {
+    return records.empty() ? 0 : records.back().timeMs;
+}
+
+size_t RecordingReader::findFrame(uint32_t timeMs) const {
+    auto it = std::upper_bound(records.begin(), records.end(), timeMs,
+                               [](uint32_t time, const RecordInfo& info) { return time < info.timeMs; });
+    return it == records.begin() ? 0 : static_cast<size_t>(it - records.begin()) - 1;
+}
+
+size_t RecordingReader::previousKeyframe(size_t index) const {
+    auto it = std::upper_bound(keyframes.begin(), keyframes.end(), index);
+    return it == keyframes.begin() ? 0 : *(it - 1);
+}
+
+size_t RecordingReader::nextKeyframe(size_t index) const {
+    auto it = std::upper_bound(keyframes.begin(), keyframes.end(), index);
+    return it == keyframes.end() ? records.size() - 1 : *it;
+}
+
+bool RecordingReader::decodeRecord(size_t index, std::vector<FrameCell>& grid) const {
+    const RecordInfo& info = records[index];
+    const unsigned char* bytes = file.data() + info.offset;
+    const unsigned char* end = bytes + info.size;
+
+    if (info.type == RECORD_KEYFRAME) {
+        return getRuns(bytes, end, grid.data(), grid.size());
+    }
+
+    size_t position = 0;
+    while (bytes < end) {
+        size_t skip = 0;
+        size_t changed = 0;
+        if (!getVarint(bytes, end, skip) || !getVarint(bytes, end, changed) ||
+            skip > grid.size() - position || changed > grid.size() - position - skip) {
+            return false;
+        }
+        position += skip;
+        if (!getRuns(bytes, end, grid.data() + position, changed)) {
+            return false;
+        }
+        position += changed;
+    }
+    return true;
+}
+
+bool RecordingReader::seek(size_t current, size_t index, std::vector<FrameCell>& grid) const {
+    if (index >= records.size()) {
+        return false;
+    }
+    if (index == current) {
+        return true;
+    }
+    grid.resize(static_cast<size_t>(width) * height);
+
+    // Play forward from the current frame unless a keyframe is closer
+    size_t from = previousKeyframe(index);
+    if (current < records.size() && current < index && current >= from) {
+        from = current + 1;
+    }
+    for (size_t i = from; i <= index; ++i) {
+        if (!decodeRecord(i, grid)) {
+            return false;
+        }
+    }
+    return true;
+}
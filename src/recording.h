@@ -0,0 +1,145 @@
+#pragma once
+#include "mapped_file.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// One character cell of the recorded screen
+struct FrameCell {
+    char ch;
+    uint8_t color;
+
+    bool operator==(const FrameCell& other) const { return ch == other.ch && color == other.color; }
+    bool operator!=(const FrameCell& other) const { return !(*this == other); }
+};
+
+// Session recording file (.snkr), little-endian:
+//   header  "SNKR", u16 version, u16 width, u16 height, u16 reserved, u32 reserved
+//   records u8 type, u32 time in ms since the start, u32 payload size, payload
+// A keyframe payload is the whole grid as runs of (varint count, ch, color).
+// A delta payload is a list of (varint unchanged cells, varint changed cells,
+// runs covering the changed cells) against the previous frame.
+enum RecordType {
+    RECORD_KEYFRAME = 1,
+    RECORD_DELTA = 2
+};
+
+// Appends bytes to a file from a background thread so the game thread never
+// waits on the disk. Data is handed over in blocks and flushed at least
+// every half second.
+class RecordingWriter {
+private:
+    std::FILE* file;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::string filling; // Game thread appends here
+    std::string writing; // Worker thread writes this out
+    bool stopping;
+    std::atomic<size_t> bytesWritten;
+
+    void writerLoop();
+
+public:
+    RecordingWriter();
+    ~RecordingWriter();
+
+    bool open(const std::string& filename);
+    void append(const std::string& bytes);
+    void close();
+
+    bool isOpen() const;
+    size_t getBytesWritten() const;
+};
+
+// Captures the screen grid once per frame as compressed delta records,
+// with a keyframe every second so players can seek.
+class FrameRecorder {
+private:
+    static const uint32_t KEYFRAME_INTERVAL_MS = 1000;
+
+    RecordingWriter writer;
+    int width;
+    int height;
+    std::vector<FrameCell> previous;
+    std::string record; // Reused encode buffer
+    int64_t startTime;
+    int64_t lastKeyframe;
+    bool recording;
+
+    // Statistics
+    size_t frameCount;
+    size_t keyframeCount;
+    size_t rawBytes;
+    size_t encodedBytes;
+    int64_t captureMicros;
+
+    void encodeKeyframe(const std::vector<FrameCell>& grid);
+    bool encodeDelta(const std::vector<FrameCell>& grid);
+
+public:
+    FrameRecorder();
+    ~FrameRecorder();
+
+    bool start(const std::string& filename, int gridWidth, int gridHeight);
+    void stop();
+    bool isRecording() const;
+
+    // Called once per frame with the current screen; unchanged frames are skipped
+    void capture(const std::vector<FrameCell>& grid);
+
+    int getWidth() const;
+    int getHeight() const;
+    size_t getFrameCount() const;
+    size_t getBytesWritten() const;
+    double getCompressionRatio() const;
+    double getAverageCaptureMicros() const;
+};
+
+// Reads a recording for playback. Records are indexed on open so any frame
+// can be reached by decoding from the keyframe at or before it.
+class RecordingReader {
+private:
+    struct RecordInfo {
+        RecordType type;
+        uint32_t timeMs;
+        size_t offset; // Payload offset in the file
+        size_t size;
+    };
+
+    MappedFile file;
+    int width;
+    int height;
+    std::vector<RecordInfo> records;
+    std::vector<size_t> keyframes; // Record indices
+
+    bool decodeRecord(size_t index, std::vector<FrameCell>& grid) const;
+
+public:
+    RecordingReader();
+
+    bool open(const std::string& filename);
+
+    int getWidth() const;
+    int getHeight() const;
+    size_t getFrameCount() const;
+    uint32_t getFrameTime(size_t index) const;
+    uint32_t getDuration() const;
+
+    // Index of the last frame shown at the given time
+    size_t findFrame(uint32_t timeMs) const;
+
+    // Keyframe before/after a frame, for skipping
+    size_t previousKeyframe(size_t index) const;
+    size_t nextKeyframe(size_t index) const;
+
+    // Applies frame `index` to a grid that currently shows frame `current`
+    // (pass getFrameCount() when the grid holds nothing yet)
+    bool seek(size_t current, size_t index, std::vector<FrameCell>& grid) const;
+};
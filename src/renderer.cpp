@@ -0,0 +1,174 @@
+#include "renderer.h"
+
+Renderer::Renderer(Console& console)
+    : console(console), fullRepaint(true), consoleWidth(0), consoleHeight(0), shownTick(0) {
+}
+
+void Renderer::invalidate() {
+    fullRepaint = true;
+}
+
+bool Renderer::checkResize() {
+    int width = 0;
+    int height = 0;
+    console.getConsoleSize(width, height);
+    if (width == consoleWidth && height == consoleHeight) {
+        return false;
+    }
+    consoleWidth = width;
+    consoleHeight = height;
+    return true;
+}
+
+bool Renderer::render(const FrameSnapshot& frame, const Level& level) {
+    if (frame.cells.empty()) {
+        return false;
+    }
+
+    if (checkResize() || fullRepaint || shownCells.size() != frame.cells.size()) {
+        console.clearScreen();
+        drawArena(frame, level);
+        fullRepaint = false;
+        shownTick = frame.tick;
+        return true;
+    }
+
+    if (frame.tick == shownTick) {
+        return false;
+    }
+
+    if (frame.changesFrom == shownTick) {
+        // Changes pick up where the screen is: replaying them in order is exactly what differs
+        for (const CellChange& change : frame.changes) {
+            drawCell(frame, level, change);
+        }
+    } else {
+        // Frames were dropped in between, so compare whole boards
+        for (int y = 1; y <= frame.height; y++) {
+            for (int x = 1; x <= frame.width; x++) {
+                size_t cell = static_cast<size_t>(y - 1) * frame.width + (x - 1);
+                CellKind kind = frame.getCell(x, y);
+                uint8_t links = frame.getLinks(x, y);
+                if (kind != shownCells[cell] || links != shownLinks[cell]) {
+                    drawCell(frame, level, CellChange{ x, y, kind, links });
+                }
+            }
+        }
+    }
+    shownTick = frame.tick;
+    return false;
+}
+
+void Renderer::drawCell(const FrameSnapshot& frame, const Level& level, const CellChange& change) {
+    char ch = ' ';
+    int color = BLACK;
+    getCellGlyph(frame, level, change, ch, color);
+    console.drawGlyph(change.x, change.y, getGlyph(level, change), ch, color);
+    size_t cell = static_cast<size_t>(change.y - 1) * frame.width + (change.x - 1);
+    shownCells[cell] = static_cast<uint8_t>(change.kind);
+    shownLinks[cell] = change.links;
+}
+
+void Renderer::drawArena(const FrameSnapshot& frame, const Level& level) {
+    // Border, then walls and portals inside it (same coordinates as the snake)
+    drawBorder(console, frame.width, frame.height);
+    for (int y = 1; y <= frame.height; y++) {
+        for (int x = 1; x <= frame.width; x++) {
+            if (level.isWall(x, y)) {
+                console.drawGlyph(x, y, GLYPH_WALL, '#', WHITE);
+            }
+        }
+    }
+    for (const Portal& portal : level.getPortals()) {
+        console.drawGlyph(portal.a.x, portal.a.y, GLYPH_PORTAL, '%', BRIGHT_MAGENTA);
+        console.drawGlyph(portal.b.x, portal.b.y, GLYPH_PORTAL, '%', BRIGHT_MAGENTA);
+    }
+
+    // Snake, food and items; the snapshot already has the snake on top
+    shownCells.assign(frame.cells.size(), static_cast<uint8_t>(CELL_EMPTY));
+    shownLinks.assign(frame.cells.size(), 0);
+    for (int y = 1; y <= frame.height; y++) {
+        for (int x = 1; x <= frame.width; x++) {
+            CellKind kind = frame.getCell(x, y);
+            if (kind != CELL_EMPTY) {
+                drawCell(frame, level, CellChange{ x, y, kind, frame.getLinks(x, y) });
+            }
+        }
+    }
+}
+
+void Renderer::drawBorder(Console& console, int width, int height) {
+    int right = width + 1;
+    int bottom = height + 1;
+    for (int x = 1; x < right; x++) {
+        console.drawGlyph(x, 0, GLYPH_BORDER_HORIZONTAL, '#', BRIGHT_WHITE);
+        console.drawGlyph(x, bottom, GLYPH_BORDER_HORIZONTAL, '#', BRIGHT_WHITE);
+    }
+    for (int y = 1; y < bottom; y++) {
+        console.drawGlyph(0, y, GLYPH_BORDER_VERTICAL, '#', BRIGHT_WHITE);
+        console.drawGlyph(right, y, GLYPH_BORDER_VERTICAL, '#', BRIGHT_WHITE);
+    }
+    console.drawGlyph(0, 0, GLYPH_BORDER_TOP_LEFT, '#', BRIGHT_WHITE);
+    console.drawGlyph(right, 0, GLYPH_BORDER_TOP_RIGHT, '#', BRIGHT_WHITE);
+    console.drawGlyph(0, bottom, GLYPH_BORDER_BOTTOM_LEFT, '#', BRIGHT_WHITE);
+    console.drawGlyph(right, bottom, GLYPH_BORDER_BOTTOM_RIGHT, '#', BRIGHT_WHITE);
+}
+
+int Renderer::getGlyph(const Level& level, const CellChange& change) {
+    switch (change.kind) {
+        case CELL_EMPTY:
+            return level.isPortal(change.x, change.y) ? GLYPH_PORTAL : GLYPH_EMPTY;
+        case CELL_SNAKE_HEAD:
+            // The head only links towards where it is going
+            switch (change.links & LINK_HEADWARD) {
+                case LINK_UP: return GLYPH_HEAD_UP;
+                case LINK_DOWN: return GLYPH_HEAD_DOWN;
+                case LINK_LEFT: return GLYPH_HEAD_LEFT;
+                case LINK_RIGHT: return GLYPH_HEAD_RIGHT;
+                default: return GLYPH_HEAD;
+            }
+        case CELL_SNAKE_BODY:
+            // Both ends in one mask: the shape does not care which way is the head
+            return GLYPH_BODY + ((change.links & LINK_HEADWARD) | (change.links >> 4));
+        case CELL_FOOD:
+            return GLYPH_FOOD;
+        default:
+            return GLYPH_ITEM_NORMAL + (change.kind - CELL_ITEM_NORMAL);
+    }
+}
+
+void Renderer::getCellGlyph(const FrameSnapshot& frame, const Level& level, const CellChange& change,
+                            char& ch, int& color) {
+    switch (change.kind) {
+        case CELL_EMPTY:
+            if (level.isPortal(change.x, change.y)) {
+                ch = '%';
+                color = BRIGHT_MAGENTA;
+            } else {
+                ch = ' ';
+                color = BLACK;
+            }
+            break;
+        case CELL_SNAKE_HEAD:
+            ch = 'O';
+            color = BRIGHT_GREEN;
+            break;
+        case CELL_SNAKE_BODY:
+            ch = 'o';
+            color = BRIGHT_GREEN;
+            break;
+        case CELL_FOOD:
+            ch = frame.foodSymbol;
+            color = frame.foodColor;
+            break;
+        case CELL_ITEM_NORMAL:
+        case CELL_ITEM_BONUS:
+        case CELL_ITEM_SHRINK:
+        case CELL_ITEM_SPEED: {
+            FoodKind kind = static_cast<FoodKind>(change.kind - CELL_ITEM_NORMAL);
+            ch = FoodField::getSymbol(kind);
+            color = FoodField::getColor(kind);
+            break;
+        }
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "console.h"
+#include "frame_snapshot.h"
+#include "level.h"
+#include <cstdint>
+#include <vector>
+
+// Draws the play area from published frame snapshots. After one full repaint
+// it only applies the cell changes reported for each tick, so the cost per
+// frame does not grow with the board area or the snake length. When frames
+// were skipped it diffs against what is on screen instead.
+class Renderer {
+private:
+    Console& console;
+    bool fullRepaint;
+    int consoleWidth;
+    int consoleHeight;
+    uint64_t shownTick;
+    std::vector<uint8_t> shownCells; // CellKind currently on screen
+    std::vector<uint8_t> shownLinks; // CellLink bits they were drawn with
+
+    void drawArena(const FrameSnapshot& frame, const Level& level);
+    void drawCell(const FrameSnapshot& frame, const Level& level, const CellChange& change);
+    bool checkResize();
+
+public:
+    explicit Renderer(Console& console);
+
+    // Forces a full repaint on the next render (new game, after menus)
+    void invalidate();
+
+    // Returns true if the whole screen was repainted (so the HUD needs redrawing too)
+    bool render(const FrameSnapshot& frame, const Level& level);
+
+    // Themed glyph for a changed cell, and its classic character and color
+    static int getGlyph(const Level& level, const CellChange& change);
+    static void getCellGlyph(const FrameSnapshot& frame, const Level& level, const CellChange& change,
+                             char& ch, int& color);
+
+    // Frame around a play area of the given size, at the top left corner
+    static void drawBorder(Console& console, int width, int height);
+};
@@ -0,0 +1,73 @@
+#pragma once
+#include "snake.h"
+
+enum Difficulty {
+    EASY,
+    NORMAL,
+    HARD
+};
+
+// Rule sets selectable from the menu; each maps to one Rules<> instantiation
+enum GameMode {
+    MODE_CLASSIC,
+    MODE_WRAP,
+    MODE_MARATHON,
+    MODE_COUNT
+};
+
+enum DeathCause {
+    DEATH_NONE,
+    DEATH_WALL,
+    DEATH_SELF,
+    DEATH_OBSTACLE
+};
+
+// Boundary policies: adjust the new head position and report whether it survives
+
+// Hitting the border kills the snake
+struct WallDeath {
+    static bool resolve(Position& head, int width, int height) {
+        return head.x >= 1 && head.x <= width && head.y >= 1 && head.y <= height;
+    }
+};
+
+// The play area is a torus - leaving one side enters from the opposite side
+struct WallWrap {
+    static bool resolve(Position& head, int width, int height) {
+        if (head.x < 1) head.x = width;
+        else if (head.x > width) head.x = 1;
+        if (head.y < 1) head.y = height;
+        else if (head.y > height) head.y = 1;
+        return true;
+    }
+};
+
+// Growth policy: segments added per food eaten
+template <int Segments>
+struct GrowBy {
+    static constexpr int segments = Segments;
+};
+
+// Speed curves: level 1 frame delay (in 10 ms loop ticks) indexed by
+// Difficulty, and how many percent faster each further level runs
+struct ClassicSpeed {
+    static constexpr int frameDelays[3] = { 8, 6, 4 };
+    static constexpr int levelSpeedup = 20;
+};
+
+struct RelaxedSpeed {
+    static constexpr int frameDelays[3] = { 10, 8, 6 };
+    static constexpr int levelSpeedup = 15;
+};
+
+// A complete rule set, resolved at compile time
+template <class Boundary, class Growth, class Speed>
+struct Rules {
+    using BoundaryPolicy = Boundary;
+    using GrowthPolicy = Growth;
+    using SpeedPolicy = Speed;
+};
+
+using ClassicRules = Rules<WallDeath, GrowBy<1>, ClassicSpeed>;
+using WrapRules = Rules<WallWrap, GrowBy<1>, ClassicSpeed>;
+using MarathonRules = Rules<WallDeath, GrowBy<3>, RelaxedSpeed>;
@@ -0,0 +1,98 @@
+#include "score_store.h"
+#include <chrono>
+
+ScoreStore::ScoreStore() : running(false), compactRequested(false), savedCount(0), failedCount(0) {
+}
+
+ScoreStore::~ScoreStore() {
+    stop();
+}
+
+void ScoreStore::start() {
+    if (running) {
+        return;
+    }
+    running = true;
+    compactRequested = true; // Clean up after any crash in an earlier run
+    worker = std::thread(&ScoreStore::workerLoop, this);
+}
+
+void ScoreStore::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) {
+            return;
+        }
+        running = false;
+    }
+    ready.notify_one();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void ScoreStore::submit(const HighScore& score) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) {
+            // No worker (not started or shutting down): write synchronously
+            if (Utils::saveHighScore(score)) {
+                savedCount++;
+            } else {
+                failedCount++;
+            }
+            return;
+        }
+        pending.push_back(score);
+    }
+    ready.notify_one();
+}
+
+void ScoreStore::workerLoop() {
+    size_t sinceCompaction = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        ready.wait(lock, [this] { return !running || !pending.empty() || compactRequested; });
+
+        // Group commit: let scores arriving shortly after join this batch
+        if (!pending.empty() && running) {
+            ready.wait_for(lock, std::chrono::milliseconds(BATCH_WINDOW_MS), [this] { return !running; });
+        }
+
+        std::vector<HighScore> batch;
+        batch.swap(pending);
+        bool compact = compactRequested;
+        compactRequested = false;
+        bool finished = !running;
+        lock.unlock();
+
+        if (!batch.empty()) {
+            if (Utils::appendHighScores(batch)) {
+                savedCount += batch.size();
+            } else {
+                failedCount += batch.size();
+            }
+            sinceCompaction += batch.size();
+            if (sinceCompaction >= COMPACT_AFTER) {
+                compact = true;
+            }
+        }
+        if (compact) {
+            Utils::compactHighScores(MAX_RECORDS);
+            sinceCompaction = 0;
+        }
+
+        lock.lock();
+        if (finished && pending.empty()) {
+            break;
+        }
+    }
+}
+
+size_t ScoreStore::getSavedCount() const {
+    return savedCount;
+}
+
+size_t ScoreStore::getFailedCount() const {
+    return failedCount;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "utils.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Saves high scores from a background thread so the game never waits on
+// fsync. Scores that arrive close together go out as one locked append
+// with one fsync, and the file is compacted (damaged records dropped, size
+// capped, rewritten atomically) at startup and after every few hundred
+// appends.
+class ScoreStore {
+private:
+    static const size_t MAX_RECORDS = 10000;
+    static constexpr int BATCH_WINDOW_MS = 200;
+    static const size_t COMPACT_AFTER = 256; // Appended records between compactions
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::vector<HighScore> pending;
+    bool running;
+    bool compactRequested;
+    std::atomic<size_t> savedCount;
+    std::atomic<size_t> failedCount;
+
+    void workerLoop();
+
+public:
+    ScoreStore();
+    ~ScoreStore();
+
+    // Lifecycle; stop() writes anything still pending
+    void start();
+    void stop();
+
+    // Game thread API - never blocks on disk
+    void submit(const HighScore& score);
+
+    // Statistics
+    size_t getSavedCount() const;
+    size_t getFailedCount() const;
+};
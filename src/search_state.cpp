@@ -0,0 +1,251 @@
+#include "search_state.h"
+#include "zobrist.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+    bool isReverse(Direction current, Direction dir) {
+        return (current == UP && dir == DOWN) || (current == DOWN && dir == UP) ||
+               (current == LEFT && dir == RIGHT) || (current == RIGHT && dir == LEFT);
+    }
+
+    void advance(Position& pos, Direction dir) {
+        switch (dir) {
+            case UP:
+                pos.y--;
+                break;
+            case DOWN:
+                pos.y++;
+                break;
+            case LEFT:
+                pos.x--;
+                break;
+            case RIGHT:
+                pos.x++;
+                break;
+        }
+    }
+}
+
+SearchState::SearchState()
+    : level(nullptr), width(0), height(0), wrap(false), growth(1), maxDepth(0),
+      start(0), length(0), pendingGrowth(0), direction(RIGHT), alive(false), foodEaten(0),
+      cellHash(0) {
+}
+
+void SearchState::load(const Simulation& sim, int depth, uint64_t seed) {
+    level = &sim.getLevel();
+    width = sim.getWidth();
+    height = sim.getHeight();
+    wrap = sim.getMode() == MODE_WRAP;
+    growth = sim.getGrowthSegments();
+    maxDepth = depth;
+
+    // Moves write new heads in front of the body, so the ring needs room for
+    // the longest snake plus every move that can be outstanding
+    size_t capacity = static_cast<size_t>(width) * height + static_cast<size_t>(depth) + 1;
+    if (ring.size() != capacity) {
+        ring.assign(capacity, Position());
+    }
+    const Snake& snake = sim.getSnake();
+    cellHash = 0;
+    size_t count = 0;
+    snake.forEachSegment([&](const Position& segment) {
+        ring[count++] = segment;
+        cellHash ^= Zobrist::key(ZOBRIST_BODY, segment.x, segment.y);
+    });
+    start = 0;
+    length = static_cast<int>(count);
+    pendingGrowth = snake.getPendingGrowth();
+    direction = snake.getDirection();
+
+    occupancy = sim.getOccupancy();
+    food = sim.getFood();
+    random.setSeed(seed);
+    alive = true;
+    foodEaten = 0;
+    undoLog.clear();
+    undoLog.reserve(static_cast<size_t>(depth));
+    measureFoodPaths();
+}
+
+void SearchState::measureFoodPaths() {
+    size_t cells = static_cast<size_t>(width) * height;
+    foodPaths.assign(cells, NO_PATH);
+    if (!food.isActive()) {
+        return;
+    }
+
+    // Breadth-first from the pellet; the head's own cell is reachable so
+    // the snake can measure from where it stands
+    Position head = segment(0);
+    Position goal = food.getPosition();
+    frontier.clear();
+    frontier.reserve(cells);
+    frontier.push_back((goal.y - 1) * width + (goal.x - 1));
+    foodPaths[frontier[0]] = 0;
+    for (size_t i = 0; i < frontier.size(); ++i) {
+        int cell = frontier[i];
+        for (int dir = UP; dir <= RIGHT; ++dir) {
+            Position next(cell % width + 1, cell / width + 1);
+            advance(next, static_cast<Direction>(dir));
+            if (!resolve(next)) {
+                continue;
+            }
+            int index = (next.y - 1) * width + (next.x - 1);
+            if (foodPaths[index] != NO_PATH) {
+                continue;
+            }
+            if (!(next == head) && occupancy.testUnion(level->getWalls(), next.x - 1, next.y - 1)) {
+                continue;
+            }
+            foodPaths[index] = foodPaths[cell] + 1;
+            frontier.push_back(index);
+        }
+    }
+
+    // Walled off by the body for now; it moves, so aim straight for the pellet
+    if (foodPaths[(head.y - 1) * width + (head.x - 1)] == NO_PATH) {
+        foodPaths.clear();
+    }
+}
+
+bool SearchState::resolve(Position& pos) const {
+    return wrap ? WallWrap::resolve(pos, width, height) : WallDeath::resolve(pos, width, height);
+}
+
+bool SearchState::step(Direction dir) {
+    Undo record = { start, length, pendingGrowth, direction, food, Position(), false, false, alive, foodEaten, cellHash };
+    if (!alive) {
+        undoLog.push_back(record);
+        return false;
+    }
+
+    if (!isReverse(direction, dir)) {
+        direction = dir;
+    }
+    Position head = segment(0);
+    advance(head, direction);
+    bool inside = resolve(head);
+    if (inside && level->isPortal(head.x, head.y)) {
+        head = level->getPortalExit(head);
+    }
+
+    // New head in front; the tail moves out unless the snake is growing
+    int capacity = static_cast<int>(ring.size());
+    start = (start + capacity - 1) % capacity;
+    ring[start] = head;
+    cellHash ^= Zobrist::key(ZOBRIST_BODY, head.x, head.y);
+    if (pendingGrowth == 0) {
+        record.tail = segment(length);
+        record.tailMoved = true;
+        cellHash ^= Zobrist::key(ZOBRIST_BODY, record.tail.x, record.tail.y);
+        occupancy.reset(record.tail.x - 1, record.tail.y - 1);
+    } else {
+        pendingGrowth--;
+        length++;
+    }
+
+    if (!inside || occupancy.testUnion(level->getWalls(), head.x - 1, head.y - 1)) {
+        alive = false;
+    } else {
+        occupancy.set(head.x - 1, head.y - 1);
+        record.headPlaced = true;
+        if (food.checkCollision(head.x, head.y)) {
+            foodEaten++;
+            pendingGrowth += growth;
+            food.generate(width, height, occupancy, level->getFoodBlocked(), random);
+        }
+    }
+
+    undoLog.push_back(record);
+    return alive;
+}
+
+void SearchState::undo() {
+    const Undo& record = undoLog.back();
+    if (record.headPlaced) {
+        Position head = segment(0);
+        occupancy.reset(head.x - 1, head.y - 1);
+    }
+    if (record.tailMoved) {
+        occupancy.set(record.tail.x - 1, record.tail.y - 1);
+    }
+    start = record.start;
+    length = record.length;
+    pendingGrowth = record.pendingGrowth;
+    direction = record.direction;
+    food = record.food;
+    alive = record.alive;
+    foodEaten = record.foodEaten;
+    cellHash = record.cellHash;
+    undoLog.pop_back();
+}
+
+void SearchState::undoTo(int depth) {
+    while (getDepth() > depth) {
+        undo();
+    }
+}
+
+bool SearchState::isSafe(Direction dir) const {
+    if (!alive) {
+        return false;
+    }
+    Direction heading = isReverse(direction, dir) ? direction : dir;
+    Position head = segment(0);
+    advance(head, heading);
+    if (!resolve(head)) {
+        return false;
+    }
+    if (level->isPortal(head.x, head.y)) {
+        head = level->getPortalExit(head);
+    }
+
+    // The tail cell frees up this tick unless the snake is growing
+    if (pendingGrowth == 0 && head == segment(length - 1)) {
+        return true;
+    }
+    return !occupancy.testUnion(level->getWalls(), head.x - 1, head.y - 1);
+}
+
+int SearchState::distanceToFood(const Position& from) const {
+    if (!food.isActive()) {
+        return -1;
+    }
+    if (foodEaten == 0 && !foodPaths.empty()) {
+        return foodPaths[(from.y - 1) * width + (from.x - 1)];
+    }
+    int dx = std::abs(food.getPosition().x - from.x);
+    int dy = std::abs(food.getPosition().y - from.y);
+    if (wrap) {
+        dx = std::min(dx, width - dx);
+        dy = std::min(dy, height - dy);
+    }
+    return dx + dy;
+}
+
+int SearchState::getFoodDistance() const {
+    return distanceToFood(segment(0));
+}
+
+int SearchState::getFoodDistance(Direction dir) const {
+    Position next = segment(0);
+    advance(next, isReverse(direction, dir) ? direction : dir);
+    if (!resolve(next)) {
+        return NO_PATH;
+    }
+    return distanceToFood(next);
+}
+
+uint64_t SearchState::getHash() const {
+    Position head = segment(0);
+    Position tail = segment(length - 1);
+    uint64_t hash = cellHash ^ Zobrist::key(ZOBRIST_HEAD, head.x, head.y) ^ Zobrist::key(ZOBRIST_TAIL, tail.x, tail.y) ^
+                    Zobrist::key(ZOBRIST_DIRECTION, static_cast<uint64_t>(direction)) ^
+                    Zobrist::key(ZOBRIST_GROWTH, static_cast<uint64_t>(pendingGrowth));
+    if (food.isActive()) {
+        hash ^= Zobrist::key(ZOBRIST_FOOD, food.getPosition().x, food.getPosition().y);
+    }
+    return hash;
+}
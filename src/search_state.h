@@ -0,0 +1,98 @@
+#pragma once
+#include "simulation.h"
+#include <vector>
+
+// Compact copy of the world for look-ahead search. The body is a ring buffer
+// and every step pushes a small undo record, so trying a move and taking it
+// back are both O(1). A search loads the state once per thread and from then
+// on only applies and undoes moves, never copying the snake.
+//
+// Follows the simulation's rules for movement, walls, portals, growth and
+// food placement; extra food items are not modelled.
+class SearchState {
+private:
+    struct Undo {
+        int start;
+        int length;
+        int pendingGrowth;
+        Direction direction;
+        Food food;
+        Position tail;    // Cell the tail left, if it moved
+        bool tailMoved;
+        bool headPlaced;  // Whether the new head was added to occupancy
+        bool alive;
+        int foodEaten;
+        uint64_t cellHash;
+    };
+
+    const Level* level;
+    int width;
+    int height;
+    bool wrap;
+    int growth;       // Segments per food under the active rules
+    int maxDepth;
+
+    std::vector<Position> ring; // Body, head at `start`, wrapping around
+    int start;
+    int length;
+    int pendingGrowth;
+    Direction direction;
+    Bitboard occupancy;
+    Food food;
+    Random random;
+    bool alive;
+    int foodEaten;
+    uint64_t cellHash; // XOR of the segments' Zobrist keys
+    std::vector<Undo> undoLog;
+
+    // Steps to the loaded pellet from every cell, around walls and the body
+    // as they were at load(); NO_PATH where it cannot be reached, and empty
+    // when the head cannot reach it
+    std::vector<int> foodPaths;
+    std::vector<int> frontier;
+
+    const Position& segment(int index) const { return ring[(start + index) % ring.size()]; }
+    bool resolve(Position& pos) const;
+    void measureFoodPaths();
+    int distanceToFood(const Position& from) const;
+
+public:
+    static constexpr int NO_PATH = 1 << 20;
+
+    SearchState();
+
+    // Copies the simulation; at most `depth` moves can be outstanding at once
+    void load(const Simulation& sim, int depth, uint64_t seed);
+
+    // Moves one tick (reversing keeps the heading, like the game); returns alive
+    bool step(Direction dir);
+    void undo();
+    void undoTo(int depth);
+
+    // Whether moving this way survives the next tick
+    bool isSafe(Direction dir) const;
+
+    // Steps from the head, or from the cell one move this way, to the pellet;
+    // -1 without a pellet. Until the loaded pellet is eaten this is the path
+    // around walls and the body as they were at load() (NO_PATH if there is
+    // none), after that - or if the head had no path at all - the distance
+    // with nothing in between. Both cross the edges when they wrap; portals
+    // are not taken into account.
+    int getFoodDistance() const;
+    int getFoodDistance(Direction dir) const;
+
+    int getDepth() const { return static_cast<int>(undoLog.size()); }
+    int getMaxDepth() const { return maxDepth; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    bool isAlive() const { return alive; }
+    int getFoodEaten() const { return foodEaten; }
+    int getLength() const { return length; }
+    Direction getDirection() const { return direction; }
+    Position getHead() const { return segment(0); }
+
+    // Zobrist hash of the position for transposition tables. Same keys as
+    // Simulation::getHash() but without the random stream (search samples
+    // food placement) and without extra items.
+    uint64_t getHash() const;
+};
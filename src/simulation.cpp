@@ -0,0 +1,440 @@
+#include "simulation.h"
+#include "zobrist.h"
+#include <algorithm>
+
+Simulation::Simulation(int width, int height)
+    : snake(width / 2, height / 2), trackChanges(false), trackLinks(false), width(width), height(height),
+      mode(MODE_CLASSIC), stepFunction(nullptr), frameDelays(nullptr), levelSpeedup(0), growthSegments(1) {
+    // The body can cover the whole board; reserving that now keeps every tick allocation-free
+    snake.reserve(width * height);
+    setMode(MODE_CLASSIC);
+    setExtraFood(0, 0);
+    clearLevel();
+}
+
+template <class R>
+StepResult Simulation::stepWithRules(Simulation& sim) {
+    StepResult result = { true, false, 0, FOOD_NORMAL, DEATH_NONE };
+
+    Position head = sim.snake.getNextHead();
+    bool inside = R::BoundaryPolicy::resolve(head, sim.width, sim.height);
+    if (inside && sim.level.isPortal(head.x, head.y)) {
+        head = sim.level.getPortalExit(head);
+    }
+
+    Position oldHead = sim.snake.getHead();
+    Position tail = sim.snake.getTail();
+    int length = sim.snake.getLength();
+    sim.snake.move(head);
+
+    // The tail moves out before the head moves in
+    if (sim.snake.getLength() == length) {
+        sim.occupancy.reset(tail.x - 1, tail.y - 1);
+        sim.emit(tail, CELL_EMPTY);
+        sim.unlinkTail();
+    }
+
+    // The old head now leads on to the new one; a portal jump still links
+    // it the way it went, into the portal
+    Direction heading = sim.snake.getDirection();
+    if (sim.trackLinks) {
+        uint8_t tailward = sim.links[static_cast<size_t>(oldHead.y - 1) * sim.width + (oldHead.x - 1)] & LINK_TAILWARD;
+        sim.emit(oldHead, CELL_SNAKE_BODY, static_cast<uint8_t>(linkTowards(heading) | tailward));
+    } else {
+        sim.emit(oldHead, CELL_SNAKE_BODY);
+    }
+
+    if (!inside) {
+        result.alive = false;
+        result.cause = DEATH_WALL;
+        return result;
+    }
+    sim.emit(head, CELL_SNAKE_HEAD, static_cast<uint8_t>(linkTowards(heading) | linkBack(heading)));
+
+    // One bit test covers both the snake body and every level wall
+    if (sim.occupancy.testUnion(sim.level.getWalls(), head.x - 1, head.y - 1)) {
+        result.alive = false;
+        result.cause = sim.level.isWall(head.x, head.y) ? DEATH_OBSTACLE : DEATH_SELF;
+        return result;
+    }
+    sim.occupancy.set(head.x - 1, head.y - 1);
+
+    if (sim.food.checkCollision(head.x, head.y)) {
+        result.ateFood = true;
+        result.points = sim.food.getPoints();
+        sim.snake.grow(R::GrowthPolicy::segments);
+        sim.food.generate(sim.width, sim.height, sim.occupancy, sim.level.getFoodBlocked(), sim.random);
+        if (sim.food.isActive()) {
+            sim.emit(sim.food.getPosition(), CELL_FOOD);
+        }
+    }
+
+    // Extra items: one cell lookup regardless of how many are out
+    FoodItem item;
+    if (sim.items.consume(head.x, head.y, item)) {
+        result.ateFood = true;
+        result.points += item.points;
+        result.foodKind = item.kind;
+        if (item.kind == FOOD_SHRINK) {
+            sim.shrinkSnake(3);
+        } else {
+            sim.snake.grow(R::GrowthPolicy::segments);
+        }
+    }
+    sim.updateItems();
+
+    return result;
+}
+
+void Simulation::setMode(GameMode newMode) {
+    mode = newMode;
+    switch (mode) {
+        case MODE_WRAP:
+            stepFunction = &stepWithRules<WrapRules>;
+            frameDelays = WrapRules::SpeedPolicy::frameDelays;
+            levelSpeedup = WrapRules::SpeedPolicy::levelSpeedup;
+            growthSegments = WrapRules::GrowthPolicy::segments;
+            break;
+        case MODE_MARATHON:
+            stepFunction = &stepWithRules<MarathonRules>;
+            frameDelays = MarathonRules::SpeedPolicy::frameDelays;
+            levelSpeedup = MarathonRules::SpeedPolicy::levelSpeedup;
+            growthSegments = MarathonRules::GrowthPolicy::segments;
+            break;
+        case MODE_CLASSIC:
+        default:
+            mode = MODE_CLASSIC;
+            stepFunction = &stepWithRules<ClassicRules>;
+            frameDelays = ClassicRules::SpeedPolicy::frameDelays;
+            levelSpeedup = ClassicRules::SpeedPolicy::levelSpeedup;
+            growthSegments = ClassicRules::GrowthPolicy::segments;
+            break;
+    }
+}
+
+GameMode Simulation::getMode() const {
+    return mode;
+}
+
+const char* Simulation::getModeName(GameMode mode) {
+    switch (mode) {
+        case MODE_CLASSIC:
+            return "Classic";
+        case MODE_WRAP:
+            return "Wrap Around";
+        case MODE_MARATHON:
+            return "Marathon";
+        default:
+            break;
+    }
+    return "Unknown";
+}
+
+const char* Simulation::getModeKey(GameMode mode) {
+    switch (mode) {
+        case MODE_WRAP:
+            return "wrap";
+        case MODE_MARATHON:
+            return "marathon";
+        case MODE_CLASSIC:
+        default:
+            break;
+    }
+    return "classic";
+}
+
+bool Simulation::findMode(const std::string& key, GameMode& mode) {
+    for (int i = 0; i < MODE_COUNT; i++) {
+        if (key == getModeKey(static_cast<GameMode>(i))) {
+            mode = static_cast<GameMode>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+void Simulation::shrinkSnake(int segments) {
+    int removed = 0;
+    for (; removed < segments; ++removed) {
+        Position tail = snake.getTail();
+        if (!snake.removeTail()) {
+            break;
+        }
+        occupancy.reset(tail.x - 1, tail.y - 1);
+        emit(tail, CELL_EMPTY);
+    }
+    if (removed > 0) {
+        unlinkTail();
+    }
+}
+
+void Simulation::unlinkTail() {
+    // The segment that is now last has nothing behind it
+    if (trackLinks) {
+        Position tail = snake.getTail();
+        size_t cell = static_cast<size_t>(tail.y - 1) * width + (tail.x - 1);
+        emit(tail, CELL_SNAKE_BODY, static_cast<uint8_t>(links[cell] & LINK_HEADWARD));
+    }
+}
+
+uint8_t Simulation::linkBetween(const Position& from, const Position& to) const {
+    // Neighbours across a wrap-around edge count; cells joined by a portal do not
+    int dx = to.x - from.x;
+    int dy = to.y - from.y;
+    if (mode == MODE_WRAP) {
+        dx = dx == width - 1 ? -1 : dx == 1 - width ? 1 : dx;
+        dy = dy == height - 1 ? -1 : dy == 1 - height ? 1 : dy;
+    }
+    if (dx == 0 && dy == -1) {
+        return LINK_UP;
+    }
+    if (dx == 0 && dy == 1) {
+        return LINK_DOWN;
+    }
+    if (dx == -1 && dy == 0) {
+        return LINK_LEFT;
+    }
+    if (dx == 1 && dy == 0) {
+        return LINK_RIGHT;
+    }
+    return 0;
+}
+
+void Simulation::updateItems() {
+    // The main pellet is drawn above any item sharing its cell
+    items.tick();
+    for (const Position& pos : items.getExpired()) {
+        emit(pos, food.checkCollision(pos.x, pos.y) ? CELL_FOOD : CELL_EMPTY);
+    }
+    
+    if (itemInterval == 0 || --itemCountdown > 0) {
+        return;
+    }
+    itemCountdown = itemInterval;
+    
+    FoodKind kind = static_cast<FoodKind>(random.range(0, FOOD_KIND_COUNT - 1));
+    int lifetime = kind == FOOD_NORMAL ? 0 : itemLifetime;
+    Position placed;
+    if (items.spawnRandom(kind, occupancy, level.getFoodBlocked(), lifetime, random, placed) &&
+        !food.checkCollision(placed.x, placed.y)) {
+        emit(placed, cellKindForItem(kind));
+    }
+}
+
+void Simulation::setExtraFood(int maxItems, int spawnInterval, int lifetime) {
+    items.resize(width, height, maxItems);
+    itemInterval = maxItems > 0 ? spawnInterval : 0;
+    itemCountdown = itemInterval;
+    itemLifetime = lifetime;
+}
+
+void Simulation::setChangeTracking(bool enabled) {
+    trackChanges = enabled;
+    changes.clear();
+    if (enabled) {
+        changes.reserve(CHANGE_CAPACITY);
+        rebuildCells();
+    }
+}
+
+void Simulation::setLinkTracking(bool enabled) {
+    trackLinks = enabled;
+    if (trackChanges) {
+        rebuildCells();
+    }
+}
+
+void Simulation::rebuildCells() {
+    cells.assign(static_cast<size_t>(width) * height, static_cast<uint8_t>(CELL_EMPTY));
+    links.assign(trackLinks ? cells.size() : 0, 0);
+    auto mark = [this](const Position& pos, CellKind kind) {
+        cells[static_cast<size_t>(pos.y - 1) * width + (pos.x - 1)] = static_cast<uint8_t>(kind);
+    };
+    
+    // Same layering as a full repaint: items, food, then the snake on top
+    for (const FoodItem& item : items.getItems()) {
+        if (item.active) {
+            mark(item.position, cellKindForItem(item.kind));
+        }
+    }
+    if (food.isActive()) {
+        mark(food.getPosition(), CELL_FOOD);
+    }
+    // Tail first, so the head is marked last
+    bool started = false;
+    Position pending;
+    snake.forEachSegmentFromTail([&](const Position& segment) {
+        mark(segment, CELL_SNAKE_BODY);
+        pending = segment;
+        started = true;
+    });
+    if (!started) {
+        return;
+    }
+    mark(pending, CELL_SNAKE_HEAD);
+    if (!trackLinks) {
+        return;
+    }
+    
+    // Tail first; each segment is linked once the next one towards the head is known
+    auto link = [this](const Position& pos, uint8_t cellLinks) {
+        links[static_cast<size_t>(pos.y - 1) * width + (pos.x - 1)] = cellLinks;
+    };
+    started = false;
+    uint8_t pendingTailward = 0;
+    snake.forEachSegmentFromTail([&](const Position& segment) {
+        if (started) {
+            link(pending, static_cast<uint8_t>(linkBetween(pending, segment) | pendingTailward << 4));
+            pendingTailward = linkBetween(segment, pending);
+        }
+        pending = segment;
+        started = true;
+    });
+    link(pending, static_cast<uint8_t>(linkTowards(snake.getDirection()) | pendingTailward << 4));
+}
+
+void Simulation::captureFrame(FrameSnapshot& frame) const {
+    // assign() reuses the snapshot's storage, so steady-state captures do not allocate;
+    // reserving as much as the change list has means a busy tick does not either
+    if (frame.changes.capacity() < changes.capacity()) {
+        frame.changes.reserve(changes.capacity());
+    }
+    frame.width = width;
+    frame.height = height;
+    frame.cells.assign(cells.begin(), cells.end());
+    frame.links.assign(links.begin(), links.end());
+    frame.changes.assign(changes.begin(), changes.end());
+    frame.foodSymbol = food.getSymbol();
+    frame.foodColor = food.getColor();
+}
+
+const std::vector<CellChange>& Simulation::getChanges() const {
+    return changes;
+}
+
+void Simulation::clearChanges() {
+    changes.clear();
+}
+
+const FoodField& Simulation::getItems() const {
+    return items;
+}
+
+bool Simulation::loadLevel(const std::string& filename) {
+    Level loaded;
+    if (!loaded.load(filename)) {
+        return false;
+    }
+    if (loaded.getWidth() != width || loaded.getHeight() != height) {
+        return false;
+    }
+    level = loaded;
+    return true;
+}
+
+void Simulation::clearLevel() {
+    level.makeEmpty(width, height);
+}
+
+const Level& Simulation::getLevel() const {
+    return level;
+}
+
+void Simulation::seed(uint64_t value) {
+    random.setSeed(value);
+}
+
+uint64_t Simulation::getHash() const {
+    uint64_t hash = snake.getHash() ^ items.getHash() ^ Zobrist::key(ZOBRIST_RANDOM, random.getState());
+    if (food.isActive()) {
+        hash ^= Zobrist::key(ZOBRIST_FOOD, food.getPosition().x, food.getPosition().y);
+    }
+    if (itemInterval > 0) {
+        hash ^= Zobrist::key(ZOBRIST_COUNTDOWN, static_cast<uint64_t>(itemCountdown));
+    }
+    return hash;
+}
+
+void Simulation::reset() {
+    Position spawn = level.getSpawn(width / 2, height / 2);
+    snake.reset(spawn.x, spawn.y);
+    
+    occupancy.resize(width, height);
+    snake.forEachSegment([this](const Position& segment) {
+        occupancy.set(segment.x - 1, segment.y - 1);
+    });
+    
+    food.reset();
+    food.generate(width, height, occupancy, level.getFoodBlocked(), random);
+    
+    items.clear();
+    itemCountdown = itemInterval;
+    
+    // Everything is redrawn after a reset
+    changes.clear();
+    if (trackChanges) {
+        rebuildCells();
+    }
+}
+
+void Simulation::restore(const std::vector<Position>& body, Direction direction, const Position& foodPosition,
+                         int pendingGrowth) {
+    snake.restore(body, direction, pendingGrowth);
+    
+    occupancy.resize(width, height);
+    for (const Position& segment : body) {
+        occupancy.set(segment.x - 1, segment.y - 1);
+    }
+    
+    food.setPosition(foodPosition.x, foodPosition.y);
+    food.setActive(true);
+    
+    items.clear();
+    itemCountdown = itemInterval;
+    
+    changes.clear();
+    if (trackChanges) {
+        rebuildCells();
+    }
+}
+
+int Simulation::getTickInterval(Difficulty difficulty, int level) const {
+    // Geometric curve: every level runs levelSpeedup percent faster
+    double interval = frameDelays[difficulty] * 10000.0;
+    for (int i = 1; i < level && interval > MIN_TICK_INTERVAL; i++) {
+        interval = interval * 100.0 / (100 + levelSpeedup);
+    }
+    return std::max(static_cast<int>(interval), static_cast<int>(MIN_TICK_INTERVAL));
+}
+
+int Simulation::getGrowthSegments() const {
+    return growthSegments;
+}
+
+Snake& Simulation::getSnake() {
+    return snake;
+}
+
+const Snake& Simulation::getSnake() const {
+    return snake;
+}
+
+Food& Simulation::getFood() {
+    return food;
+}
+
+const Food& Simulation::getFood() const {
+    return food;
+}
+
+const Bitboard& Simulation::getOccupancy() const {
+    return occupancy;
+}
+
+int Simulation::getWidth() const {
+    return width;
+}
+
+int Simulation::getHeight() const {
+    return height;
+}
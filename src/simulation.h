@@ -0,0 +1,139 @@
+#pragma once
+#include "rules.h"
+#include "snake.h"
+#include "food.h"
+#include "food_field.h"
+#include "level.h"
+#include "bitboard.h"
+#include "cell_change.h"
+#include "frame_snapshot.h"
+#include <string>
+
+// Outcome of a single simulation tick
+struct StepResult {
+    bool alive;
+    bool ateFood;
+    int points;
+    FoodKind foodKind; // What was eaten (main pellet counts as FOOD_NORMAL)
+    DeathCause cause;
+};
+
+// Game world (snake, food, level, play area) advanced one tick at a time.
+// The step function is chosen once per mode, so the tick itself never
+// branches on which rules are active.
+class Simulation {
+public:
+    using StepFunction = StepResult (*)(Simulation&);
+    
+    // Narrowest board a driver should build: the three starting segments
+    // sit at width / 2 and the two cells to its left
+    static const int MIN_WIDTH = 6;
+
+private:
+    Snake snake;
+    Food food;
+    FoodField items;    // Extra food on top of the main pellet
+    int itemInterval;   // Ticks between extra food spawns (0 = none)
+    int itemCountdown;
+    int itemLifetime;   // Ticks before timed items expire
+    Level level;
+    Bitboard occupancy; // Cells covered by the snake body
+    Random random;      // Food and item placement
+    std::vector<CellChange> changes; // Cells changed since the last clearChanges()
+    std::vector<uint8_t> cells;      // CellKind per cell, kept current while tracking
+    std::vector<uint8_t> links;      // CellLink bits per snake cell, kept current while tracking links
+    bool trackChanges;
+    bool trackLinks;
+    int width;
+    int height;
+    GameMode mode;
+    StepFunction stepFunction;
+    const int* frameDelays;
+    int levelSpeedup;
+    int growthSegments;
+
+    template <class R>
+    static StepResult stepWithRules(Simulation& sim);
+    void shrinkSnake(int segments);
+    void updateItems();
+    void rebuildCells();
+    uint8_t linkBetween(const Position& from, const Position& to) const;
+    void unlinkTail();
+    void emit(const Position& pos, CellKind kind, uint8_t cellLinks = 0) {
+        if (trackChanges) {
+            size_t cell = static_cast<size_t>(pos.y - 1) * width + (pos.x - 1);
+            changes.push_back(CellChange{ pos.x, pos.y, kind, cellLinks });
+            cells[cell] = static_cast<uint8_t>(kind);
+            if (trackLinks) {
+                links[cell] = cellLinks;
+            }
+        }
+    }
+
+public:
+    Simulation(int width, int height);
+
+    // Rule selection
+    void setMode(GameMode newMode);
+    GameMode getMode() const;
+    static const char* getModeName(GameMode mode);
+    static const char* getModeKey(GameMode mode);                  // "classic", "wrap", "marathon"
+    static bool findMode(const std::string& key, GameMode& mode); // From a key, for command lines
+
+    // Level management
+    bool loadLevel(const std::string& filename);
+    void clearLevel();
+    const Level& getLevel() const;
+    
+    // Extra food (maxItems 0 disables it)
+    void setExtraFood(int maxItems, int spawnInterval, int lifetime = 100);
+    const FoodField& getItems() const;
+    
+    // Change events for incremental rendering (off by default). Room for
+    // CHANGE_CAPACITY events is reserved up front: several turbo ticks' worth
+    // between two frames.
+    static const int CHANGE_CAPACITY = 256;
+    void setChangeTracking(bool enabled);
+    const std::vector<CellChange>& getChanges() const;
+    void clearChanges();
+    
+    // Segment links on snake cells and their changes, for themed renderers
+    // that join the body up (off by default; needs change tracking). Without
+    // them snake cells carry no links and snapshots no link layer.
+    void setLinkTracking(bool enabled);
+    
+    // Copies the board and this tick's changes (needs change tracking)
+    void captureFrame(FrameSnapshot& frame) const;
+    
+    // World management
+    void seed(uint64_t value);
+    void reset();
+    StepResult step() { return stepFunction(*this); }
+    
+    // Puts the world into an observed state: snake (head first), heading,
+    // pellet and the segments the snake has still to grow, with no extra
+    // items. For players that only get to see the board, such as
+    // tournament agents.
+    void restore(const std::vector<Position>& body, Direction direction, const Position& foodPosition,
+                 int pendingGrowth = 0);
+
+    // Zobrist hash of the world: snake, food, items, item countdown and the
+    // random stream (item expiry times are not included). O(1); equal
+    // worlds hash equal on any build.
+    uint64_t getHash() const;
+
+    // Speed curve and growth for the active rules. The tick interval is in
+    // microseconds and shrinks with every level down to MIN_TICK_INTERVAL.
+    static const int MIN_TICK_INTERVAL = 800; // 1250 ticks per second
+    int getTickInterval(Difficulty difficulty, int level) const;
+    int getGrowthSegments() const;
+
+    // Getters
+    Snake& getSnake();
+    const Snake& getSnake() const;
+    Food& getFood();
+    const Food& getFood() const;
+    const Bitboard& getOccupancy() const;
+    int getWidth() const;
+    int getHeight() const;
+};
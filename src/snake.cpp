@@ -1,22 +1,22 @@
 #include "snake.h"
 #include "console.h"
+#include "zobrist.h"
 #include <algorithm>
 
 Snake::Snake(int startX, int startY) 
-    : direction(RIGHT), nextDirection(RIGHT), growing(false), growthCounter(0) {
+    : firstRun(0), runCount(0), length(0), direction(RIGHT), nextDirection(RIGHT), growthCounter(0), cellHash(0) {
     reset(startX, startY);
 }
 
 void Snake::update() {
-    // Update direction
-    direction = nextDirection;
-    
-    // Get current head position
-    Position head = getHead();
-    Position newHead = head;
+    move(getNextHead());
+}
+
+Position Snake::getNextHead() const {
+    Position newHead = getHead();
     
-    // Calculate new head position based on direction
-    switch (direction) {
+    // Calculate new head position based on the pending direction
+    switch (nextDirection) {
         case UP:
             newHead.y--;
             break;
@@ -31,22 +31,88 @@ void Snake::update() {
             break;
     }
     
+    return newHead;
+}
+
+void Snake::move(const Position& newHead) {
+    // Update direction
+    direction = nextDirection;
+    
     // Add new head
-    body.insert(body.begin(), newHead);
+    pushHead(newHead);
+    cellHash ^= Zobrist::key(ZOBRIST_BODY, newHead.x, newHead.y);
     
     // Remove tail if not growing
-    if (!growing) {
-        body.pop_back();
+    if (growthCounter == 0) {
+        Position tail = getTail();
+        cellHash ^= Zobrist::key(ZOBRIST_BODY, tail.x, tail.y);
+        popTail();
     } else {
-        growing = false;
+        growthCounter--;
     }
 }
 
-void Snake::setDirection(Direction dir) {
+void Snake::pushHead(const Position& head) {
+    length++;
+    if (runCount > 0) {
+        BodyRun& last = runAt(runCount - 1);
+        int dx, dy;
+        getStep(last.direction, dx, dy);
+        Position end(last.start.x + dx * (last.length - 1), last.start.y + dy * (last.length - 1));
+        if (head.x == end.x + dx && head.y == end.y + dy) {
+            last.length++;
+            return;
+        }
+        
+        // A one-cell run can still take any direction
+        int stepX = head.x - end.x;
+        int stepY = head.y - end.y;
+        if (last.length == 1 && (stepX == 0) != (stepY == 0) && stepX * stepX + stepY * stepY == 1) {
+            last.direction = stepX < 0 ? LEFT : (stepX > 0 ? RIGHT : (stepY < 0 ? UP : DOWN));
+            last.length = 2;
+            return;
+        }
+    }
+    
+    // A turn, a wrap across the edge or a portal jump starts a new run
+    if (runCount == runs.size()) {
+        resizeRuns(std::max<size_t>(4, runs.size() * 2));
+    }
+    BodyRun run = { head, 1, direction };
+    runAt(runCount) = run;
+    runCount++;
+}
+
+void Snake::popTail() {
+    BodyRun& first = runAt(0);
+    int dx, dy;
+    getStep(first.direction, dx, dy);
+    first.start.x += dx;
+    first.start.y += dy;
+    if (--first.length == 0) {
+        firstRun = firstRun + 1 < runs.size() ? firstRun + 1 : 0;
+        runCount--;
+    }
+    length--;
+}
+
+void Snake::resizeRuns(size_t capacity) {
+    // Unrolls the ring so the tail run is back at slot 0
+    std::vector<BodyRun> resized(capacity);
+    for (size_t i = 0; i < runCount; ++i) {
+        resized[i] = getRun(i);
+    }
+    runs.swap(resized);
+    firstRun = 0;
+}
+
+bool Snake::setDirection(Direction dir) {
     // Prevent 180-degree turns
-    if (canChangeDirection(dir)) {
-        nextDirection = dir;
+    if (!canChangeDirection(dir)) {
+        return false;
     }
+    nextDirection = dir;
+    return dir != direction;
 }
 
 Direction Snake::getDirection() const {
@@ -63,61 +129,141 @@ bool Snake::canChangeDirection(Direction newDir) const {
     return true;
 }
 
-void Snake::grow() {
-    growing = true;
+void Snake::grow(int segments) {
+    growthCounter += segments;
+}
+
+bool Snake::removeTail() {
+    // Never shrink below the starting length
+    if (length <= 3) {
+        return false;
+    }
+    Position tail = getTail();
+    cellHash ^= Zobrist::key(ZOBRIST_BODY, tail.x, tail.y);
+    popTail();
+    return true;
 }
 
 void Snake::reset(int startX, int startY) {
-    body.clear();
-    
-    // Initialize with 3 segments
-    body.emplace_back(startX, startY);     // Head
-    body.emplace_back(startX - 1, startY); // Body
-    body.emplace_back(startX - 2, startY); // Tail
-    
+    firstRun = 0;
+    runCount = 0;
+    length = 0;
     direction = RIGHT;
     nextDirection = RIGHT;
-    growing = false;
     growthCounter = 0;
+    
+    // Initialize with 3 segments, one run heading right
+    cellHash = 0;
+    for (int x = startX - 2; x <= startX; ++x) {
+        pushHead(Position(x, startY));
+        cellHash ^= Zobrist::key(ZOBRIST_BODY, x, startY);
+    }
+}
+
+void Snake::restore(const std::vector<Position>& segments, Direction heading, int pendingGrowth) {
+    firstRun = 0;
+    runCount = 0;
+    length = 0;
+    direction = heading;
+    nextDirection = heading;
+    growthCounter = pendingGrowth;
+    
+    cellHash = 0;
+    for (size_t i = segments.size(); i-- > 0;) {
+        pushHead(segments[i]);
+        cellHash ^= Zobrist::key(ZOBRIST_BODY, segments[i].x, segments[i].y);
+    }
+}
+
+void Snake::reserve(int segments) {
+    // A move adds the new head before dropping the tail, so one spare run
+    size_t capacity = std::min(static_cast<size_t>(segments) + 1, static_cast<size_t>(RESERVED_RUNS));
+    if (capacity > runs.size()) {
+        resizeRuns(capacity);
+    }
 }
 
 int Snake::getLength() const {
-    return static_cast<int>(body.size());
+    return length;
 }
 
-const std::vector<Position>& Snake::getBody() const {
-    return body;
+int Snake::getPendingGrowth() const {
+    return growthCounter;
+}
+
+uint64_t Snake::getHash() const {
+    Position head = getHead();
+    Position tail = getTail();
+    return cellHash ^ Zobrist::key(ZOBRIST_HEAD, head.x, head.y) ^ Zobrist::key(ZOBRIST_TAIL, tail.x, tail.y) ^
+           Zobrist::key(ZOBRIST_DIRECTION, static_cast<uint64_t>(direction)) ^
+           Zobrist::key(ZOBRIST_GROWTH, static_cast<uint64_t>(growthCounter));
 }
 
 Position Snake::getHead() const {
-    if (body.empty()) {
+    if (runCount == 0) {
         return Position(0, 0);
     }
-    return body[0];
+    const BodyRun& last = getRun(runCount - 1);
+    int dx, dy;
+    getStep(last.direction, dx, dy);
+    return Position(last.start.x + dx * (last.length - 1), last.start.y + dy * (last.length - 1));
 }
 
 Position Snake::getTail() const {
-    if (body.empty()) {
+    if (runCount == 0) {
         return Position(0, 0);
     }
-    return body.back();
+    return getRun(0).start;
+}
+
+Position Snake::getSegment(int index) const {
+    for (size_t i = runCount; i-- > 0;) {
+        const BodyRun& run = getRun(i);
+        if (index < run.length) {
+            int dx, dy;
+            getStep(run.direction, dx, dy);
+            int offset = run.length - 1 - index;
+            return Position(run.start.x + dx * offset, run.start.y + dy * offset);
+        }
+        index -= run.length;
+    }
+    return Position(0, 0);
+}
+
+size_t Snake::getRunCount() const {
+    return runCount;
+}
+
+bool Snake::runContains(const BodyRun& run, int cells, const Position& pos) {
+    // Whether pos is one of the first `cells` cells of the run
+    int dx, dy;
+    getStep(run.direction, dx, dy);
+    int offset = dx != 0 ? (pos.x - run.start.x) * dx : (pos.y - run.start.y) * dy;
+    bool onLine = dx != 0 ? pos.y == run.start.y : pos.x == run.start.x;
+    return onLine && offset >= 0 && offset < cells;
 }
 
 bool Snake::checkCollision(int x, int y) const {
     Position pos(x, y);
-    return std::find(body.begin(), body.end(), pos) != body.end();
+    for (size_t i = 0; i < runCount; ++i) {
+        if (runContains(getRun(i), getRun(i).length, pos)) {
+            return true;
+        }
+    }
+    return false;
 }
 
 bool Snake::checkWallCollision(int gameWidth, int gameHeight) const {
-    const Position& head = getHead();
+    Position head = getHead();
     return head.x <= 0 || head.x >= gameWidth + 1 || head.y <= 0 || head.y >= gameHeight + 1;
 }
 
 bool Snake::checkSelfCollision() const {
-    const Position& head = getHead();
-    // Check collision with body parts, starting from the second segment
-    for (size_t i = 1; i < body.size(); ++i) {
-        if (head == body[i]) {
+    Position head = getHead();
+    // Check collision with body parts: every run, less the head itself
+    for (size_t i = 0; i < runCount; ++i) {
+        const BodyRun& run = getRun(i);
+        if (runContains(run, i + 1 == runCount ? run.length - 1 : run.length, head)) {
             return true;
         }
     }
@@ -125,11 +271,10 @@ bool Snake::checkSelfCollision() const {
 }
 
 void Snake::draw(Console& console) const {
-    // Draw head
-    console.drawChar(body[0].x, body[0].y, 'O', BRIGHT_GREEN);
-    
-    // Draw body
-    for (size_t i = 1; i < body.size(); ++i) {
-        console.drawChar(body[i].x, body[i].y, 'o', BRIGHT_GREEN);
-    }
+    // Draw head, then body
+    bool head = true;
+    forEachSegment([&](const Position& segment) {
+        console.drawChar(segment.x, segment.y, head ? 'O' : 'o', BRIGHT_GREEN);
+        head = false;
+    });
 }
\ No newline at end of file
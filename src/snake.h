@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <vector>
 #include <utility>
 #include "console.h"
@@ -22,35 +23,117 @@ struct Position {
     }
 };
 
+// A straight stretch of the body: `length` cells from `start`, the end
+// nearest the tail, each one step further in `direction`
+struct BodyRun {
+    Position start;
+    int length;
+    Direction direction;
+};
+
 class Snake {
+public:
+    static const int RESERVED_RUNS = 1 << 16; // Most runs reserve() sets aside up front
+
 private:
-    std::vector<Position> body;
+    // The body as straight runs in a ring, tail run first. A move extends
+    // the head run or starts a new one after a turn, wrap or portal, and the
+    // tail shrinks the first run, so both ends are O(1) and the memory
+    // follows the number of turns rather than the length.
+    std::vector<BodyRun> runs;
+    size_t firstRun;
+    size_t runCount;
+    int length;
     Direction direction;
     Direction nextDirection;
-    bool growing;
-    int growthCounter;
+    int growthCounter; // Segments still to be added at the tail
+    uint64_t cellHash; // XOR of the segments' Zobrist keys
     
     bool canChangeDirection(Direction newDir) const;
+    void pushHead(const Position& head);
+    void popTail();
+    void resizeRuns(size_t capacity);
+    BodyRun& runAt(size_t index) {
+        size_t slot = firstRun + index;
+        return runs[slot < runs.size() ? slot : slot - runs.size()];
+    }
+    
+    static void getStep(Direction dir, int& dx, int& dy) {
+        dx = dir == LEFT ? -1 : (dir == RIGHT ? 1 : 0);
+        dy = dir == UP ? -1 : (dir == DOWN ? 1 : 0);
+    }
+    static bool runContains(const BodyRun& run, int cells, const Position& pos);
     
 public:
     Snake(int startX = 10, int startY = 10);
     
     // Movement
     void update();
-    void setDirection(Direction dir);
+    void move(const Position& newHead);
+    Position getNextHead() const;
+    bool setDirection(Direction dir); // True if the next move turns the head
     Direction getDirection() const;
     
     // Body management
-    void grow();
+    void grow(int segments = 1);
+    bool removeTail();
     void reset(int startX, int startY);
+    void restore(const std::vector<Position>& segments, Direction heading, int pendingGrowth = 0); // Head first
+    
+    // Room for a body this long (up to RESERVED_RUNS runs), so moves do not
+    // reallocate; past that the ring doubles the first time it fills up
+    void reserve(int segments);
     int getLength() const;
+    int getPendingGrowth() const;
+    
+    // Zobrist hash of the body, head, tail, heading and pending growth.
+    // Kept up to date on every move, so this is O(1).
+    uint64_t getHash() const;
     
     // Getters
-    const std::vector<Position>& getBody() const;
     Position getHead() const;
     Position getTail() const;
+    Position getSegment(int index) const; // 0 = head; walks the runs from the head
+    size_t getRunCount() const;
+    const BodyRun& getRun(size_t index) const { // 0 = tail run
+        size_t slot = firstRun + index;
+        return runs[slot < runs.size() ? slot : slot - runs.size()];
+    }
+    
+    // Calls visit(position) for every segment, head first
+    template <class Visit>
+    void forEachSegment(Visit visit) const {
+        for (size_t i = runCount; i-- > 0;) {
+            const BodyRun& run = getRun(i);
+            int dx, dy;
+            getStep(run.direction, dx, dy);
+            Position cell(run.start.x + dx * (run.length - 1), run.start.y + dy * (run.length - 1));
+            for (int k = 0; k < run.length; ++k) {
+                visit(cell);
+                cell.x -= dx;
+                cell.y -= dy;
+            }
+        }
+    }
+    
+    // Same, tail first
+    template <class Visit>
+    void forEachSegmentFromTail(Visit visit) const {
+        for (size_t i = 0; i < runCount; ++i) {
+            const BodyRun& run = getRun(i);
+            int dx, dy;
+            getStep(run.direction, dx, dy);
+            Position cell = run.start;
+            for (int k = 0; k < run.length; ++k) {
+                visit(cell);
+                cell.x += dx;
+                cell.y += dy;
+            }
+        }
+    }
     
-    // Collision detection
+    // Collision detection (one test per run; the simulation keeps a board
+    // bitboard for per-tick checks)
     bool checkCollision(int x, int y) const;
     bool checkWallCollision(int gameWidth, int gameHeight) const;
     bool checkSelfCollision() const;
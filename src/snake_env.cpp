@@ -0,0 +1,247 @@
+#include "snake_env.h"
+#include "mlp_policy.h"
+#include "simulation.h"
+#include <cstring>
+#include <memory>
+#include <new>
+#include <vector>
+
+struct SnakeEnv {
+    struct Instance {
+        Simulation simulation;
+        int32_t steps;
+        int32_t score;
+
+        Instance(int width, int height) : simulation(width, height), steps(0), score(0) {}
+    };
+
+    SnakeEnvConfig config;
+    std::vector<std::unique_ptr<Instance>> instances;
+    size_t planeSize;       // Cells per plane
+    size_t envStride;       // Bytes per environment
+    uint8_t* observations;  // Caller's buffer, bound by reset()
+};
+
+struct SnakePolicy {
+    MlpPolicy policy;
+};
+
+namespace {
+    const int ITEM_SPAWN_INTERVAL = 60; // Same pacing as the interactive game
+
+    uint8_t* planesOf(SnakeEnv* env, size_t index) {
+        return env->observations + index * env->envStride;
+    }
+
+    // Writes one cell's kind into the three dynamic planes
+    void writeCell(uint8_t* planes, size_t planeSize, size_t cell, CellKind kind) {
+        planes[SNAKE_ENV_PLANE_BODY * planeSize + cell] = kind == CELL_SNAKE_BODY;
+        planes[SNAKE_ENV_PLANE_HEAD * planeSize + cell] = kind == CELL_SNAKE_HEAD;
+        planes[SNAKE_ENV_PLANE_FOOD * planeSize + cell] = kind >= CELL_FOOD;
+    }
+
+    // New episode: reset the world and redraw its dynamic planes from scratch
+    void startEpisode(SnakeEnv* env, size_t index) {
+        SnakeEnv::Instance& instance = *env->instances[index];
+        Simulation& sim = instance.simulation;
+        sim.reset();
+        instance.steps = 0;
+        instance.score = 0;
+
+        uint8_t* planes = planesOf(env, index);
+        size_t width = static_cast<size_t>(sim.getWidth());
+        std::memset(planes, 0, SNAKE_ENV_PLANE_WALLS * env->planeSize);
+        for (const FoodItem& item : sim.getItems().getItems()) {
+            if (item.active) {
+                writeCell(planes, env->planeSize, (item.position.y - 1) * width + (item.position.x - 1),
+                          cellKindForItem(item.kind));
+            }
+        }
+        if (sim.getFood().isActive()) {
+            Position food = sim.getFood().getPosition();
+            writeCell(planes, env->planeSize, (food.y - 1) * width + (food.x - 1), CELL_FOOD);
+        }
+        // Tail first, so the head wins if it overlaps the body
+        const Snake& snake = sim.getSnake();
+        snake.forEachSegmentFromTail([&](const Position& segment) {
+            writeCell(planes, env->planeSize, (segment.y - 1) * width + (segment.x - 1), CELL_SNAKE_BODY);
+        });
+        Position head = snake.getHead();
+        writeCell(planes, env->planeSize, (head.y - 1) * width + (head.x - 1), CELL_SNAKE_HEAD);
+    }
+}
+
+void snake_env_default_config(SnakeEnvConfig* config) {
+    config->num_envs = 1;
+    config->width = 40;
+    config->height = 20;
+    config->mode = MODE_CLASSIC;
+    config->max_steps = 0;
+    config->extra_items = 0;
+    config->level = nullptr;
+}
+
+SnakeEnv* snake_env_create(const SnakeEnvConfig* config) {
+    if (!config || config->num_envs <= 0 || config->width < Simulation::MIN_WIDTH || config->height <= 2 ||
+        config->mode < 0 || config->mode >= MODE_COUNT || config->max_steps < 0 || config->extra_items < 0) {
+        return nullptr;
+    }
+
+    // Exceptions must not cross the C boundary
+    try {
+        std::unique_ptr<SnakeEnv> env(new SnakeEnv());
+        env->config = *config;
+        env->config.level = nullptr; // The path is only needed here
+        env->planeSize = static_cast<size_t>(config->width) * config->height;
+        env->envStride = env->planeSize * SNAKE_ENV_PLANE_COUNT;
+        env->observations = nullptr;
+
+        env->instances.reserve(static_cast<size_t>(config->num_envs));
+        for (int32_t i = 0; i < config->num_envs; ++i) {
+            std::unique_ptr<SnakeEnv::Instance> instance(new SnakeEnv::Instance(config->width, config->height));
+            Simulation& sim = instance->simulation;
+            sim.setMode(static_cast<GameMode>(config->mode));
+            sim.setExtraFood(config->extra_items, ITEM_SPAWN_INTERVAL);
+            if (config->level && !sim.loadLevel(config->level)) {
+                return nullptr;
+            }
+            sim.setChangeTracking(true);
+            env->instances.push_back(std::move(instance));
+        }
+        return env.release();
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void snake_env_destroy(SnakeEnv* env) {
+    delete env;
+}
+
+int64_t snake_env_observation_size(const SnakeEnv* env) {
+    return env ? static_cast<int64_t>(env->envStride * env->instances.size()) : 0;
+}
+
+int snake_env_reset(SnakeEnv* env, uint64_t seed, uint8_t* observations) {
+    if (!env || !observations) {
+        return 0;
+    }
+    env->observations = observations;
+
+    for (size_t i = 0; i < env->instances.size(); ++i) {
+        Simulation& sim = env->instances[i]->simulation;
+        sim.seed(seed + i);
+
+        // Walls never change during an episode, so they are only written here
+        uint8_t* walls = planesOf(env, i) + SNAKE_ENV_PLANE_WALLS * env->planeSize;
+        const Level& level = sim.getLevel();
+        for (int y = 1; y <= sim.getHeight(); ++y) {
+            for (int x = 1; x <= sim.getWidth(); ++x) {
+                *walls++ = level.isWall(x, y);
+            }
+        }
+        startEpisode(env, i);
+    }
+    return 1;
+}
+
+int snake_env_step(SnakeEnv* env, const int32_t* actions, float* rewards, uint8_t* dones) {
+    if (!env || !env->observations || !actions || !rewards || !dones) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < env->instances.size(); ++i) {
+        SnakeEnv::Instance& instance = *env->instances[i];
+        Simulation& sim = instance.simulation;
+        if (actions[i] >= UP && actions[i] <= RIGHT) {
+            sim.getSnake().setDirection(static_cast<Direction>(actions[i]));
+        }
+
+        StepResult result = sim.step();
+        instance.steps++;
+
+        // Only the cells this tick touched are rewritten
+        uint8_t* planes = planesOf(env, i);
+        size_t width = static_cast<size_t>(sim.getWidth());
+        for (const CellChange& change : sim.getChanges()) {
+            writeCell(planes, env->planeSize, (change.y - 1) * width + (change.x - 1), change.kind);
+        }
+        sim.clearChanges();
+
+        float reward = 0.0f;
+        uint8_t done = SNAKE_ENV_RUNNING;
+        if (result.ateFood) {
+            reward = 1.0f;
+            instance.score += result.points;
+        }
+        if (!result.alive) {
+            reward = -1.0f;
+            done = SNAKE_ENV_DIED;
+        } else if (env->config.max_steps > 0 && instance.steps >= env->config.max_steps) {
+            done = SNAKE_ENV_TRUNCATED;
+        }
+        if (done != SNAKE_ENV_RUNNING) {
+            startEpisode(env, i);
+        }
+
+        rewards[i] = reward;
+        dones[i] = done;
+    }
+    return 1;
+}
+
+int32_t snake_env_get_score(const SnakeEnv* env, int32_t index) {
+    if (!env || index < 0 || static_cast<size_t>(index) >= env->instances.size()) {
+        return 0;
+    }
+    return env->instances[static_cast<size_t>(index)]->score;
+}
+
+int32_t snake_env_get_length(const SnakeEnv* env, int32_t index) {
+    if (!env || index < 0 || static_cast<size_t>(index) >= env->instances.size()) {
+        return 0;
+    }
+    return env->instances[static_cast<size_t>(index)]->simulation.getSnake().getLength();
+}
+
+SnakePolicy* snake_policy_load(const char* path) {
+    if (!path) {
+        return nullptr;
+    }
+    try {
+        std::unique_ptr<SnakePolicy> policy(new SnakePolicy());
+        if (!policy->policy.load(path)) {
+            return nullptr;
+        }
+        return policy.release();
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void snake_policy_destroy(SnakePolicy* policy) {
+    delete policy;
+}
+
+int64_t snake_policy_input_size(const SnakePolicy* policy) {
+    return policy ? policy->policy.getInputSize() : 0;
+}
+
+int snake_policy_act(SnakePolicy* policy, const uint8_t* observations, int32_t count, int32_t* actions) {
+    if (!policy || !observations || !actions || count < 0) {
+        return 0;
+    }
+
+    // Chunked through a stack buffer so acting never allocates
+    const int32_t CHUNK = 256;
+    Direction chosen[CHUNK];
+    size_t inputs = static_cast<size_t>(policy->policy.getInputSize());
+    for (int32_t first = 0; first < count; first += CHUNK) {
+        int32_t size = count - first < CHUNK ? count - first : CHUNK;
+        policy->policy.chooseBatch(observations + first * inputs, size, chosen);
+        for (int32_t i = 0; i < size; ++i) {
+            actions[first + i] = chosen[i];
+        }
+    }
+    return 1;
+}
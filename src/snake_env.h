@@ -0,0 +1,99 @@
+#pragma once
+/*
+ * C API for training agents on the game. One SnakeEnv holds a batch of
+ * independent environments that are stepped together. Each environment runs
+ * the game's own Simulation (same Snake, Food and rule policies).
+ *
+ * Observations live in a buffer the caller owns. It is laid out as
+ * [env][plane][y][x], one byte per cell (0 or 1), with the planes in
+ * SnakeEnvPlane order. reset() fills it. After that, step() changes only the
+ * cells that changed, so the buffer must stay in place and must not be
+ * modified between calls.
+ */
+#include <stdint.h>
+
+#if defined(_WIN32)
+#if defined(SNAKE_ENV_BUILD)
+#define SNAKE_ENV_API __declspec(dllexport)
+#else
+#define SNAKE_ENV_API __declspec(dllimport)
+#endif
+#else
+#define SNAKE_ENV_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum SnakeEnvPlane {
+    SNAKE_ENV_PLANE_BODY,  /* Snake segments behind the head */
+    SNAKE_ENV_PLANE_HEAD,
+    SNAKE_ENV_PLANE_FOOD,  /* Main pellet and any extra items */
+    SNAKE_ENV_PLANE_WALLS, /* Level obstacles (the border is implicit) */
+    SNAKE_ENV_PLANE_COUNT
+};
+
+/* Actions are directions: 0 up, 1 down, 2 left, 3 right. Any other value
+   keeps the current heading; so does reversing onto the body. */
+
+/* Values written to dones[] */
+enum SnakeEnvDone {
+    SNAKE_ENV_RUNNING = 0,
+    SNAKE_ENV_DIED = 1,     /* Terminal: hit a wall, an obstacle or itself */
+    SNAKE_ENV_TRUNCATED = 2 /* Reached max_steps while alive */
+};
+
+typedef struct SnakeEnvConfig {
+    int32_t num_envs;
+    int32_t width;        /* Play area, 40x20 by default; at least 6 wide */
+    int32_t height;
+    int32_t mode;         /* 0 classic, 1 wrap around, 2 marathon */
+    int32_t max_steps;    /* Episode step limit, 0 for none */
+    int32_t extra_items;  /* Extra food items on the board at once, 0 for none */
+    const char* level;    /* Level file (.lvl or .txt) or NULL for an open field */
+} SnakeEnvConfig;
+
+typedef struct SnakeEnv SnakeEnv;
+
+SNAKE_ENV_API void snake_env_default_config(SnakeEnvConfig* config);
+
+/* Returns NULL if the configuration is invalid or the level cannot be loaded */
+SNAKE_ENV_API SnakeEnv* snake_env_create(const SnakeEnvConfig* config);
+SNAKE_ENV_API void snake_env_destroy(SnakeEnv* env);
+
+/* Bytes needed for the observation buffer of the whole batch */
+SNAKE_ENV_API int64_t snake_env_observation_size(const SnakeEnv* env);
+
+/* Starts every environment afresh (environment i uses a stream derived from
+   seed and i) and writes the full observation. Returns 1 on success. */
+SNAKE_ENV_API int snake_env_reset(SnakeEnv* env, uint64_t seed, uint8_t* observations);
+
+/* Advances every environment one tick. Rewards are +1 per food eaten and -1
+   on death. Finished environments start a new episode right away, and their
+   observation already shows it. Returns 1 on success, 0 before reset(). */
+SNAKE_ENV_API int snake_env_step(SnakeEnv* env, const int32_t* actions, float* rewards, uint8_t* dones);
+
+/* Current score and length of one environment's episode */
+SNAKE_ENV_API int32_t snake_env_get_score(const SnakeEnv* env, int32_t index);
+SNAKE_ENV_API int32_t snake_env_get_length(const SnakeEnv* env, int32_t index);
+
+/* Trained MLP policies (file format in src/mlp_policy.h). One call picks an
+   action for a whole batch of observations in the layout above. A policy is
+   not thread-safe; use one per thread. */
+typedef struct SnakePolicy SnakePolicy;
+
+/* Returns NULL if the file is missing or malformed */
+SNAKE_ENV_API SnakePolicy* snake_policy_load(const char* path);
+SNAKE_ENV_API void snake_policy_destroy(SnakePolicy* policy);
+
+/* Observation bytes per environment the policy was trained on */
+SNAKE_ENV_API int64_t snake_policy_input_size(const SnakePolicy* policy);
+
+/* Writes count actions. Returns 1 on success. */
+SNAKE_ENV_API int snake_policy_act(SnakePolicy* policy, const uint8_t* observations, int32_t count,
+                                   int32_t* actions);
+
+#ifdef __cplusplus
+}
+#endif
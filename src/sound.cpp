@@ -0,0 +1,336 @@
+#include "sound.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+namespace {
+    const int VOICE_AMPLITUDE = 6000;
+
+    void writeLE16(std::ofstream& file, uint16_t value) {
+        char bytes[2] = { static_cast<char>(value & 0xFF), static_cast<char>((value >> 8) & 0xFF) };
+        file.write(bytes, 2);
+    }
+
+    void writeLE32(std::ofstream& file, uint32_t value) {
+        char bytes[4] = {
+            static_cast<char>(value & 0xFF), static_cast<char>((value >> 8) & 0xFF),
+            static_cast<char>((value >> 16) & 0xFF), static_cast<char>((value >> 24) & 0xFF)
+        };
+        file.write(bytes, 4);
+    }
+}
+
+// NullSoundSink implementation
+NullSoundSink::NullSoundSink() : samplesWritten(0) {
+}
+
+bool NullSoundSink::open(int sampleRate) {
+    (void)sampleRate;
+    samplesWritten = 0;
+    return true;
+}
+
+void NullSoundSink::write(const int16_t* samples, size_t count) {
+    (void)samples;
+    samplesWritten += count;
+}
+
+void NullSoundSink::close() {
+}
+
+size_t NullSoundSink::getSamplesWritten() const {
+    return samplesWritten;
+}
+
+// WavFileSink implementation
+WavFileSink::WavFileSink(const std::string& filename)
+    : filename(filename), sampleRate(0), dataBytes(0) {
+}
+
+WavFileSink::~WavFileSink() {
+    close();
+}
+
+bool WavFileSink::open(int rate) {
+    sampleRate = rate;
+    dataBytes = 0;
+    file.open(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+    writeHeader();
+    return true;
+}
+
+void WavFileSink::writeHeader() {
+    // Canonical 44-byte RIFF header for 16-bit mono PCM
+    file.write("RIFF", 4);
+    writeLE32(file, 36 + dataBytes);
+    file.write("WAVE", 4);
+    file.write("fmt ", 4);
+    writeLE32(file, 16);
+    writeLE16(file, 1);                                   // PCM
+    writeLE16(file, 1);                                   // Mono
+    writeLE32(file, static_cast<uint32_t>(sampleRate));
+    writeLE32(file, static_cast<uint32_t>(sampleRate * 2)); // Byte rate
+    writeLE16(file, 2);                                   // Block align
+    writeLE16(file, 16);                                  // Bits per sample
+    file.write("data", 4);
+    writeLE32(file, dataBytes);
+}
+
+void WavFileSink::write(const int16_t* samples, size_t count) {
+    if (!file.is_open()) {
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        writeLE16(file, static_cast<uint16_t>(samples[i]));
+    }
+    dataBytes += static_cast<uint32_t>(count * 2);
+}
+
+void WavFileSink::close() {
+    if (!file.is_open()) {
+        return;
+    }
+    // Patch the header now that the data size is known
+    file.seekp(0);
+    writeHeader();
+    file.close();
+}
+
+#ifdef _WIN32
+// WaveOutSink implementation
+WaveOutSink::WaveOutSink() : device(nullptr), nextBuffer(0), isOpen(false) {
+    for (int i = 0; i < BUFFER_COUNT; ++i) {
+        ZeroMemory(&headers[i], sizeof(WAVEHDR));
+    }
+}
+
+WaveOutSink::~WaveOutSink() {
+    close();
+}
+
+bool WaveOutSink::open(int sampleRate) {
+    WAVEFORMATEX format = {};
+    format.wFormatTag = WAVE_FORMAT_PCM;
+    format.nChannels = 1;
+    format.nSamplesPerSec = static_cast<DWORD>(sampleRate);
+    format.wBitsPerSample = 16;
+    format.nBlockAlign = 2;
+    format.nAvgBytesPerSec = format.nSamplesPerSec * format.nBlockAlign;
+
+    if (waveOutOpen(&device, WAVE_MAPPER, &format, 0, 0, CALLBACK_NULL) != MMSYSERR_NOERROR) {
+        return false;
+    }
+    isOpen = true;
+    nextBuffer = 0;
+    return true;
+}
+
+void WaveOutSink::write(const int16_t* samples, size_t count) {
+    if (!isOpen) {
+        return;
+    }
+
+    WAVEHDR& header = headers[nextBuffer];
+
+    // Wait for the device to finish with this buffer (only blocks the mixer thread)
+    if (header.dwFlags & WHDR_PREPARED) {
+        while (!(header.dwFlags & WHDR_DONE)) {
+            Sleep(1);
+        }
+        waveOutUnprepareHeader(device, &header, sizeof(WAVEHDR));
+    }
+
+    std::vector<int16_t>& buffer = buffers[nextBuffer];
+    buffer.assign(samples, samples + count);
+
+    ZeroMemory(&header, sizeof(WAVEHDR));
+    header.lpData = reinterpret_cast<LPSTR>(buffer.data());
+    header.dwBufferLength = static_cast<DWORD>(count * sizeof(int16_t));
+    waveOutPrepareHeader(device, &header, sizeof(WAVEHDR));
+    waveOutWrite(device, &header, sizeof(WAVEHDR));
+
+    nextBuffer = (nextBuffer + 1) % BUFFER_COUNT;
+}
+
+void WaveOutSink::close() {
+    if (!isOpen) {
+        return;
+    }
+    waveOutReset(device);
+    for (int i = 0; i < BUFFER_COUNT; ++i) {
+        if (headers[i].dwFlags & WHDR_PREPARED) {
+            waveOutUnprepareHeader(device, &headers[i], sizeof(WAVEHDR));
+        }
+    }
+    waveOutClose(device);
+    isOpen = false;
+}
+#endif
+
+// SoundQueue implementation
+SoundQueue::SoundQueue() : head(0), tail(0) {
+}
+
+bool SoundQueue::push(const SoundCommand& command) {
+    size_t currentTail = tail.load(std::memory_order_relaxed);
+    if (currentTail - head.load(std::memory_order_acquire) >= CAPACITY) {
+        return false; // Full - drop rather than block the game thread
+    }
+    commands[currentTail & (CAPACITY - 1)] = command;
+    tail.store(currentTail + 1, std::memory_order_release);
+    return true;
+}
+
+bool SoundQueue::pop(SoundCommand& command) {
+    size_t currentHead = head.load(std::memory_order_relaxed);
+    if (currentHead == tail.load(std::memory_order_acquire)) {
+        return false;
+    }
+    command = commands[currentHead & (CAPACITY - 1)];
+    head.store(currentHead + 1, std::memory_order_release);
+    return true;
+}
+
+// SoundSystem implementation
+SoundSystem::SoundSystem() : running(false), droppedCommands(0) {
+    for (int i = 0; i < MAX_VOICES; ++i) {
+        voices[i] = Voice{0.0, 0.0, 0};
+    }
+    mixBuffer.resize(BLOCK_SAMPLES);
+}
+
+SoundSystem::~SoundSystem() {
+    stop();
+}
+
+bool SoundSystem::start(std::unique_ptr<SoundSink> outputSink) {
+    if (running) {
+        return true;
+    }
+
+    sink = std::move(outputSink);
+    if (!sink || !sink->open(SAMPLE_RATE)) {
+        sink.reset();
+        return false;
+    }
+
+    running = true;
+    mixer = std::thread(&SoundSystem::mixerLoop, this);
+    return true;
+}
+
+void SoundSystem::stop() {
+    if (!running) {
+        return;
+    }
+    running = false;
+    if (mixer.joinable()) {
+        mixer.join();
+    }
+    sink->close();
+    sink.reset();
+}
+
+bool SoundSystem::isRunning() const {
+    return running;
+}
+
+bool SoundSystem::playTone(int frequency, int duration) {
+    if (!running || frequency <= 0 || duration <= 0) {
+        return false;
+    }
+    if (!queue.push(SoundCommand{frequency, duration})) {
+        droppedCommands++;
+        return false;
+    }
+    return true;
+}
+
+void SoundSystem::playEatSound() {
+    playTone(400, 50);
+}
+
+void SoundSystem::playGameOverSound() {
+    playTone(200, 500);
+}
+
+size_t SoundSystem::getDroppedCommands() const {
+    return droppedCommands;
+}
+
+void SoundSystem::startVoice(const SoundCommand& command) {
+    // Reuse a free voice, or steal the one closest to finishing
+    int slot = 0;
+    for (int i = 0; i < MAX_VOICES; ++i) {
+        if (voices[i].remaining == 0) {
+            slot = i;
+            break;
+        }
+        if (voices[i].remaining < voices[slot].remaining) {
+            slot = i;
+        }
+    }
+
+    voices[slot].phase = 0.0;
+    voices[slot].phaseStep = static_cast<double>(command.frequency) / SAMPLE_RATE;
+    voices[slot].remaining = command.duration * SAMPLE_RATE / 1000;
+}
+
+void SoundSystem::mixBlock() {
+    for (int s = 0; s < BLOCK_SAMPLES; ++s) {
+        int sample = 0;
+        for (int v = 0; v < MAX_VOICES; ++v) {
+            Voice& voice = voices[v];
+            if (voice.remaining == 0) {
+                continue;
+            }
+            // Square wave, same timbre as the console beep
+            sample += voice.phase < 0.5 ? VOICE_AMPLITUDE : -VOICE_AMPLITUDE;
+            voice.phase += voice.phaseStep;
+            if (voice.phase >= 1.0) {
+                voice.phase -= 1.0;
+            }
+            voice.remaining--;
+        }
+        mixBuffer[s] = static_cast<int16_t>(std::max(-32768, std::min(32767, sample)));
+    }
+}
+
+void SoundSystem::mixerLoop() {
+    // Each block is due when the samples before it have played, counted from
+    // the start, so the 220-sample block length is never rounded into drift
+    typedef std::chrono::duration<long long, std::ratio<1, SAMPLE_RATE>> SampleTime;
+    const auto start = std::chrono::steady_clock::now();
+    long long samples = 0;
+
+    while (running) {
+        SoundCommand command;
+        while (queue.pop(command)) {
+            startVoice(command);
+        }
+
+        // Silence is a block like any other, so a WAV recording keeps the
+        // same timeline as the speaker
+        mixBlock();
+        sink->write(mixBuffer.data(), mixBuffer.size());
+
+        samples += BLOCK_SAMPLES;
+        std::this_thread::sleep_until(
+            start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(SampleTime(samples)));
+    }
+}
+
+std::unique_ptr<SoundSink> SoundSystem::createDefaultSink() {
+    const char* wavFile = std::getenv("SNAKE_SOUND_WAV");
+    if (wavFile != nullptr && wavFile[0] != '\0') {
+        return std::unique_ptr<SoundSink>(new WavFileSink(wavFile));
+    }
+#ifdef _WIN32
+    return std::unique_ptr<SoundSink>(new WaveOutSink());
+#else
+    return std::unique_ptr<SoundSink>(new NullSoundSink());
+#endif
+}
@@ -0,0 +1,149 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <mmsystem.h>
+#endif
+
+// A single tone request from the game thread
+struct SoundCommand {
+    int frequency;  // Hz
+    int duration;   // milliseconds
+};
+
+// Destination for mixed PCM audio (16-bit signed mono)
+class SoundSink {
+public:
+    virtual ~SoundSink() = default;
+
+    virtual bool open(int sampleRate) = 0;
+    virtual void write(const int16_t* samples, size_t count) = 0;
+    virtual void close() = 0;
+};
+
+// Discards audio but keeps a sample count (useful for headless runs)
+class NullSoundSink : public SoundSink {
+private:
+    std::atomic<size_t> samplesWritten;
+
+public:
+    NullSoundSink();
+
+    bool open(int sampleRate) override;
+    void write(const int16_t* samples, size_t count) override;
+    void close() override;
+
+    size_t getSamplesWritten() const;
+};
+
+// Writes audio to a .wav file so sounds can be checked without a sound card
+class WavFileSink : public SoundSink {
+private:
+    std::string filename;
+    std::ofstream file;
+    int sampleRate;
+    uint32_t dataBytes;
+
+    void writeHeader();
+
+public:
+    explicit WavFileSink(const std::string& filename);
+    ~WavFileSink() override;
+
+    bool open(int sampleRate) override;
+    void write(const int16_t* samples, size_t count) override;
+    void close() override;
+};
+
+#ifdef _WIN32
+// Streams audio to the default Windows wave output device
+class WaveOutSink : public SoundSink {
+private:
+    static const int BUFFER_COUNT = 4;
+
+    HWAVEOUT device;
+    WAVEHDR headers[BUFFER_COUNT];
+    std::vector<int16_t> buffers[BUFFER_COUNT];
+    int nextBuffer;
+    bool isOpen;
+
+public:
+    WaveOutSink();
+    ~WaveOutSink() override;
+
+    bool open(int sampleRate) override;
+    void write(const int16_t* samples, size_t count) override;
+    void close() override;
+};
+#endif
+
+// Lock-free single-producer/single-consumer ring of sound commands
+class SoundQueue {
+private:
+    static const size_t CAPACITY = 64; // Must be a power of two
+
+    SoundCommand commands[CAPACITY];
+    std::atomic<size_t> head; // Next slot to read (consumer)
+    std::atomic<size_t> tail; // Next slot to write (producer)
+
+public:
+    SoundQueue();
+
+    bool push(const SoundCommand& command);
+    bool pop(SoundCommand& command);
+};
+
+// Sound subsystem: the game thread only enqueues tones, a background mixer
+// thread synthesizes them into PCM blocks and hands them to the sink.
+class SoundSystem {
+private:
+    static const int SAMPLE_RATE = 22050;
+    static const int BLOCK_SAMPLES = SAMPLE_RATE / 100; // 10 ms blocks
+    static const int MAX_VOICES = 8;
+
+    struct Voice {
+        double phase;
+        double phaseStep;
+        int remaining; // samples left to play
+    };
+
+    SoundQueue queue;
+    std::unique_ptr<SoundSink> sink;
+    std::thread mixer;
+    std::atomic<bool> running;
+    std::atomic<size_t> droppedCommands;
+    Voice voices[MAX_VOICES];
+    std::vector<int16_t> mixBuffer;
+
+    void mixerLoop();
+    void startVoice(const SoundCommand& command);
+    void mixBlock();
+
+public:
+    SoundSystem();
+    ~SoundSystem();
+
+    // Lifecycle
+    bool start(std::unique_ptr<SoundSink> outputSink);
+    void stop();
+    bool isRunning() const;
+
+    // Game thread API - never blocks
+    bool playTone(int frequency, int duration);
+    void playEatSound();
+    void playGameOverSound();
+
+    // Statistics
+    size_t getDroppedCommands() const;
+
+    // Picks the platform sink (SNAKE_SOUND_WAV=<file> forces a WAV file sink)
+    static std::unique_ptr<SoundSink> createDefaultSink();
+};
@@ -0,0 +1,342 @@
+#include "spectator_feed.h"
+#include <cstring>
+#include <new>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    const uint32_t FEED_MAGIC = 0x564B4E53; // "SNKV" little-endian
+    const uint32_t FEED_VERSION = 1;
+
+    size_t slotSizeFor(int width, int height) {
+        // Keep every slot's sequence on its own cache line
+        size_t size = sizeof(SpectatorSlot) + static_cast<size_t>(width) * height;
+        return (size + 63) / 64 * 64;
+    }
+
+    size_t headerSize() {
+        return (sizeof(SpectatorHeader) + 63) / 64 * 64;
+    }
+}
+
+#ifdef _WIN32
+SharedSegment::SharedSegment() : mappingHandle(nullptr), bytes(nullptr), length(0) {
+}
+#else
+SharedSegment::SharedSegment() : fileDescriptor(-1), owner(false), bytes(nullptr), length(0) {
+}
+#endif
+
+SharedSegment::~SharedSegment() {
+    close();
+}
+
+std::string SharedSegment::systemName(const std::string& feedName) {
+#ifdef _WIN32
+    return "Local\\snake-" + feedName;
+#else
+    return "/snake-" + feedName;
+#endif
+}
+
+bool SharedSegment::create(const std::string& feedName, size_t size) {
+    close();
+    name = systemName(feedName);
+
+#ifdef _WIN32
+    mappingHandle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                       static_cast<DWORD>(static_cast<uint64_t>(size) >> 32),
+                                       static_cast<DWORD>(size & 0xFFFFFFFF), name.c_str());
+    if (mappingHandle == nullptr) {
+        return false;
+    }
+    bytes = static_cast<unsigned char*>(MapViewOfFile(mappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, size));
+#else
+    // A segment left behind by a crashed game is replaced, not reused: viewers
+    // still mapping it keep their pages, and we never shrink memory under them
+    shm_unlink(name.c_str());
+    fileDescriptor = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fileDescriptor < 0) {
+        return false;
+    }
+    owner = true;
+    if (ftruncate(fileDescriptor, static_cast<off_t>(size)) != 0) {
+        close();
+        return false;
+    }
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+    bytes = mapping == MAP_FAILED ? nullptr : static_cast<unsigned char*>(mapping);
+#endif
+
+    length = size;
+    if (bytes == nullptr) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool SharedSegment::open(const std::string& feedName) {
+    close();
+    name = systemName(feedName);
+
+#ifdef _WIN32
+    mappingHandle = OpenFileMappingA(FILE_MAP_READ, FALSE, name.c_str());
+    if (mappingHandle == nullptr) {
+        return false;
+    }
+    bytes = static_cast<unsigned char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    MEMORY_BASIC_INFORMATION info;
+    if (bytes != nullptr && VirtualQuery(bytes, &info, sizeof(info)) != 0) {
+        length = info.RegionSize;
+    }
+#else
+    fileDescriptor = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fileDescriptor < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fileDescriptor, &info) != 0 || info.st_size == 0) {
+        close();
+        return false;
+    }
+    length = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, length, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+    bytes = mapping == MAP_FAILED ? nullptr : static_cast<unsigned char*>(mapping);
+#endif
+
+    if (bytes == nullptr) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void SharedSegment::close() {
+#ifdef _WIN32
+    if (bytes != nullptr) {
+        UnmapViewOfFile(bytes);
+    }
+    if (mappingHandle != nullptr) {
+        CloseHandle(mappingHandle);
+        mappingHandle = nullptr;
+    }
+#else
+    if (bytes != nullptr) {
+        munmap(bytes, length);
+    }
+    if (fileDescriptor >= 0) {
+        ::close(fileDescriptor);
+        fileDescriptor = -1;
+    }
+    if (owner) {
+        shm_unlink(name.c_str());
+        owner = false;
+    }
+#endif
+    bytes = nullptr;
+    length = 0;
+}
+
+bool SharedSegment::isOpen() const {
+    return bytes != nullptr;
+}
+
+unsigned char* SharedSegment::data() const {
+    return bytes;
+}
+
+size_t SharedSegment::size() const {
+    return length;
+}
+
+SpectatorFeed::SpectatorFeed() : header(nullptr), frameCount(0) {
+}
+
+SpectatorFeed::~SpectatorFeed() {
+    close();
+}
+
+bool SpectatorFeed::create(const std::string& feedName, int width, int height) {
+    close();
+    size_t slotSize = slotSizeFor(width, height);
+    if (!segment.create(feedName, headerSize() + SLOT_COUNT * slotSize)) {
+        return false;
+    }
+
+    // Fresh memory is zeroed, so every slot starts at sequence 0 (never written)
+    header = new (segment.data()) SpectatorHeader();
+    header->magic = FEED_MAGIC;
+    header->version = FEED_VERSION;
+    header->slotCount = SLOT_COUNT;
+    header->slotSize = static_cast<uint32_t>(slotSize);
+    header->width = width;
+    header->height = height;
+    header->published.store(0, std::memory_order_relaxed);
+    header->closed.store(0, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < SLOT_COUNT; i++) {
+        new (getSlot(i)) SpectatorSlot();
+        getSlot(i)->sequence.store(0, std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+
+    background.assign(static_cast<size_t>(width) * height, 0);
+    frameCount = 0;
+    return true;
+}
+
+void SpectatorFeed::close() {
+    if (header != nullptr) {
+        header->closed.store(1, std::memory_order_release);
+        header = nullptr;
+    }
+    segment.close();
+}
+
+bool SpectatorFeed::isOpen() const {
+    return header != nullptr;
+}
+
+SpectatorSlot* SpectatorFeed::getSlot(uint64_t frame) const {
+    size_t offset = headerSize() + static_cast<size_t>(frame % SLOT_COUNT) * header->slotSize;
+    return reinterpret_cast<SpectatorSlot*>(segment.data() + offset);
+}
+
+void SpectatorFeed::setLevel(const Level& level) {
+    if (header == nullptr || level.getWidth() != header->width || level.getHeight() != header->height) {
+        return;
+    }
+    for (int y = 1; y <= header->height; y++) {
+        for (int x = 1; x <= header->width; x++) {
+            uint8_t bits = 0;
+            if (level.isWall(x, y)) {
+                bits = SPECTATOR_WALL;
+            } else if (level.isPortal(x, y)) {
+                bits = SPECTATOR_PORTAL;
+            }
+            background[static_cast<size_t>(y - 1) * header->width + (x - 1)] = bits;
+        }
+    }
+}
+
+void SpectatorFeed::publish(const FrameSnapshot& frame) {
+    if (header == nullptr || frame.cells.size() != background.size()) {
+        return;
+    }
+
+    uint64_t number = frameCount++;
+    SpectatorSlot* slot = getSlot(number);
+    slot->sequence.store(2 * number + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot->tick = frame.tick;
+    slot->score = frame.score;
+    slot->level = frame.level;
+    slot->highScore = frame.highScore;
+    slot->tickRate = frame.tickRate;
+    slot->foodColor = frame.foodColor;
+    slot->foodSymbol = static_cast<uint8_t>(frame.foodSymbol);
+    slot->alive = frame.alive ? 1 : 0;
+    slot->trapped = frame.trapped ? 1 : 0;
+    slot->turbo = frame.turbo ? 1 : 0;
+    uint8_t* cells = reinterpret_cast<uint8_t*>(slot + 1);
+    for (size_t i = 0; i < background.size(); i++) {
+        cells[i] = static_cast<uint8_t>(frame.cells[i] | background[i]);
+    }
+
+    slot->sequence.store(2 * number + 2, std::memory_order_release);
+    header->published.store(number + 1, std::memory_order_release);
+}
+
+SpectatorView::SpectatorView() : header(nullptr), lastFrame(0) {
+}
+
+bool SpectatorView::attach(const std::string& feedName) {
+    detach();
+    if (!segment.open(feedName) || segment.size() < headerSize()) {
+        segment.close();
+        return false;
+    }
+
+    const SpectatorHeader* candidate = reinterpret_cast<const SpectatorHeader*>(segment.data());
+    if (candidate->magic != FEED_MAGIC || candidate->version != FEED_VERSION || candidate->slotCount == 0 ||
+        candidate->width <= 0 || candidate->height <= 0 ||
+        candidate->slotSize < slotSizeFor(candidate->width, candidate->height) ||
+        segment.size() < headerSize() + static_cast<size_t>(candidate->slotCount) * candidate->slotSize) {
+        segment.close();
+        return false;
+    }
+    header = candidate;
+    lastFrame = 0;
+    return true;
+}
+
+void SpectatorView::detach() {
+    header = nullptr;
+    segment.close();
+}
+
+bool SpectatorView::isAttached() const {
+    return header != nullptr;
+}
+
+bool SpectatorView::isClosed() const {
+    return header == nullptr || header->closed.load(std::memory_order_acquire) != 0;
+}
+
+int SpectatorView::getWidth() const {
+    return header != nullptr ? header->width : 0;
+}
+
+int SpectatorView::getHeight() const {
+    return header != nullptr ? header->height : 0;
+}
+
+bool SpectatorView::readLatest(SpectatorFrame& frame) {
+    if (header == nullptr) {
+        return false;
+    }
+
+    // A failed attempt means the writer lapped us mid-copy; the next newest
+    // frame is then complete, so a few attempts are plenty
+    for (int attempt = 0; attempt < 4; attempt++) {
+        uint64_t published = header->published.load(std::memory_order_acquire);
+        if (published == 0 || published == lastFrame) {
+            return false;
+        }
+        uint64_t number = published - 1;
+        size_t offset = headerSize() + static_cast<size_t>(number % header->slotCount) * header->slotSize;
+        const SpectatorSlot* slot = reinterpret_cast<const SpectatorSlot*>(segment.data() + offset);
+        uint64_t expected = 2 * number + 2;
+        if (slot->sequence.load(std::memory_order_acquire) != expected) {
+            continue;
+        }
+
+        frame.values.tick = slot->tick;
+        frame.values.score = slot->score;
+        frame.values.level = slot->level;
+        frame.values.highScore = slot->highScore;
+        frame.values.tickRate = slot->tickRate;
+        frame.values.foodColor = slot->foodColor;
+        frame.values.foodSymbol = slot->foodSymbol;
+        frame.values.alive = slot->alive;
+        frame.values.trapped = slot->trapped;
+        frame.values.turbo = slot->turbo;
+        size_t cellCount = static_cast<size_t>(header->width) * header->height;
+        frame.cells.resize(cellCount);
+        std::memcpy(frame.cells.data(), reinterpret_cast<const uint8_t*>(slot + 1), cellCount);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot->sequence.load(std::memory_order_relaxed) == expected) {
+            frame.number = number;
+            lastFrame = published;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include "frame_snapshot.h"
+#include "level.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Live frames in named shared memory, for viewers on the same host. The
+// game writes each published frame into the next slot of a small ring;
+// viewers map the segment read-only and copy out the newest slot. Every
+// slot is a seqlock: its sequence is odd while being written and
+// 2 * frame + 2 once complete, so a reader that was lapped or raced the
+// writer sees a different value afterwards and retries. The writer never
+// waits for, or even knows about, its readers.
+//
+// Segment layout: SpectatorHeader, then slotCount slots of slotSize bytes,
+// each a SpectatorSlot followed by width * height cell bytes. A cell byte is
+// a CellKind, plus SPECTATOR_WALL or SPECTATOR_PORTAL for the level.
+struct SpectatorHeader {
+    uint32_t magic;                  // "SNKV"
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t slotSize;
+    int32_t width;
+    int32_t height;
+    std::atomic<uint64_t> published; // Frames so far; the newest is in slot (published - 1) % slotCount
+    std::atomic<uint32_t> closed;    // Set when the game exits
+};
+
+struct SpectatorSlot {
+    std::atomic<uint64_t> sequence;
+    uint64_t tick;
+    int32_t score;
+    int32_t level;
+    int32_t highScore;
+    int32_t tickRate;
+    int32_t foodColor;
+    uint8_t foodSymbol;
+    uint8_t alive;
+    uint8_t trapped;
+    uint8_t turbo;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared memory needs address-free atomics");
+
+const uint8_t SPECTATOR_WALL = 0x80;
+const uint8_t SPECTATOR_PORTAL = 0x40;
+const uint8_t SPECTATOR_KIND_MASK = 0x3F;
+
+// A frame copied out of the segment
+struct SpectatorFrame {
+    uint64_t number;
+    SpectatorSlot values; // sequence is not meaningful in a copy
+    std::vector<uint8_t> cells;
+};
+
+// A named segment, created by the game and opened read-only by viewers
+class SharedSegment {
+private:
+#ifdef _WIN32
+    HANDLE mappingHandle;
+#else
+    int fileDescriptor;
+    bool owner;
+#endif
+    std::string name;
+    unsigned char* bytes;
+    size_t length;
+
+    static std::string systemName(const std::string& feedName);
+
+public:
+    SharedSegment();
+    ~SharedSegment();
+
+    SharedSegment(const SharedSegment&) = delete;
+    SharedSegment& operator=(const SharedSegment&) = delete;
+
+    bool create(const std::string& feedName, size_t size);
+    bool open(const std::string& feedName); // Read-only
+    void close();                           // The creator also removes the name
+
+    bool isOpen() const;
+    unsigned char* data() const;
+    size_t size() const;
+};
+
+// Game side
+class SpectatorFeed {
+private:
+    static const uint32_t SLOT_COUNT = 8;
+
+    SharedSegment segment;
+    SpectatorHeader* header;
+    std::vector<uint8_t> background; // Wall and portal bits of the current level
+    uint64_t frameCount;
+
+    SpectatorSlot* getSlot(uint64_t frame) const;
+
+public:
+    SpectatorFeed();
+    ~SpectatorFeed();
+
+    bool create(const std::string& feedName, int width, int height);
+    void close();
+    bool isOpen() const;
+
+    void setLevel(const Level& level);
+    void publish(const FrameSnapshot& frame);
+};
+
+// Viewer side
+class SpectatorView {
+private:
+    SharedSegment segment;
+    const SpectatorHeader* header;
+    uint64_t lastFrame;
+
+public:
+    SpectatorView();
+
+    bool attach(const std::string& feedName);
+    void detach();
+    bool isAttached() const;
+    bool isClosed() const; // The game has gone; attach again to follow the next one
+    int getWidth() const;
+    int getHeight() const;
+
+    // Copies the newest frame if it is newer than the last one read
+    bool readLatest(SpectatorFrame& frame);
+};
@@ -0,0 +1,454 @@
+#include "telemetry_log.h"
+#include "file_lock.h"
+#include "utils.h"
+#include <cstddef>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    const char FILE_MAGIC[8] = { 'S', 'N', 'K', 'T', 'E', 'L', 'E', 'M' };
+    const char BLOCK_MAGIC[4] = { 'T', 'B', 'L', 'K' };
+    const size_t HEADER_SIZE = 16;
+    const size_t BLOCK_HEADER_SIZE = 8;
+
+    struct ColumnInfo {
+        const char* name;
+        size_t width;
+        size_t offset; // Within TelemetryRow
+    };
+
+    const ColumnInfo COLUMNS[COLUMN_COUNT] = {
+        { "seed", 8, offsetof(TelemetryRow, seed) },
+        { "time", 8, offsetof(TelemetryRow, time) },
+        { "ticks", 4, offsetof(TelemetryRow, ticks) },
+        { "length", 4, offsetof(TelemetryRow, length) },
+        { "score", 4, offsetof(TelemetryRow, score) },
+        { "food", 4, offsetof(TelemetryRow, foodEaten) },
+        { "inputs", 4, offsetof(TelemetryRow, inputs) },
+        { "tick_ns", 4, offsetof(TelemetryRow, meanTickNanos) },
+        { "difficulty", 1, offsetof(TelemetryRow, difficulty) },
+        { "mode", 1, offsetof(TelemetryRow, mode) },
+        { "cause", 1, offsetof(TelemetryRow, cause) },
+        { "controller", 1, offsetof(TelemetryRow, controller) }
+    };
+
+    const char* const CONTROLLER_NAMES[CONTROLLER_COUNT] = {
+        "player", "none", "greedy", "astar", "mcts", "mlp"
+    };
+
+    // Labels for the small enum columns, in enum order (Difficulty, GameMode, DeathCause)
+    const char* const DIFFICULTY_NAMES[] = { "easy", "normal", "hard" };
+    const char* const MODE_NAMES[] = { "classic", "wrap", "marathon" };
+    const char* const CAUSE_NAMES[] = { "none", "wall", "self", "obstacle" };
+
+    size_t padded(size_t bytes) {
+        return (bytes + 7) & ~static_cast<size_t>(7);
+    }
+
+    size_t blockSize(size_t rows) {
+        size_t size = BLOCK_HEADER_SIZE;
+        for (const ColumnInfo& column : COLUMNS) {
+            size += rows * column.width;
+        }
+        return padded(size);
+    }
+
+    // Whether a block header starts a whole block within the available
+    // bytes (the header's included)
+    bool isWholeBlock(const unsigned char* header, uint64_t available, uint32_t& rows) {
+        if (available < BLOCK_HEADER_SIZE || std::memcmp(header, BLOCK_MAGIC, sizeof(BLOCK_MAGIC)) != 0) {
+            return false;
+        }
+        std::memcpy(&rows, header + 4, 4);
+        return rows > 0 && rows <= TelemetryLog::BLOCK_ROWS && available >= blockSize(rows);
+    }
+}
+
+const char* TelemetryLog::getColumnName(int column) {
+    return COLUMNS[column].name;
+}
+
+size_t TelemetryLog::getColumnWidth(int column) {
+    return COLUMNS[column].width;
+}
+
+std::string TelemetryLog::getValueName(int column, int value) {
+    const char* const* names = nullptr;
+    int count = 0;
+    switch (column) {
+        case COLUMN_DIFFICULTY:
+            if (value == TELEMETRY_NO_DIFFICULTY) {
+                return "headless";
+            }
+            names = DIFFICULTY_NAMES;
+            count = 3;
+            break;
+        case COLUMN_MODE:
+            names = MODE_NAMES;
+            count = 3;
+            break;
+        case COLUMN_CAUSE:
+            names = CAUSE_NAMES;
+            count = 4;
+            break;
+        case COLUMN_CONTROLLER:
+            names = CONTROLLER_NAMES;
+            count = CONTROLLER_COUNT;
+            break;
+        default:
+            break;
+    }
+    if (names && value >= 0 && value < count) {
+        return names[value];
+    }
+    return std::to_string(value);
+}
+
+int TelemetryLog::findController(const std::string& botName) {
+    if (botName.empty()) {
+        return CONTROLLER_PLAYER;
+    }
+    for (int controller = CONTROLLER_NONE; controller < CONTROLLER_COUNT; controller++) {
+        if (botName == CONTROLLER_NAMES[controller]) {
+            return controller;
+        }
+    }
+    return CONTROLLER_COUNT;
+}
+
+#ifdef _WIN32
+TelemetryLog::TelemetryLog()
+    : fileHandle(INVALID_HANDLE_VALUE), bufferedRows(0), writtenRows(0), checkedSize(0) {
+}
+#else
+TelemetryLog::TelemetryLog() : fileDescriptor(-1), bufferedRows(0), writtenRows(0), checkedSize(0) {
+}
+#endif
+
+TelemetryLog::~TelemetryLog() {
+    close();
+}
+
+bool TelemetryLog::open(const std::string& logFile) {
+    close();
+
+    // Held while the file is checked, so no other writer is halfway through a block
+    FileLock lock(logFile, true);
+    if (!lock.isLocked()) {
+        Utils::logError("Could not lock telemetry file " + logFile);
+        return false;
+    }
+    if (!openFile(logFile)) {
+        Utils::logError("Could not open telemetry file " + logFile);
+        return false;
+    }
+    filename = logFile;
+
+    // An existing file must be ours; anything else is left alone
+    uint32_t version = VERSION;
+    uint32_t columnCount = COLUMN_COUNT;
+    unsigned char header[HEADER_SIZE];
+    uint64_t size = 0;
+    if (!getFileSize(size)) {
+        Utils::logError("Could not read telemetry file " + logFile);
+        closeFile();
+        return false;
+    }
+    if (size == 0) {
+        std::memcpy(header, FILE_MAGIC, sizeof(FILE_MAGIC));
+        std::memcpy(header + 8, &version, 4);
+        std::memcpy(header + 12, &columnCount, 4);
+        if (!appendData(header, sizeof(header))) {
+            Utils::logError("Could not write telemetry file " + logFile);
+            closeFile();
+            return false;
+        }
+    } else if (size < HEADER_SIZE || !readAt(0, header, sizeof(header))) {
+        Utils::logError("Not a telemetry file: " + logFile);
+        closeFile();
+        return false;
+    } else if (std::memcmp(header, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 ||
+               std::memcmp(header + 8, &version, 4) != 0 || std::memcmp(header + 12, &columnCount, 4) != 0) {
+        Utils::logError("Not a version " + std::to_string(VERSION) + " telemetry file: " + logFile);
+        closeFile();
+        return false;
+    }
+
+    checkedSize = HEADER_SIZE;
+    if (!repairTail()) {
+        closeFile();
+        return false;
+    }
+
+    for (int column = 0; column < COLUMN_COUNT; column++) {
+        columns[column].resize(BLOCK_ROWS * COLUMNS[column].width);
+    }
+    block.reserve(blockSize(BLOCK_ROWS));
+    bufferedRows = 0;
+    writtenRows = 0;
+    return true;
+}
+
+bool TelemetryLog::append(const TelemetryRow& row) {
+    if (!isOpen()) {
+        return false;
+    }
+    const unsigned char* fields = reinterpret_cast<const unsigned char*>(&row);
+    for (int column = 0; column < COLUMN_COUNT; column++) {
+        size_t width = COLUMNS[column].width;
+        std::memcpy(columns[column].data() + bufferedRows * width, fields + COLUMNS[column].offset, width);
+    }
+    if (++bufferedRows == BLOCK_ROWS) {
+        return writeBlock();
+    }
+    return true;
+}
+
+bool TelemetryLog::writeBlock() {
+    if (bufferedRows == 0) {
+        return true;
+    }
+
+    // Laid out in memory first, so the block goes out in one write
+    uint32_t rows = static_cast<uint32_t>(bufferedRows);
+    block.resize(blockSize(bufferedRows));
+    std::memcpy(block.data(), BLOCK_MAGIC, sizeof(BLOCK_MAGIC));
+    std::memcpy(block.data() + 4, &rows, 4);
+    size_t written = BLOCK_HEADER_SIZE;
+    for (int column = 0; column < COLUMN_COUNT; column++) {
+        size_t bytes = bufferedRows * COLUMNS[column].width;
+        std::memcpy(block.data() + written, columns[column].data(), bytes);
+        written += bytes;
+    }
+    std::memset(block.data() + written, 0, block.size() - written);
+
+    writtenRows += bufferedRows;
+    bufferedRows = 0;
+
+    // Another writer may have appended, or died halfway through a block, since our last one
+    FileLock lock(filename, true);
+    if (!lock.isLocked() || !repairTail() || !appendData(block.data(), block.size())) {
+        Utils::logError("Could not write telemetry to " + filename);
+        return false;
+    }
+    checkedSize += block.size();
+    return true;
+}
+
+bool TelemetryLog::repairTail() {
+    uint64_t size = 0;
+    if (!getFileSize(size) || size < HEADER_SIZE) {
+        Utils::logError("Telemetry file " + filename + " was cut short by another program");
+        return false;
+    }
+    if (size < checkedSize) {
+        checkedSize = HEADER_SIZE;
+    }
+
+    // Only block headers are read, from the end of what is known to be whole
+    uint64_t offset = checkedSize;
+    while (offset < size) {
+        unsigned char header[BLOCK_HEADER_SIZE];
+        uint32_t rows = 0;
+        if (size - offset < BLOCK_HEADER_SIZE || !readAt(offset, header, sizeof(header)) ||
+            !isWholeBlock(header, size - offset, rows)) {
+            break;
+        }
+        offset += blockSize(rows);
+    }
+    if (offset < size) {
+        if (!truncateFile(offset)) {
+            Utils::logError("Could not remove the damaged end of telemetry file " + filename);
+            return false;
+        }
+        Utils::logError("Removed " + std::to_string(size - offset) + " damaged bytes from the end of telemetry file " +
+                        filename);
+    }
+    checkedSize = offset;
+    return true;
+}
+
+bool TelemetryLog::flush() {
+    return isOpen() && writeBlock();
+}
+
+void TelemetryLog::close() {
+    if (isOpen()) {
+        writeBlock();
+        closeFile();
+    }
+    for (std::vector<unsigned char>& column : columns) {
+        std::vector<unsigned char>().swap(column);
+    }
+    std::vector<unsigned char>().swap(block);
+}
+
+#ifdef _WIN32
+bool TelemetryLog::openFile(const std::string& logFile) {
+    fileHandle = CreateFileA(logFile.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                             nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    return fileHandle != INVALID_HANDLE_VALUE;
+}
+
+void TelemetryLog::closeFile() {
+    CloseHandle(fileHandle);
+    fileHandle = INVALID_HANDLE_VALUE;
+}
+
+bool TelemetryLog::isOpen() const {
+    return fileHandle != INVALID_HANDLE_VALUE;
+}
+
+bool TelemetryLog::getFileSize(uint64_t& size) const {
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize)) {
+        return false;
+    }
+    size = static_cast<uint64_t>(fileSize.QuadPart);
+    return true;
+}
+
+bool TelemetryLog::readAt(uint64_t offset, void* data, size_t size) const {
+    OVERLAPPED position;
+    ZeroMemory(&position, sizeof(position));
+    position.Offset = static_cast<DWORD>(offset);
+    position.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    DWORD read = 0;
+    return ReadFile(fileHandle, data, static_cast<DWORD>(size), &read, &position) && read == size;
+}
+
+bool TelemetryLog::truncateFile(uint64_t size) {
+    LARGE_INTEGER end;
+    end.QuadPart = static_cast<LONGLONG>(size);
+    return SetFilePointerEx(fileHandle, end, nullptr, FILE_BEGIN) && SetEndOfFile(fileHandle);
+}
+
+bool TelemetryLog::appendData(const unsigned char* data, size_t size) {
+    LARGE_INTEGER start;
+    start.QuadPart = 0;
+    if (!SetFilePointerEx(fileHandle, start, nullptr, FILE_END)) {
+        return false;
+    }
+    DWORD written = 0;
+    return WriteFile(fileHandle, data, static_cast<DWORD>(size), &written, nullptr) && written == size;
+}
+#else
+bool TelemetryLog::openFile(const std::string& logFile) {
+    // O_APPEND: every write lands at the end, wherever other writers left it
+    fileDescriptor = ::open(logFile.c_str(), O_RDWR | O_APPEND | O_CREAT, 0644);
+    return fileDescriptor >= 0;
+}
+
+void TelemetryLog::closeFile() {
+    ::close(fileDescriptor);
+    fileDescriptor = -1;
+}
+
+bool TelemetryLog::isOpen() const {
+    return fileDescriptor >= 0;
+}
+
+bool TelemetryLog::getFileSize(uint64_t& size) const {
+    struct stat info;
+    if (fstat(fileDescriptor, &info) != 0) {
+        return false;
+    }
+    size = static_cast<uint64_t>(info.st_size);
+    return true;
+}
+
+bool TelemetryLog::readAt(uint64_t offset, void* data, size_t size) const {
+    return pread(fileDescriptor, data, size, static_cast<off_t>(offset)) == static_cast<ssize_t>(size);
+}
+
+bool TelemetryLog::truncateFile(uint64_t size) {
+    return ftruncate(fileDescriptor, static_cast<off_t>(size)) == 0;
+}
+
+bool TelemetryLog::appendData(const unsigned char* data, size_t size) {
+    // One write; the loop only picks up after a short write
+    size_t offset = 0;
+    while (offset < size) {
+        ssize_t written = ::write(fileDescriptor, data + offset, size - offset);
+        if (written <= 0) {
+            return false;
+        }
+        offset += static_cast<size_t>(written);
+    }
+    return true;
+}
+#endif
+
+uint64_t TelemetryLog::getWrittenRows() const {
+    return writtenRows;
+}
+
+TelemetryFile::TelemetryFile() : rowCount(0), truncated(false) {
+}
+
+bool TelemetryFile::open(const std::string& logFile) {
+    blocks.clear();
+    rowCount = 0;
+    truncated = false;
+    {
+        // Mapped while no writer is halfway through a block
+        FileLock lock(logFile, false);
+        if (!mapping.open(logFile)) {
+            Utils::logError("Could not map telemetry file " + logFile);
+            return false;
+        }
+    }
+
+    const unsigned char* data = mapping.data();
+    size_t size = mapping.size();
+    uint32_t version = TelemetryLog::VERSION;
+    uint32_t columnCount = COLUMN_COUNT;
+    if (size < HEADER_SIZE || std::memcmp(data, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 ||
+        std::memcmp(data + 8, &version, 4) != 0 || std::memcmp(data + 12, &columnCount, 4) != 0) {
+        Utils::logError("Not a version " + std::to_string(TelemetryLog::VERSION) + " telemetry file: " + logFile);
+        return false;
+    }
+
+    // Only block headers are read here; the columns stay untouched until scanned
+    size_t offset = HEADER_SIZE;
+    while (offset < size) {
+        uint32_t rows = 0;
+        if (!isWholeBlock(data + offset, size - offset, rows)) {
+            truncated = true;
+            break;
+        }
+
+        Block block;
+        block.rows = rows;
+        size_t column = offset + BLOCK_HEADER_SIZE;
+        for (int i = 0; i < COLUMN_COUNT; i++) {
+            block.columns[i] = data + column;
+            column += rows * COLUMNS[i].width;
+        }
+        blocks.push_back(block);
+        rowCount += rows;
+        offset += blockSize(rows);
+    }
+    return true;
+}
+
+uint64_t TelemetryFile::getRowCount() const {
+    return rowCount;
+}
+
+size_t TelemetryFile::getBlockCount() const {
+    return blocks.size();
+}
+
+size_t TelemetryFile::getBlockRows(size_t block) const {
+    return blocks[block].rows;
+}
+
+bool TelemetryFile::isTruncated() const {
+    return truncated;
+}
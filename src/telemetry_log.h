@@ -0,0 +1,156 @@
+#pragma once
+#include "mapped_file.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Who played a game, for telemetry group-bys
+enum TelemetryController {
+    CONTROLLER_PLAYER,
+    CONTROLLER_NONE,    // Headless run with no bot: the snake goes straight
+    CONTROLLER_GREEDY,
+    CONTROLLER_ASTAR,
+    CONTROLLER_MCTS,
+    CONTROLLER_MLP,
+    CONTROLLER_COUNT
+};
+
+// Difficulty of headless games, which have no speed curve
+const uint8_t TELEMETRY_NO_DIFFICULTY = 0xFF;
+
+// One finished game
+struct TelemetryRow {
+    uint64_t seed;
+    int64_t time;           // Unix seconds when the game ended
+    uint32_t ticks;
+    uint32_t length;        // Final snake length
+    uint32_t score;
+    uint32_t foodEaten;
+    uint32_t inputs;        // Direction changes applied
+    uint32_t meanTickNanos; // Time to compute a tick, bot included
+    uint8_t difficulty;     // Difficulty, or TELEMETRY_NO_DIFFICULTY
+    uint8_t mode;           // GameMode
+    uint8_t cause;          // DeathCause; DEATH_NONE = quit or tick limit
+    uint8_t controller;     // TelemetryController
+};
+
+// Columns of a telemetry file, in storage order (widest first, so every
+// column in a block starts aligned for its type)
+enum TelemetryColumn {
+    COLUMN_SEED,
+    COLUMN_TIME,
+    COLUMN_TICKS,
+    COLUMN_LENGTH,
+    COLUMN_SCORE,
+    COLUMN_FOOD,
+    COLUMN_INPUTS,
+    COLUMN_TICK_NANOS,
+    COLUMN_DIFFICULTY,
+    COLUMN_MODE,
+    COLUMN_CAUSE,
+    COLUMN_CONTROLLER,
+    COLUMN_COUNT
+};
+
+// Per-game telemetry, stored column by column.
+//
+// File: "SNKTELEM", then uint32 version and column count. Then blocks of up
+// to BLOCK_ROWS rows, each one "TBLK", uint32 row count, then every column's
+// values for those rows back to back (native byte order), padded to 8
+// bytes. A scan of one column reads only that column's bytes, straight out
+// of a memory mapping.
+//
+// Rows are buffered and written a whole block at a time; flush() writes a
+// short block, so a file can hold blocks of any size. Each block goes out in
+// one write under the file's FileLock, so games and headless runs can log
+// to the same file at once. A block cut off by a crash is removed by the
+// next writer before it appends, rather than hiding every block after it.
+// Not thread-safe.
+class TelemetryLog {
+public:
+    static const size_t BLOCK_ROWS = 65536;
+    static const uint32_t VERSION = 1;
+
+    static const char* getColumnName(int column);
+    static size_t getColumnWidth(int column);
+    static int findController(const std::string& botName); // "player" for an empty name
+
+    // Label of a difficulty, mode, cause or controller value, for reports
+    static std::string getValueName(int column, int value);
+
+private:
+#ifdef _WIN32
+    HANDLE fileHandle;
+#else
+    int fileDescriptor;
+#endif
+    std::string filename;
+    std::vector<unsigned char> columns[COLUMN_COUNT]; // Buffered block, one array per column
+    std::vector<unsigned char> block;                 // The block as written, reused
+    size_t bufferedRows;
+    uint64_t writtenRows;
+    uint64_t checkedSize; // The file holds whole blocks up to here
+
+    bool writeBlock();
+    bool repairTail(); // Cuts a damaged block at the end off; needs the lock
+
+    // Native file access
+    bool openFile(const std::string& logFile);
+    void closeFile();
+    bool getFileSize(uint64_t& size) const;
+    bool readAt(uint64_t offset, void* data, size_t size) const;
+    bool truncateFile(uint64_t size);
+    bool appendData(const unsigned char* data, size_t size);
+
+public:
+    TelemetryLog();
+    ~TelemetryLog();
+
+    // Appends to the file, starting it if it is new or empty and cutting a
+    // damaged last block off. False if it cannot be opened or locked, or is
+    // not a telemetry file of this version.
+    bool open(const std::string& logFile);
+    bool isOpen() const;
+    bool append(const TelemetryRow& row);
+    bool flush();
+    void close();
+    uint64_t getWrittenRows() const;
+};
+
+// Read access to a telemetry file through a memory mapping
+class TelemetryFile {
+private:
+    struct Block {
+        size_t rows;
+        const unsigned char* columns[COLUMN_COUNT];
+    };
+
+    MappedFile mapping;
+    std::vector<Block> blocks;
+    uint64_t rowCount;
+    bool truncated;
+
+public:
+    TelemetryFile();
+
+    // False if the file cannot be mapped or has the wrong header. A damaged
+    // or cut-off block ends the readable part (see isTruncated()).
+    bool open(const std::string& logFile);
+
+    uint64_t getRowCount() const;
+    size_t getBlockCount() const;
+    size_t getBlockRows(size_t block) const;
+    bool isTruncated() const;
+
+    // A column's values within one block, getBlockRows(block) of them, of
+    // the column's type (uint64_t, int64_t, uint32_t or uint8_t)
+    template <class T>
+    const T* getColumn(size_t block, int column) const {
+        return reinterpret_cast<const T*>(blocks[block].columns[column]);
+    }
+};
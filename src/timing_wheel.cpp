@@ -0,0 +1,141 @@
+#include "timing_wheel.h"
+#include <algorithm>
+
+TimingWheel::TimingWheel() : now(0), pending(0) {
+    slotHeads.assign(LEVELS * SLOTS, -1);
+}
+
+void TimingWheel::resize(int capacity) {
+    clear();
+    timers.assign(static_cast<size_t>(capacity), Timer{ 0, -1, -1, -1 });
+    fired.reserve(static_cast<size_t>(capacity));
+}
+
+void TimingWheel::clear() {
+    // With nothing pending every slot list is already empty
+    if (pending > 0) {
+        std::fill(slotHeads.begin(), slotHeads.end(), -1);
+        for (Timer& timer : timers) {
+            timer = Timer{ 0, -1, -1, -1 };
+        }
+    }
+    fired.clear();
+    now = 0;
+    pending = 0;
+}
+
+void TimingWheel::link(int id) {
+    Timer& timer = timers[id];
+    uint64_t delta = timer.deadline - now;
+
+    // Pick the finest level whose range still covers the deadline
+    int level = 0;
+    while (level < LEVELS - 1 && delta >= (uint64_t(1) << (SLOT_BITS * (level + 1)))) {
+        level++;
+    }
+    int slot = level * SLOTS + static_cast<int>((timer.deadline >> (SLOT_BITS * level)) & (SLOTS - 1));
+
+    timer.slot = slot;
+    timer.prev = -1;
+    timer.next = slotHeads[slot];
+    if (timer.next >= 0) {
+        timers[timer.next].prev = id;
+    }
+    slotHeads[slot] = id;
+}
+
+void TimingWheel::unlink(int id) {
+    Timer& timer = timers[id];
+    if (timer.prev >= 0) {
+        timers[timer.prev].next = timer.next;
+    } else {
+        slotHeads[timer.slot] = timer.next;
+    }
+    if (timer.next >= 0) {
+        timers[timer.next].prev = timer.prev;
+    }
+    timer.slot = -1;
+    timer.next = -1;
+    timer.prev = -1;
+}
+
+void TimingWheel::schedule(int id, uint64_t deadline) {
+    if (timers[id].slot >= 0) {
+        unlink(id);
+        pending--;
+    }
+
+    // Deadlines in the past fire on the next tick; very far ones are clamped
+    if (deadline <= now) {
+        deadline = now + 1;
+    } else if (deadline - now > MAX_DELAY) {
+        deadline = now + MAX_DELAY;
+    }
+
+    timers[id].deadline = deadline;
+    link(id);
+    pending++;
+}
+
+void TimingWheel::cancel(int id) {
+    if (timers[id].slot < 0) {
+        return;
+    }
+    unlink(id);
+    pending--;
+}
+
+bool TimingWheel::isScheduled(int id) const {
+    return timers[id].slot >= 0;
+}
+
+void TimingWheel::cascade(int level) {
+    // Re-file every timer in the current slot of this level one level down
+    int slot = level * SLOTS + static_cast<int>((now >> (SLOT_BITS * level)) & (SLOTS - 1));
+    int id = slotHeads[slot];
+    slotHeads[slot] = -1;
+    while (id >= 0) {
+        int next = timers[id].next;
+        link(id);
+        id = next;
+    }
+}
+
+const std::vector<int>& TimingWheel::advance() {
+    fired.clear();
+    now++;
+
+    // When level 0 wraps, pull the next slot of each wrapped level above down
+    if ((now & (SLOTS - 1)) == 0) {
+        int top = 1;
+        while (top + 1 < LEVELS && (now & ((uint64_t(1) << (SLOT_BITS * top)) * SLOTS - 1)) == 0) {
+            top++;
+        }
+        for (int level = top; level >= 1; --level) {
+            cascade(level);
+        }
+    }
+
+    int slot = static_cast<int>(now & (SLOTS - 1));
+    int id = slotHeads[slot];
+    slotHeads[slot] = -1;
+    while (id >= 0) {
+        Timer& timer = timers[id];
+        int next = timer.next;
+        timer.slot = -1;
+        timer.next = -1;
+        timer.prev = -1;
+        fired.push_back(id);
+        pending--;
+        id = next;
+    }
+    return fired;
+}
+
+uint64_t TimingWheel::getNow() const {
+    return now;
+}
+
+int TimingWheel::getPending() const {
+    return pending;
+}
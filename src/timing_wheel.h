@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Hierarchical timing wheel keyed by small integer ids.
+// Scheduling and cancelling are O(1); advancing one tick costs O(1) plus the
+// timers that actually fire (or cascade), independent of how many are pending.
+class TimingWheel {
+private:
+    static const int LEVELS = 4;
+    static const int SLOT_BITS = 6;
+    static const int SLOTS = 1 << SLOT_BITS;
+    static const uint64_t MAX_DELAY = (uint64_t(1) << (SLOT_BITS * LEVELS)) - 1;
+
+    struct Timer {
+        uint64_t deadline;
+        int next;
+        int prev;
+        int slot; // Index into slotHeads, -1 when not scheduled
+    };
+
+    std::vector<Timer> timers;
+    std::vector<int> slotHeads;  // LEVELS * SLOTS list heads
+    std::vector<int> fired;      // Ids that expired on the last advance()
+    uint64_t now;
+    int pending;
+
+    void link(int id);
+    void unlink(int id);
+    void cascade(int level);
+
+public:
+    TimingWheel();
+
+    void resize(int capacity);
+    void clear();
+
+    // Timer management
+    void schedule(int id, uint64_t deadline);
+    void cancel(int id);
+    bool isScheduled(int id) const;
+
+    // Moves time forward one tick; returns the ids that expired
+    const std::vector<int>& advance();
+
+    uint64_t getNow() const;
+    int getPending() const;
+};
@@ -0,0 +1,371 @@
+#include "tournament.h"
+#include "agent_process.h"
+#include "simulation.h"
+#include "utils.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+namespace {
+    const char DIRECTION_LETTERS[4] = { 'U', 'D', 'L', 'R' };
+
+    bool directionFromLetter(char letter, Direction& direction) {
+        for (int i = 0; i < 4; i++) {
+            if (DIRECTION_LETTERS[i] == letter) {
+                direction = static_cast<Direction>(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // One agent's side of a match
+    struct PlayerGame {
+        std::unique_ptr<Simulation> sim;
+        int id;
+        int score;
+        long long ticks;
+        bool running;
+    };
+}
+
+// Plays whole pairings with its own set of agent processes, so workers never
+// share a pipe. Counters are kept per worker and added up at the end.
+class Tournament::Worker {
+private:
+    const TournamentSettings& settings;
+    std::vector<std::unique_ptr<AgentProcess>> processes;
+    std::vector<bool> closed;       // Started, then died or hung up: its snakes go straight
+    std::vector<uint64_t> sequence; // Last frame sent to each agent
+    std::string message;
+    std::string line;
+
+    // An agent that cannot be started plays on as if it had crashed
+    void ensureStarted(int agent) {
+        if (processes[agent]) {
+            return;
+        }
+        processes[agent].reset(new AgentProcess());
+        AgentProcess& process = *processes[agent];
+        if (!process.start(stats[agent].command)) {
+            error = "Could not start agent: " + stats[agent].command;
+            closed[agent] = true;
+            return;
+        }
+
+        std::ostringstream hello;
+        hello << "snake 1 " << settings.width << " " << settings.height << " " << Simulation::getModeKey(settings.mode)
+              << " " << (settings.level.empty() ? "-" : settings.level) << "\n";
+        int64_t deadline = LatencyHistogram::now() + static_cast<int64_t>(HELLO_TIMEOUT_MS) * 1000;
+        if (!process.writeAll(hello.str(), deadline) || process.readLine(line, deadline) != AgentProcess::READ_LINE) {
+            error = "Agent did not introduce itself: " + stats[agent].command;
+            closed[agent] = true;
+            return;
+        }
+        stats[agent].name = line;
+    }
+
+    // Sends one frame: the next move for each running game of this side
+    bool sendFrame(int agent, const std::vector<PlayerGame>& games, std::vector<int>& asked, int64_t deadline) {
+        asked.clear();
+        message.clear();
+        for (size_t k = 0; k < games.size(); k++) {
+            if (!games[k].running) {
+                continue;
+            }
+            asked.push_back(static_cast<int>(k));
+            const Simulation& sim = *games[k].sim;
+            const Snake& snake = sim.getSnake();
+            Position food = sim.getFood().getPosition();
+            message += std::to_string(games[k].id) + " " + DIRECTION_LETTERS[snake.getDirection()] + " " +
+                       std::to_string(food.x) + " " + std::to_string(food.y) + " " + std::to_string(snake.getLength());
+            snake.forEachSegment([this](const Position& segment) {
+                message += " " + std::to_string(segment.x) + " " + std::to_string(segment.y);
+            });
+            message += "\n";
+        }
+        if (asked.empty()) {
+            return false;
+        }
+
+        sequence[agent]++;
+        message.insert(0, "frame " + std::to_string(sequence[agent]) + " " + std::to_string(asked.size()) + "\n");
+        if (!closed[agent] && !processes[agent]->writeAll(message, deadline)) {
+            error = "Agent stopped reading: " + stats[agent].command;
+            closed[agent] = true;
+        }
+        return true;
+    }
+
+    // Applies the agent's reply to this frame, if it arrives by the deadline
+    void readMoves(int agent, std::vector<PlayerGame>& games, const std::vector<int>& asked,
+                   int64_t sentAt, int64_t deadline) {
+        AgentStats& agentStats = stats[agent];
+        agentStats.frames++;
+        agentStats.moves += static_cast<long long>(asked.size());
+
+        while (!closed[agent]) {
+            AgentProcess::ReadResult read = processes[agent]->readLine(line, deadline);
+            if (read == AgentProcess::READ_CLOSED) {
+                error = "Agent exited: " + agentStats.command;
+                closed[agent] = true;
+                break;
+            }
+            if (read == AgentProcess::READ_TIMEOUT) {
+                break;
+            }
+
+            // Replies to frames that already timed out are dropped
+            char* end = nullptr;
+            unsigned long long replySequence = std::strtoull(line.c_str(), &end, 10);
+            if (replySequence != sequence[agent]) {
+                continue;
+            }
+            agentStats.frameLatency.record(LatencyHistogram::now() - sentAt);
+
+            size_t start = line.find_first_not_of(' ', static_cast<size_t>(end - line.c_str()));
+            std::string moves = start == std::string::npos ? std::string() : line.substr(start);
+            for (size_t i = 0; i < asked.size(); i++) {
+                Direction direction;
+                if (i < moves.size() && directionFromLetter(moves[i], direction)) {
+                    games[asked[i]].sim->getSnake().setDirection(direction);
+                } else {
+                    agentStats.timeouts++;
+                }
+            }
+            return;
+        }
+        agentStats.timeouts += static_cast<long long>(asked.size());
+    }
+
+public:
+    std::vector<AgentStats> stats; // This worker's share; commands filled in
+    std::vector<MatchResult> results;
+    std::string error;
+
+    Worker(const TournamentSettings& settings, const std::vector<AgentStats>& agents)
+        : settings(settings), processes(agents.size()), closed(agents.size(), false),
+          sequence(agents.size(), 0), stats(agents.size()) {
+        for (size_t i = 0; i < agents.size(); i++) {
+            stats[i].command = agents[i].command;
+        }
+    }
+
+    bool play(int pair, int first, int second) {
+        ensureStarted(first);
+        ensureStarted(second);
+
+        const int seats[2] = { first, second };
+        std::vector<PlayerGame> games[2];
+        for (int side = 0; side < 2; side++) {
+            for (int k = 0; k < settings.matchesPerPair; k++) {
+                PlayerGame game;
+                game.sim.reset(new Simulation(settings.width, settings.height));
+                game.sim->seed(settings.seed + static_cast<uint64_t>(k));
+                game.sim->setMode(settings.mode);
+                if (!settings.level.empty() && !game.sim->loadLevel(settings.level)) {
+                    error = "Could not load level " + settings.level;
+                    return false;
+                }
+                game.sim->reset();
+                game.id = pair * settings.matchesPerPair + k;
+                game.score = 0;
+                game.ticks = 0;
+                game.running = true;
+                games[side].push_back(std::move(game));
+            }
+        }
+
+        // Both agents think at the same time: send both frames, then collect both replies
+        std::vector<int> asked[2];
+        while (true) {
+            bool sent[2];
+            int64_t sentAt = LatencyHistogram::now();
+            int64_t deadline = sentAt + static_cast<int64_t>(settings.moveTimeoutMs) * 1000;
+            for (int side = 0; side < 2; side++) {
+                sent[side] = sendFrame(seats[side], games[side], asked[side], deadline);
+            }
+            if (!sent[0] && !sent[1]) {
+                break;
+            }
+
+            for (int side = 0; side < 2; side++) {
+                if (!sent[side]) {
+                    continue;
+                }
+                readMoves(seats[side], games[side], asked[side], sentAt, deadline);
+                for (int k : asked[side]) {
+                    PlayerGame& game = games[side][k];
+                    StepResult result = game.sim->step();
+                    game.ticks++;
+                    if (result.ateFood) {
+                        game.score += result.points;
+                    }
+                    if (!result.alive || game.ticks >= settings.maxTicks) {
+                        game.running = false;
+                    }
+                }
+            }
+        }
+
+        for (int k = 0; k < settings.matchesPerPair; k++) {
+            const PlayerGame& a = games[0][k];
+            const PlayerGame& b = games[1][k];
+            double points = 0.5;
+            if (a.score != b.score) {
+                points = a.score > b.score ? 1.0 : 0.0;
+            } else if (a.ticks != b.ticks) {
+                points = a.ticks > b.ticks ? 1.0 : 0.0;
+            }
+            results.push_back(MatchResult{ pair, k, first, second, points });
+        }
+        return true;
+    }
+};
+
+Tournament::Tournament(const TournamentSettings& settings)
+    : settings(settings), matchCount(0), elapsedSeconds(0.0) {
+}
+
+void Tournament::addAgent(const std::string& commandLine) {
+    AgentStats stats;
+    stats.command = commandLine;
+    agents.push_back(stats);
+}
+
+bool Tournament::run() {
+    std::vector<std::pair<int, int>> pairs;
+    for (size_t i = 0; i < agents.size(); i++) {
+        for (size_t j = i + 1; j < agents.size(); j++) {
+            pairs.emplace_back(static_cast<int>(i), static_cast<int>(j));
+        }
+    }
+
+    int workerCount = settings.workers > 0 ? settings.workers : static_cast<int>(std::thread::hardware_concurrency());
+    workerCount = std::max(1, std::min(workerCount, static_cast<int>(pairs.size())));
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int i = 0; i < workerCount; i++) {
+        workers.emplace_back(new Worker(settings, agents));
+    }
+
+    // Workers take the next unplayed pairing until none are left
+    std::atomic<size_t> nextPair(0);
+    std::atomic<bool> failed(false); // A level that will not load; agent trouble only forfeits moves
+    auto startTime = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < workerCount; i++) {
+        Worker* worker = workers[i].get();
+        threads.emplace_back([&, worker] {
+            size_t pair;
+            while (!failed.load() && (pair = nextPair.fetch_add(1)) < pairs.size()) {
+                if (!worker->play(static_cast<int>(pair), pairs[pair].first, pairs[pair].second)) {
+                    failed = true;
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    results.clear();
+    bool ok = true;
+    for (const std::unique_ptr<Worker>& worker : workers) {
+        if (!worker->error.empty()) {
+            Utils::logError(worker->error);
+            ok = false;
+        }
+        for (size_t i = 0; i < agents.size(); i++) {
+            const AgentStats& part = worker->stats[i];
+            if (agents[i].name.empty()) {
+                agents[i].name = part.name;
+            }
+            agents[i].moves += part.moves;
+            agents[i].frames += part.frames;
+            agents[i].timeouts += part.timeouts;
+            agents[i].frameLatency.merge(part.frameLatency);
+        }
+        results.insert(results.end(), worker->results.begin(), worker->results.end());
+    }
+    matchCount = static_cast<int>(results.size());
+    rate();
+    return ok;
+}
+
+void Tournament::rate() {
+    // Which worker finished first must not change the ratings
+    std::sort(results.begin(), results.end(), [](const MatchResult& a, const MatchResult& b) {
+        return a.pair != b.pair ? a.pair < b.pair : a.match < b.match;
+    });
+
+    for (const MatchResult& result : results) {
+        AgentStats& first = agents[result.first];
+        AgentStats& second = agents[result.second];
+        double expected = 1.0 / (1.0 + std::pow(10.0, (second.rating - first.rating) / 400.0));
+        double change = ELO_K * (result.firstPoints - expected);
+        first.rating += change;
+        second.rating -= change;
+
+        if (result.firstPoints > 0.5) {
+            first.wins++;
+            second.losses++;
+        } else if (result.firstPoints < 0.5) {
+            first.losses++;
+            second.wins++;
+        } else {
+            first.draws++;
+            second.draws++;
+        }
+    }
+}
+
+const std::vector<Tournament::AgentStats>& Tournament::getAgents() const {
+    return agents;
+}
+
+void Tournament::print(std::ostream& out) const {
+    std::vector<const AgentStats*> standings;
+    for (const AgentStats& agent : agents) {
+        standings.push_back(&agent);
+    }
+    std::stable_sort(standings.begin(), standings.end(), [](const AgentStats* a, const AgentStats* b) {
+        return a->rating > b->rating;
+    });
+
+    char row[256];
+    std::snprintf(row, sizeof(row), "%-24s %6s %5s %5s %5s %9s %8s %6s %8s %8s %8s",
+                  "Agent", "Elo", "W", "D", "L", "Moves", "Timeouts", "Batch", "p50 ms", "p95 ms", "p99 ms");
+    out << row << "\n";
+    for (const AgentStats* agent : standings) {
+        const LatencyHistogram& latency = agent->frameLatency;
+        std::string name = agent->name.empty() ? agent->command : agent->name;
+        if (name.size() > 24) {
+            name.resize(24);
+        }
+        double batch = agent->frames > 0 ? static_cast<double>(agent->moves) / agent->frames : 0.0;
+        std::snprintf(row, sizeof(row), "%-24s %6.0f %5d %5d %5d %9lld %8lld %6.1f %8.2f %8.2f %8.2f",
+                      name.c_str(), agent->rating, agent->wins, agent->draws, agent->losses,
+                      agent->moves, agent->timeouts, batch,
+                      latency.getPercentile(0.50) / 1000.0, latency.getPercentile(0.95) / 1000.0,
+                      latency.getPercentile(0.99) / 1000.0);
+        out << row << "\n";
+    }
+
+    long long moves = 0;
+    for (const AgentStats& agent : agents) {
+        moves += agent.moves;
+    }
+    double seconds = elapsedSeconds > 0.0 ? elapsedSeconds : 1.0;
+    std::snprintf(row, sizeof(row), "%d matches in %.2f s: %.1f matches/s, %.0f moves/s",
+                  matchCount, elapsedSeconds, matchCount / seconds, moves / seconds);
+    out << row << std::endl;
+}
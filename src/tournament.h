@@ -0,0 +1,90 @@
+#pragma once
+#include "latency_histogram.h"
+#include "rules.h"
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Round-robin tournament between agent programs, each run as a child process
+// that speaks a line protocol on stdin/stdout:
+//
+//   harness: snake 1 <width> <height> <classic|wrap|marathon> <level file or ->
+//   agent:   <name>
+//   harness: frame <seq> <count>
+//            <game> <U|D|L|R> <food x> <food y> <length> <x> <y> ...   (count lines, head first)
+//   agent:   <seq> <moves>      one U/D/L/R per game, in frame order
+//
+// Coordinates are 1-based inside the border. Every frame asks for the next
+// move in all of the agent's running games at once, so one pipe round trip
+// serves a whole batch. Game ids are never reused. A reply that misses the
+// move timeout leaves those snakes going straight; a late reply is told
+// apart by its sequence number and dropped. The harness closes stdin when done.
+//
+// Every pair of agents plays the same matchesPerPair boards (seed, seed + 1,
+// ...). A match is won on score, then on ticks survived.
+struct TournamentSettings {
+    int width;
+    int height;
+    GameMode mode;
+    std::string level;  // Optional level file, passed on to the agents
+    int matchesPerPair;
+    int maxTicks;       // A game still running after this many ticks ends there
+    int moveTimeoutMs;  // Per frame
+    int workers;        // Pairs played at once, each with its own agent processes; 0 = one per core
+    uint64_t seed;
+
+    TournamentSettings()
+        : width(40), height(20), mode(MODE_CLASSIC), matchesPerPair(16), maxTicks(2000),
+          moveTimeoutMs(100), workers(0), seed(1) {
+    }
+};
+
+class Tournament {
+public:
+    struct AgentStats {
+        std::string command;
+        std::string name;   // As the agent introduced itself
+        double rating;      // Elo
+        int wins;
+        int draws;
+        int losses;
+        long long moves;
+        long long frames;
+        long long timeouts; // Moves that fell back to going straight
+        LatencyHistogram frameLatency; // Frame sent to reply read, microseconds
+
+        AgentStats() : rating(1500.0), wins(0), draws(0), losses(0), moves(0), frames(0), timeouts(0) {}
+    };
+
+private:
+    struct MatchResult {
+        int pair;
+        int match;
+        int first;
+        int second;
+        double firstPoints; // 1 win, 0.5 draw, 0 loss
+    };
+
+    class Worker;
+
+    static const int ELO_K = 16;
+    static const int HELLO_TIMEOUT_MS = 5000;
+
+    TournamentSettings settings;
+    std::vector<AgentStats> agents;
+    std::vector<MatchResult> results;
+    int matchCount;
+    double elapsedSeconds;
+
+    void rate();
+
+public:
+    explicit Tournament(const TournamentSettings& settings);
+
+    void addAgent(const std::string& commandLine);
+    bool run(); // False if an agent failed to start or crashed (its games are still scored)
+
+    const std::vector<AgentStats>& getAgents() const;
+    void print(std::ostream& out) const; // Standings, then throughput
+};
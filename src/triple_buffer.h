@@ -0,0 +1,38 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Lock-free triple buffer for one producer and one consumer. The producer
+// always has a private back buffer to fill and publish; the consumer picks
+// up the most recently published one, so stale values are dropped instead
+// of queued and neither side ever waits for the other.
+template <class T>
+class TripleBuffer {
+private:
+    static const uint8_t INDEX_MASK = 0x03;
+    static const uint8_t FRESH = 0x04; // Middle holds a value the consumer has not seen
+
+    T buffers[3];
+    std::atomic<uint8_t> middle;
+    uint8_t back;  // Owned by the producer
+    uint8_t front; // Owned by the consumer
+
+public:
+    TripleBuffer() : middle(1), back(0), front(2) {}
+
+    // Producer side
+    T& getBack() { return buffers[back]; }
+    void publish() {
+        back = middle.exchange(static_cast<uint8_t>(back | FRESH), std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // Consumer side: returns true if a newer value was taken
+    bool update() {
+        if ((middle.load(std::memory_order_acquire) & FRESH) == 0) {
+            return false;
+        }
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+    const T& getFront() const { return buffers[front]; }
+};
@@ -1,10 +1,203 @@
 #include "utils.h"
-#include <windows.h>
+#include "file_lock.h"
 #include <ctime>
 #include <algorithm>
+#include <array>
 #include <cctype>
 #include <sstream>
 #include <iomanip>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+#ifdef _WIN32
+    const char PATH_SEPARATOR = '\\';
+#else
+    const char PATH_SEPARATOR = '/';
+#endif
+
+    std::string getExecutableDirectory() {
+        std::string exePath = Utils::getExecutablePath();
+        size_t lastSlash = exePath.find_last_of("\\/");
+        if (lastSlash == std::string::npos) {
+            return ".";
+        }
+        return exePath.substr(0, lastSlash);
+    }
+
+    // CRC-32 (IEEE) guarding each high score record
+    uint32_t crc32(const std::string& data) {
+        // Built once on first use; the static initialization is thread-safe,
+        // so the sim thread, score store and recorder can all call this
+        static const std::array<uint32_t, 256> table = [] {
+            std::array<uint32_t, 256> entries;
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t value = i;
+                for (int bit = 0; bit < 8; ++bit) {
+                    value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+                }
+                entries[i] = value;
+            }
+            return entries;
+        }();
+        uint32_t crc = 0xFFFFFFFFu;
+        for (unsigned char byte : data) {
+            crc = table[(crc ^ byte) & 0xFF] ^ (crc >> 8);
+        }
+        return crc ^ 0xFFFFFFFFu;
+    }
+
+    std::string recordBody(const HighScore& score) {
+        return score.playerName + "|" + std::to_string(score.score) + "|" + score.date;
+    }
+
+    // Reads the file and keeps only intact records; counts what was dropped or
+    // still in the old unchecked format
+    std::vector<HighScore> readHighScoreRecords(const std::string& filename, int& damaged, int& legacy) {
+        std::vector<HighScore> scores;
+        damaged = 0;
+        legacy = 0;
+        std::ifstream file(filename, std::ios::binary);
+        std::string line;
+        while (std::getline(file, line)) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (line.empty()) {
+                continue;
+            }
+            HighScore score;
+            if (!Utils::parseHighScoreRecord(line, score)) {
+                damaged++;
+            } else {
+                if (std::count(line.begin(), line.end(), '|') == 2) {
+                    legacy++;
+                }
+                scores.push_back(score);
+            }
+        }
+        return scores;
+    }
+
+#ifdef _WIN32
+    bool appendDurably(const std::string& filename, const std::string& data) {
+        HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ | FILE_APPEND_DATA, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                                  nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+
+        // Finish a record torn by a crash so it cannot swallow the next one
+        std::string block = data;
+        LARGE_INTEGER size;
+        if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+            LARGE_INTEGER last;
+            last.QuadPart = size.QuadPart - 1;
+            char byte = '\n';
+            DWORD read = 0;
+            if (SetFilePointerEx(file, last, nullptr, FILE_BEGIN) && ReadFile(file, &byte, 1, &read, nullptr) &&
+                read == 1 && byte != '\n') {
+                block.insert(block.begin(), '\n');
+            }
+        }
+
+        DWORD written = 0;
+        bool ok = WriteFile(file, block.data(), static_cast<DWORD>(block.size()), &written, nullptr) &&
+                  written == block.size() && FlushFileBuffers(file);
+        CloseHandle(file);
+        return ok;
+    }
+
+    bool replaceDurably(const std::string& filename, const std::string& data) {
+        std::string tempName = filename + ".tmp";
+        HANDLE file = CreateFileA(tempName.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                                  FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        DWORD written = 0;
+        bool ok = WriteFile(file, data.data(), static_cast<DWORD>(data.size()), &written, nullptr) &&
+                  written == data.size() && FlushFileBuffers(file);
+        CloseHandle(file);
+        if (!ok || !MoveFileExA(tempName.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+            DeleteFileA(tempName.c_str());
+            return false;
+        }
+        return true;
+    }
+#else
+    bool writeAll(int descriptor, const std::string& data) {
+        size_t offset = 0;
+        while (offset < data.size()) {
+            ssize_t written = write(descriptor, data.data() + offset, data.size() - offset);
+            if (written <= 0) {
+                return false;
+            }
+            offset += static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    bool appendDurably(const std::string& filename, const std::string& data) {
+        int descriptor = open(filename.c_str(), O_RDWR | O_APPEND | O_CREAT, 0644);
+        if (descriptor < 0) {
+            return false;
+        }
+
+        // Finish a record torn by a crash so it cannot swallow the next one
+        std::string block = data;
+        struct stat info;
+        char last = '\n';
+        if (fstat(descriptor, &info) == 0 && info.st_size > 0 &&
+            pread(descriptor, &last, 1, info.st_size - 1) == 1 && last != '\n') {
+            block.insert(block.begin(), '\n');
+        }
+
+        bool ok = writeAll(descriptor, block) && fsync(descriptor) == 0;
+        close(descriptor);
+        return ok;
+    }
+
+    bool replaceDurably(const std::string& filename, const std::string& data) {
+        std::string tempName = filename + ".tmp";
+        int descriptor = open(tempName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (descriptor < 0) {
+            return false;
+        }
+        bool ok = writeAll(descriptor, data) && fsync(descriptor) == 0;
+        close(descriptor);
+        if (!ok || rename(tempName.c_str(), filename.c_str()) != 0) {
+            unlink(tempName.c_str());
+            return false;
+        }
+
+        // Make the rename itself durable
+        std::string directory = getExecutableDirectory();
+        size_t slash = filename.find_last_of('/');
+        if (slash != std::string::npos) {
+            directory = filename.substr(0, slash);
+        }
+        int directoryDescriptor = open(directory.c_str(), O_RDONLY);
+        if (directoryDescriptor >= 0) {
+            fsync(directoryDescriptor);
+            close(directoryDescriptor);
+        }
+        return true;
+    }
+#endif
+}
 
 // HighScore implementation
 HighScore::HighScore(const std::string& name, int s, const std::string& d) 
@@ -16,6 +209,7 @@ bool HighScore::operator<(const HighScore& other) const {
 }
 
 // Utils implementation
+#ifdef _WIN32
 bool Utils::fileExists(const std::string& filename) {
     DWORD fileAttributes = GetFileAttributesA(filename.c_str());
     return (fileAttributes != INVALID_FILE_ATTRIBUTES && !(fileAttributes & FILE_ATTRIBUTE_DIRECTORY));
@@ -37,53 +231,190 @@ std::string Utils::getExecutablePath() {
     return std::string(buffer);
 }
 
+long Utils::getPeakMemoryKB() {
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return static_cast<long>(counters.PeakWorkingSetSize / 1024);
+}
+#else
+bool Utils::fileExists(const std::string& filename) {
+    struct stat info;
+    return stat(filename.c_str(), &info) == 0 && !S_ISDIR(info.st_mode);
+}
+
+bool Utils::createDirectory(const std::string& path) {
+    return mkdir(path.c_str(), 0755) == 0;
+}
+
+std::string Utils::getCurrentDirectory() {
+    char buffer[PATH_MAX];
+    if (getcwd(buffer, sizeof(buffer)) == nullptr) {
+        return ".";
+    }
+    return std::string(buffer);
+}
+
+std::string Utils::getExecutablePath() {
+    char buffer[PATH_MAX];
+    ssize_t length = readlink("/proc/self/exe", buffer, sizeof(buffer) - 1);
+    if (length <= 0) {
+        return "./ConsoleSnakeCpp";
+    }
+    buffer[length] = '\0';
+    return std::string(buffer);
+}
+
+long Utils::getPeakMemoryKB() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return usage.ru_maxrss; // Already in kilobytes on Linux
+}
+#endif
+
+std::string Utils::getResourcePath(const std::string& relativePath) {
+    // Data files (levels etc.) live next to the executable
+    return getExecutableDirectory() + PATH_SEPARATOR + relativePath;
+}
+
 std::string Utils::getHighScoreFileName() {
-    std::string exePath = getExecutablePath();
-    size_t lastSlash = exePath.find_last_of("\\/");
-    std::string directory = exePath.substr(0, lastSlash);
-    return directory + "\\highscores.txt";
+    return getExecutableDirectory() + PATH_SEPARATOR + "highscores.txt";
+}
+
+std::string Utils::getTelemetryFileName() {
+    return getExecutableDirectory() + PATH_SEPARATOR + "telemetry.snkt";
+}
+
+std::string Utils::formatHighScoreRecord(const HighScore& score) {
+    // name|score|date|crc32 of the first three fields
+    std::string body = recordBody(score);
+    char checksum[9];
+    snprintf(checksum, sizeof(checksum), "%08x", crc32(body));
+    return body + "|" + checksum;
+}
+
+bool Utils::parseHighScoreRecord(const std::string& line, HighScore& score) {
+    std::vector<std::string> parts = split(line, '|');
+    if (parts.size() != 3 && parts.size() != 4) {
+        return false;
+    }
+
+    const char* text = parts[1].c_str();
+    char* end = nullptr;
+    long value = std::strtol(text, &end, 10);
+    if (parts[1].empty() || *end != '\0' || value < 0 || value > 2000000000L) {
+        return false;
+    }
+    
+    // Dates are YYYY-MM-DD; anything else is a torn or foreign line
+    const std::string& date = parts[2];
+    if (date.size() != 10 || date[4] != '-' || date[7] != '-') {
+        return false;
+    }
+    for (size_t i = 0; i < date.size(); ++i) {
+        if (i != 4 && i != 7 && !isdigit(static_cast<unsigned char>(date[i]))) {
+            return false;
+        }
+    }
+    score = HighScore(parts[0], static_cast<int>(value), date);
+
+    // Records from older versions have no checksum
+    if (parts.size() == 3) {
+        return true;
+    }
+    char checksum[9];
+    snprintf(checksum, sizeof(checksum), "%08x", crc32(recordBody(score)));
+    return parts[3] == checksum;
 }
 
 bool Utils::saveHighScore(const HighScore& score) {
+    return appendHighScores(std::vector<HighScore>(1, score));
+}
+
+bool Utils::appendHighScores(const std::vector<HighScore>& scores) {
+    std::string block;
+    for (const HighScore& score : scores) {
+        block += formatHighScoreRecord(score) + "\n";
+    }
+
+    // One locked write and one fsync for the whole batch
     std::string filename = getHighScoreFileName();
-    std::ofstream file(filename, std::ios::app);
-    
-    if (!file.is_open()) {
+    FileLock lock(filename, true);
+    if (!lock.isLocked()) {
         return false;
     }
-    
-    file << score.playerName << "|" << score.score << "|" << score.date << std::endl;
-    file.close();
-    return true;
+    return appendDurably(filename, block);
 }
 
 std::vector<HighScore> Utils::loadHighScores() {
-    std::vector<HighScore> scores;
     std::string filename = getHighScoreFileName();
-    
     if (!fileExists(filename)) {
-        return scores;
+        return std::vector<HighScore>();
     }
     
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        return scores;
+    int damaged = 0;
+    int legacy = 0;
+    std::vector<HighScore> scores;
+    {
+        FileLock lock(filename, false);
+        scores = readHighScoreRecords(filename, damaged, legacy);
     }
     
-    std::string line;
-    while (std::getline(file, line)) {
-        std::vector<std::string> parts = split(line, '|');
-        if (parts.size() >= 3) {
-            scores.emplace_back(parts[0], std::stoi(parts[1]), parts[2]);
-        }
+    // Sort by score (highest first), ties in file order
+    std::stable_sort(scores.begin(), scores.end());
+    
+    return scores;
+}
+
+bool Utils::compactHighScores(size_t maxRecords) {
+    std::string filename = getHighScoreFileName();
+    if (!fileExists(filename)) {
+        return true;
+    }
+    
+    FileLock lock(filename, true);
+    if (!lock.isLocked()) {
+        return false;
     }
     
-    file.close();
+    int damaged = 0;
+    int legacy = 0;
+    std::vector<HighScore> scores = readHighScoreRecords(filename, damaged, legacy);
+    if (damaged == 0 && legacy == 0 && scores.size() <= maxRecords) {
+        return true;
+    }
     
-    // Sort by score (highest first)
-    std::sort(scores.begin(), scores.end());
+    // Over the limit: keep the best scores, still in file order
+    if (scores.size() > maxRecords) {
+        std::vector<HighScore> ranked = scores;
+        std::stable_sort(ranked.begin(), ranked.end());
+        int cutoff = maxRecords > 0 ? ranked[maxRecords - 1].score : 0;
+        size_t atCutoff = static_cast<size_t>(std::count_if(ranked.begin(), ranked.begin() + maxRecords,
+                                                            [cutoff](const HighScore& s) { return s.score == cutoff; }));
+        std::vector<HighScore> kept;
+        for (const HighScore& score : scores) {
+            if (maxRecords == 0 || score.score < cutoff) {
+                continue;
+            }
+            if (score.score == cutoff) {
+                if (atCutoff == 0) {
+                    continue;
+                }
+                atCutoff--;
+            }
+            kept.push_back(score);
+        }
+        scores.swap(kept);
+    }
     
-    return scores;
+    std::string data;
+    for (const HighScore& score : scores) {
+        data += formatHighScoreRecord(score) + "\n";
+    }
+    return replaceDurably(filename, data);
 }
 
 int Utils::getHighestScore() {
@@ -21,11 +21,18 @@ public:
     static bool createDirectory(const std::string& path);
     static std::string getCurrentDirectory();
     static std::string getExecutablePath();
+    static std::string getResourcePath(const std::string& relativePath);
+    static long getPeakMemoryKB();
     
-    // High score management
+    // High score management (checksummed records, locked against other instances)
     static std::string getHighScoreFileName();
+    static std::string getTelemetryFileName();
+    static std::string formatHighScoreRecord(const HighScore& score);
+    static bool parseHighScoreRecord(const std::string& line, HighScore& score);
     static bool saveHighScore(const HighScore& score);
+    static bool appendHighScores(const std::vector<HighScore>& scores);
     static std::vector<HighScore> loadHighScores();
+    static bool compactHighScores(size_t maxRecords);
     static int getHighestScore();
     static void displayHighScores();
     static bool isNewHighScore(int score);
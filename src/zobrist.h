@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+
+// What a Zobrist key stands for. Item keys follow ZOBRIST_ITEM, one per FoodKind.
+enum ZobristFeature {
+    ZOBRIST_BODY,       // Any snake segment, head included
+    ZOBRIST_HEAD,
+    ZOBRIST_TAIL,
+    ZOBRIST_FOOD,       // Main pellet
+    ZOBRIST_DIRECTION,
+    ZOBRIST_GROWTH,     // Segments still to be added
+    ZOBRIST_RANDOM,     // Food placement stream
+    ZOBRIST_COUNTDOWN,  // Ticks to the next extra item
+    ZOBRIST_ITEM
+};
+
+// Keys for hashing the world state. A state hash is the XOR of the keys of
+// everything in it, so a move updates it with a couple of XORs. Each key is
+// a fixed mix of what it stands for rather than an entry in a random table,
+// so hashes agree across builds, platforms and board sizes and take no memory.
+class Zobrist {
+private:
+    // splitmix64 finalizer
+    static uint64_t mix(uint64_t z) {
+        z += 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+public:
+    static uint64_t key(ZobristFeature feature, int x, int y) {
+        return mix((static_cast<uint64_t>(feature) << 48) ^ (static_cast<uint64_t>(static_cast<uint32_t>(x) & 0xFFFFFF) << 24) ^
+                   (static_cast<uint32_t>(y) & 0xFFFFFF));
+    }
+
+    static uint64_t key(ZobristFeature feature, uint64_t value) {
+        return mix(mix(value) ^ (static_cast<uint64_t>(feature) << 48) ^ 0x5A0B5A0B5A0B5A0Bull);
+    }
+};
@@ -0,0 +1,92 @@
+#include "../src/snake_env.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// Steps a batch of environments through the C API with random actions (or a
+// trained policy acting on the whole batch) and reports env-steps per second
+// on one core.
+// Usage: EnvBench [--envs N] [--steps N] [--mode 0|1|2] [--seed S] [--policy FILE]
+int main(int argc, char* argv[]) {
+    SnakeEnvConfig config;
+    snake_env_default_config(&config);
+    config.num_envs = 256;
+    long long steps = 20000;
+    uint64_t seed = 1;
+    const char* policyFile = nullptr;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--envs") == 0) {
+            config.num_envs = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--steps") == 0) {
+            steps = std::atoll(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--mode") == 0) {
+            config.mode = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--seed") == 0) {
+            seed = std::strtoull(argv[i + 1], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--policy") == 0) {
+            policyFile = argv[i + 1];
+        } else {
+            std::cerr << "Unknown option " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    SnakeEnv* env = snake_env_create(&config);
+    if (!env) {
+        std::cerr << "Invalid environment configuration" << std::endl;
+        return 1;
+    }
+
+    SnakePolicy* policy = nullptr;
+    if (policyFile) {
+        policy = snake_policy_load(policyFile);
+        if (!policy || snake_policy_input_size(policy) * config.num_envs != snake_env_observation_size(env)) {
+            std::cerr << "Policy " << policyFile << " does not fit a " << config.width << "x" << config.height
+                      << " board" << std::endl;
+            snake_policy_destroy(policy);
+            snake_env_destroy(env);
+            return 1;
+        }
+    }
+
+    std::vector<uint8_t> observations(static_cast<size_t>(snake_env_observation_size(env)));
+    std::vector<int32_t> actions(static_cast<size_t>(config.num_envs));
+    std::vector<float> rewards(actions.size());
+    std::vector<uint8_t> dones(actions.size());
+    snake_env_reset(env, seed, observations.data());
+
+    // Random agent that mostly keeps its heading, so episodes last a while
+    uint32_t state = static_cast<uint32_t>(seed) | 1u;
+    long long episodes = 0;
+    double totalReward = 0.0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (long long step = 0; step < steps; ++step) {
+        if (policy) {
+            snake_policy_act(policy, observations.data(), config.num_envs, actions.data());
+        } else {
+            for (int32_t& action : actions) {
+                state = state * 1664525u + 1013904223u;
+                action = (state >> 24) < 32 ? static_cast<int32_t>(state >> 30) : -1;
+            }
+        }
+        snake_env_step(env, actions.data(), rewards.data(), dones.data());
+        for (size_t i = 0; i < actions.size(); ++i) {
+            episodes += dones[i] != SNAKE_ENV_RUNNING;
+            totalReward += rewards[i];
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double envSteps = static_cast<double>(steps) * config.num_envs;
+    std::cout << "{\"envs\": " << config.num_envs << ", \"steps\": " << steps << ", \"episodes\": " << episodes
+              << ", \"reward\": " << totalReward << ", \"elapsed_sec\": " << seconds
+              << ", \"env_steps_per_sec\": " << static_cast<long long>(envSteps / seconds) << "}" << std::endl;
+
+    snake_policy_destroy(policy);
+    snake_env_destroy(env);
+    return 0;
+}
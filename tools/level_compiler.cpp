@@ -0,0 +1,27 @@
+#include "../src/level.h"
+#include <iostream>
+
+// Compiles a text level (levels/*.txt) into the memory-mappable .lvl form.
+// Usage: LevelCompiler <input.txt> <output.lvl>
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <input.txt> <output.lvl>" << std::endl;
+        return 1;
+    }
+
+    Level level;
+    if (!level.loadText(argv[1])) {
+        std::cerr << "Failed to load level: " << argv[1] << std::endl;
+        return 1;
+    }
+
+    if (!level.saveBinary(argv[2])) {
+        std::cerr << "Failed to write level: " << argv[2] << std::endl;
+        return 1;
+    }
+
+    std::cout << "Compiled '" << level.getName() << "' (" << level.getWidth() << "x" << level.getHeight()
+              << ", " << level.getWalls().count() << " walls, " << level.getPortals().size()
+              << " portals) -> " << argv[2] << std::endl;
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include "../src/console.h"
+#include "../src/recording.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+// Plays back a session recorded with `ConsoleSnakeCpp --record <file>`.
+// Usage: ReplayPlayer <file.snkr> [--speed X] [--start SECONDS]
+// Keys: SPACE pause, LEFT/RIGHT previous/next keyframe, UP/DOWN faster/slower, ESC quit
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <file.snkr> [--speed X] [--start SECONDS]" << std::endl;
+        return 1;
+    }
+
+    double speed = 1.0;
+    double position = 0.0; // Playback time in ms
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--speed") == 0) {
+            speed = std::atof(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--start") == 0) {
+            position = std::atof(argv[i + 1]) * 1000.0;
+        } else {
+            std::cerr << "Unknown option " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+    if (speed <= 0.0) {
+        std::cerr << "Speed must be positive" << std::endl;
+        return 1;
+    }
+
+    RecordingReader reader;
+    if (!reader.open(argv[1])) {
+        std::cerr << "Not a readable recording: " << argv[1] << std::endl;
+        return 1;
+    }
+
+    Console console;
+    if (!console.initialize()) {
+        std::cerr << "Failed to initialize console" << std::endl;
+        return 1;
+    }
+    console.clearScreen();
+
+    int width = reader.getWidth();
+    int height = reader.getHeight();
+    int consoleWidth = 0;
+    int consoleHeight = 0;
+    console.getConsoleSize(consoleWidth, consoleHeight);
+
+    std::vector<FrameCell> grid;
+    std::vector<FrameCell> shown(static_cast<size_t>(width) * height, FrameCell{ ' ', WHITE });
+    size_t current = reader.getFrameCount();
+    bool paused = false;
+    std::string lastStatus;
+
+    auto lastTime = std::chrono::steady_clock::now();
+    bool running = true;
+    while (running) {
+        // Input
+        while (console.isKeyPressed()) {
+            int key = console.getKeyPressed();
+            size_t frame = current < reader.getFrameCount() ? current : 0;
+            switch (key) {
+                case VK_ESCAPE:
+                    running = false;
+                    break;
+                case VK_SPACE:
+                    paused = !paused;
+                    break;
+                case VK_LEFT:
+                    frame = reader.previousKeyframe(frame > 0 ? frame - 1 : 0);
+                    position = reader.getFrameTime(frame);
+                    break;
+                case VK_RIGHT:
+                    frame = reader.nextKeyframe(frame);
+                    position = reader.getFrameTime(frame);
+                    break;
+                case VK_UP:
+                    speed = speed < 64.0 ? speed * 2.0 : speed;
+                    break;
+                case VK_DOWN:
+                    speed = speed > 0.125 ? speed / 2.0 : speed;
+                    break;
+            }
+        }
+
+        // Advance the playback clock
+        auto now = std::chrono::steady_clock::now();
+        if (!paused) {
+            position += std::chrono::duration<double, std::milli>(now - lastTime).count() * speed;
+            if (position > reader.getDuration()) {
+                position = reader.getDuration();
+            }
+        }
+        lastTime = now;
+
+        // Show the frame for the current time, drawing only cells that differ
+        size_t target = reader.findFrame(static_cast<uint32_t>(position));
+        if (target != current) {
+            if (!reader.seek(current, target, grid)) {
+                break;
+            }
+            current = target;
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    size_t index = static_cast<size_t>(y) * width + x;
+                    if (grid[index] != shown[index]) {
+                        console.drawChar(x, y, grid[index].ch, grid[index].color);
+                        shown[index] = grid[index];
+                    }
+                }
+            }
+        }
+
+        // Status below the recording when there is room, otherwise in the title
+        std::ostringstream status;
+        status << "Replay " << static_cast<int>(position / 1000.0) << "/" << reader.getDuration() / 1000
+               << "s  frame " << current + 1 << "/" << reader.getFrameCount() << "  x" << speed
+               << (paused ? "  PAUSED" : "") << (position >= reader.getDuration() ? "  END" : "");
+        if (status.str() != lastStatus) {
+            std::string text = status.str();
+            if (consoleHeight > height) {
+                text.resize(std::max(lastStatus.size(), text.size()), ' ');
+                console.drawString(0, height, text, BRIGHT_YELLOW);
+            } else {
+                console.setConsoleTitle(text);
+            }
+            lastStatus = status.str();
+        }
+
+        console.sleep(10);
+    }
+
+    console.cleanup();
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include "../src/console.h"
+#include "../src/renderer.h"
+#include "../src/spectator_feed.h"
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Watches a game started with `ConsoleSnakeCpp --spectator-feed <name>`.
+// Usage: SnakeSpectator <name> [--theme classic|unicode|256|truecolor|auto]
+// Reads frames from shared memory without the game knowing; several viewers
+// can watch at once. Waits for the game to start and follows the next one
+// when it exits. The feed carries no segment links, so the snake is drawn
+// with plain body and head glyphs. Keys: ESC quit
+namespace {
+    void drawCell(Console& console, const FrameSnapshot& glyphs, const Level& level, int x, int y, uint8_t cell) {
+        CellKind kind = static_cast<CellKind>(cell & SPECTATOR_KIND_MASK);
+        if (cell & SPECTATOR_WALL) {
+            console.drawGlyph(x, y, GLYPH_WALL, '#', WHITE);
+        } else if (kind == CELL_EMPTY && (cell & SPECTATOR_PORTAL)) {
+            console.drawGlyph(x, y, GLYPH_PORTAL, '%', BRIGHT_MAGENTA);
+        } else {
+            char ch = ' ';
+            int color = BLACK;
+            CellChange change = { x, y, kind, 0 };
+            Renderer::getCellGlyph(glyphs, level, change, ch, color);
+            console.drawGlyph(x, y, Renderer::getGlyph(level, change), ch, color);
+        }
+    }
+
+    void drawLine(Console& console, int x, int y, std::string text, int color) {
+        text.resize(30, ' ');
+        console.drawString(x, y, text, color);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string theme = "auto";
+    if (argc == 4 && std::string(argv[2]) == "--theme") {
+        theme = argv[3];
+    } else if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <feed name> [--theme classic|unicode|256|truecolor|auto]" << std::endl;
+        return 1;
+    }
+    std::string feedName = argv[1];
+
+    Console console;
+    if (!console.setTheme(theme)) {
+        std::cerr << "Unknown theme: " << theme << std::endl;
+        return 1;
+    }
+    if (!console.initialize()) {
+        std::cerr << "Failed to initialize console" << std::endl;
+        return 1;
+    }
+    console.clearScreen();
+
+    SpectatorView view;
+    SpectatorFrame frame;
+    FrameSnapshot glyphs; // Food symbol and colour for Renderer::getCellGlyph
+    Level level;          // Walls and portals come with the cells instead
+    std::vector<int> shown;
+    std::string lastStatus;
+    int width = 0;
+    int height = 0;
+    bool alive = true;
+    uint64_t shownNumber = UINT64_MAX;
+    uint64_t shownTick = UINT64_MAX;
+    auto lastFrameTime = std::chrono::steady_clock::now() - std::chrono::seconds(10);
+    auto lastAttempt = lastFrameTime;
+
+    bool running = true;
+    while (running) {
+        while (console.isKeyPressed()) {
+            if (console.getKeyPressed() == VK_ESCAPE) {
+                running = false;
+            }
+        }
+
+        // Find the game, and look again once it has exited or gone quiet (a
+        // crashed game leaves its segment behind until the next one replaces it)
+        auto now = std::chrono::steady_clock::now();
+        bool quiet = now - lastFrameTime > std::chrono::seconds(2) && now - lastAttempt > std::chrono::seconds(2);
+        if (view.isAttached() && (view.isClosed() || quiet)) {
+            view.detach();
+        }
+        if (!view.isAttached() && now - lastAttempt >= std::chrono::milliseconds(500)) {
+            lastAttempt = now;
+            if (view.attach(feedName)) {
+                if (view.getWidth() != width || view.getHeight() != height) {
+                    width = view.getWidth();
+                    height = view.getHeight();
+                    console.clearScreen();
+                    Renderer::drawBorder(console, width, height);
+                    shown.assign(static_cast<size_t>(width) * height, -1);
+                }
+            }
+        }
+
+        if (view.readLatest(frame)) {
+            // Attaching again re-reads the newest frame; only a different one means the game is live
+            if (frame.number != shownNumber || frame.values.tick != shownTick) {
+                lastFrameTime = now;
+            }
+            shownNumber = frame.number;
+            shownTick = frame.values.tick;
+            alive = frame.values.alive != 0;
+            glyphs.foodSymbol = static_cast<char>(frame.values.foodSymbol);
+            glyphs.foodColor = frame.values.foodColor;
+
+            // Only the cells that differ from the screen
+            for (int y = 1; y <= height; y++) {
+                for (int x = 1; x <= width; x++) {
+                    size_t index = static_cast<size_t>(y - 1) * width + (x - 1);
+                    if (frame.cells[index] != shown[index]) {
+                        drawCell(console, glyphs, level, x, y, frame.cells[index]);
+                        shown[index] = frame.cells[index];
+                    }
+                }
+            }
+
+            int column = width + 4;
+            drawLine(console, column, 2, "Score: " + std::to_string(frame.values.score), BRIGHT_YELLOW);
+            drawLine(console, column, 4, "Level: " + std::to_string(frame.values.level), BRIGHT_CYAN);
+            drawLine(console, column, 5, "High Score: " + std::to_string(frame.values.highScore), BRIGHT_MAGENTA);
+            drawLine(console, column, 6, "Speed: " + std::to_string(frame.values.tickRate) + " ticks/s" +
+                     (frame.values.turbo ? " TURBO" : ""), frame.values.turbo ? BRIGHT_YELLOW : CYAN);
+            drawLine(console, column, 7, frame.values.trapped ? "TRAPPED! Not enough room" : "", BRIGHT_RED);
+        }
+
+        std::string status = "Waiting for " + feedName + "...";
+        if (now - lastFrameTime <= std::chrono::seconds(2)) {
+            status = alive ? "Watching " + feedName : "Game over";
+        } else if (!alive && view.isAttached() && !view.isClosed()) {
+            status = "Game over";
+        }
+
+        if (status != lastStatus) {
+            drawLine(console, width + 4, 9, status, BRIGHT_BLACK);
+            lastStatus = status;
+        }
+        console.sleep(10);
+    }
+
+    console.cleanup();
+    return 0;
+}
@@ -0,0 +1,260 @@
+#include "../src/telemetry_log.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Summarizes a telemetry file written by the game or `--headless --telemetry`.
+// Usage: SnakeTelemetry <file.snkt> [--group-by difficulty|mode|cause|controller]
+//                       [--where COLUMN=VALUE]...
+// Example: SnakeTelemetry telemetry.snkt --group-by cause --where controller=astar
+// The file is memory-mapped and every statistic is a scan over the columns it
+// needs, so only those bytes are read. Percentiles are exact.
+namespace {
+    const int METRICS[] = { COLUMN_TICKS, COLUMN_LENGTH, COLUMN_SCORE, COLUMN_FOOD, COLUMN_INPUTS, COLUMN_TICK_NANOS };
+    const double FRACTIONS[] = { 0.5, 0.9, 0.99 };
+    const int FRACTION_COUNT = 3;
+    const int BUCKETS = 1 << 16;
+
+    // Rows must match every condition: an enum column equal to a value
+    struct Condition {
+        int column;
+        int value;
+    };
+
+    struct ColumnStats {
+        uint64_t count;
+        double sum;
+        uint32_t max;
+        uint32_t percentiles[FRACTION_COUNT];
+    };
+
+    bool isKeyColumn(int column) {
+        return column >= COLUMN_DIFFICULTY && column < COLUMN_COUNT;
+    }
+
+    int findColumn(const std::string& name) {
+        for (int column = 0; column < COLUMN_COUNT; column++) {
+            if (name == TelemetryLog::getColumnName(column)) {
+                return column;
+            }
+        }
+        return -1;
+    }
+
+    // "cause=self", "difficulty=2", "controller=astar"
+    bool parseCondition(const std::string& text, Condition& condition) {
+        size_t equals = text.find('=');
+        if (equals == std::string::npos) {
+            return false;
+        }
+        condition.column = findColumn(text.substr(0, equals));
+        if (!isKeyColumn(condition.column)) {
+            return false;
+        }
+        std::string value = text.substr(equals + 1);
+        for (int candidate = 0; candidate < 256; candidate++) {
+            if (value == TelemetryLog::getValueName(condition.column, candidate)) {
+                condition.value = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Marks the rows of a block that pass every condition with 1, the rest
+    // with 0. Each condition is one tight loop over a byte column, and the
+    // scans that use the mask add it in as a weight instead of branching.
+    void matchRows(const TelemetryFile& file, size_t block, const std::vector<Condition>& conditions,
+                   std::vector<uint8_t>& mask) {
+        size_t rows = file.getBlockRows(block);
+        mask.assign(rows, 1);
+        for (const Condition& condition : conditions) {
+            const uint8_t* keys = file.getColumn<uint8_t>(block, condition.column);
+            uint8_t value = static_cast<uint8_t>(condition.value);
+            for (size_t row = 0; row < rows; row++) {
+                mask[row] &= static_cast<uint8_t>(keys[row] == value);
+            }
+        }
+    }
+
+    // Calls visit(value, weight) for every row of one uint32 column, with
+    // weight 1 for rows that pass the conditions and 0 for the rest
+    template <class Visit>
+    void scan(const TelemetryFile& file, int column, const std::vector<Condition>& conditions, Visit visit) {
+        std::vector<uint8_t> mask;
+        for (size_t block = 0; block < file.getBlockCount(); block++) {
+            size_t rows = file.getBlockRows(block);
+            const uint32_t* values = file.getColumn<uint32_t>(block, column);
+            if (conditions.empty()) {
+                for (size_t row = 0; row < rows; row++) {
+                    visit(values[row], 1u);
+                }
+                continue;
+            }
+            matchRows(file, block, conditions, mask);
+            for (size_t row = 0; row < rows; row++) {
+                visit(values[row], static_cast<uint32_t>(mask[row]));
+            }
+        }
+    }
+
+    // Exact percentiles in two passes with no copy of the column: the first
+    // counts values by their high 16 bits, which tells the bucket each rank
+    // falls in; the second counts the low 16 bits of the values in just those
+    // buckets.
+    ColumnStats computeStats(const TelemetryFile& file, int column, const std::vector<Condition>& conditions) {
+        ColumnStats stats = { 0, 0.0, 0, { 0, 0, 0 } };
+        std::vector<uint64_t> high(BUCKETS, 0);
+        scan(file, column, conditions, [&](uint32_t value, uint32_t weight) {
+            uint32_t counted = value * weight;
+            high[value >> 16] += weight;
+            stats.sum += counted;
+            stats.max = counted > stats.max ? counted : stats.max;
+        });
+        for (uint64_t bucketCount : high) {
+            stats.count += bucketCount;
+        }
+        if (stats.count == 0) {
+            return stats;
+        }
+
+        int buckets[FRACTION_COUNT];
+        uint64_t ranks[FRACTION_COUNT]; // 1-based, within the bucket
+        for (int i = 0; i < FRACTION_COUNT; i++) {
+            uint64_t rank = static_cast<uint64_t>(std::ceil(FRACTIONS[i] * stats.count));
+            rank = rank < 1 ? 1 : rank;
+            int bucket = 0;
+            while (rank > high[bucket]) {
+                rank -= high[bucket];
+                bucket++;
+            }
+            buckets[i] = bucket;
+            ranks[i] = rank;
+        }
+
+        std::vector<std::vector<uint64_t>> low(FRACTION_COUNT, std::vector<uint64_t>(BUCKETS, 0));
+        scan(file, column, conditions, [&](uint32_t value, uint32_t weight) {
+            int bucket = static_cast<int>(value >> 16);
+            for (int i = 0; i < FRACTION_COUNT; i++) {
+                low[i][value & 0xFFFF] += weight & static_cast<uint32_t>(bucket == buckets[i]);
+            }
+        });
+        for (int i = 0; i < FRACTION_COUNT; i++) {
+            uint64_t rank = ranks[i];
+            int lowBits = 0;
+            while (rank > low[i][lowBits]) {
+                rank -= low[i][lowBits];
+                lowBits++;
+            }
+            stats.percentiles[i] = static_cast<uint32_t>(buckets[i]) << 16 | static_cast<uint32_t>(lowBits);
+        }
+        return stats;
+    }
+
+    void printGroups(const TelemetryFile& file, int keyColumn, const std::vector<Condition>& conditions) {
+        // Counts and means of every group in one pass over the blocks
+        uint64_t counts[256] = {};
+        double sums[256][COLUMN_COUNT] = {};
+        std::vector<uint8_t> mask;
+        for (size_t block = 0; block < file.getBlockCount(); block++) {
+            size_t rows = file.getBlockRows(block);
+            const uint8_t* groups = file.getColumn<uint8_t>(block, keyColumn);
+            matchRows(file, block, conditions, mask);
+            for (size_t row = 0; row < rows; row++) {
+                counts[groups[row]] += mask[row];
+            }
+            for (int metric : METRICS) {
+                const uint32_t* values = file.getColumn<uint32_t>(block, metric);
+                for (size_t row = 0; row < rows; row++) {
+                    sums[groups[row]][metric] += values[row] * static_cast<uint32_t>(mask[row]);
+                }
+            }
+        }
+        uint64_t total = 0;
+        for (uint64_t count : counts) {
+            total += count;
+        }
+
+        std::printf("\nBy %s:\n", TelemetryLog::getColumnName(keyColumn));
+        std::printf("%-12s %12s %7s %10s %10s %10s %10s %10s %10s\n", "value", "games", "share", "ticks",
+                    "length", "score", "p50 score", "p99 score", "tick_ns");
+        for (int group = 0; group < 256; group++) {
+            if (counts[group] == 0) {
+                continue;
+            }
+            double count = static_cast<double>(counts[group]);
+            std::vector<Condition> groupConditions = conditions;
+            groupConditions.push_back(Condition{ keyColumn, group });
+            ColumnStats score = computeStats(file, COLUMN_SCORE, groupConditions);
+            std::printf("%-12s %12llu %6.1f%% %10.1f %10.1f %10.1f %10u %10u %10.0f\n",
+                        TelemetryLog::getValueName(keyColumn, group).c_str(),
+                        static_cast<unsigned long long>(counts[group]), 100.0 * count / total,
+                        sums[group][COLUMN_TICKS] / count, sums[group][COLUMN_LENGTH] / count,
+                        sums[group][COLUMN_SCORE] / count, score.percentiles[0], score.percentiles[2],
+                        sums[group][COLUMN_TICK_NANOS] / count);
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <file.snkt> [--group-by difficulty|mode|cause|controller]"
+                  << " [--where COLUMN=VALUE]..." << std::endl;
+        return 1;
+    }
+
+    int groupBy = -1;
+    std::vector<Condition> conditions;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return 2;
+        }
+        std::string value = argv[++i];
+        if (arg == "--group-by") {
+            groupBy = findColumn(value);
+            if (!isKeyColumn(groupBy)) {
+                std::cerr << "Cannot group by " << value << std::endl;
+                return 2;
+            }
+        } else if (arg == "--where") {
+            Condition condition;
+            if (!parseCondition(value, condition)) {
+                std::cerr << "Bad condition " << value << " (e.g. cause=self, controller=astar)" << std::endl;
+                return 2;
+            }
+            conditions.push_back(condition);
+        } else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 2;
+        }
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+    TelemetryFile file;
+    if (!file.open(argv[1])) {
+        return 1;
+    }
+    std::printf("%llu games in %zu blocks%s\n", static_cast<unsigned long long>(file.getRowCount()),
+                file.getBlockCount(), file.isTruncated() ? " (damaged tail ignored)" : "");
+
+    std::printf("%-10s %12s %12s %10s %10s %10s %10s\n", "column", "games", "mean", "p50", "p90", "p99", "max");
+    for (int metric : METRICS) {
+        ColumnStats stats = computeStats(file, metric, conditions);
+        std::printf("%-10s %12llu %12.1f %10u %10u %10u %10u\n", TelemetryLog::getColumnName(metric),
+                    static_cast<unsigned long long>(stats.count), stats.count > 0 ? stats.sum / stats.count : 0.0,
+                    stats.percentiles[0], stats.percentiles[1], stats.percentiles[2], stats.max);
+    }
+    if (groupBy >= 0) {
+        printGroups(file, groupBy, conditions);
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    std::printf("\nScanned in %.2f s\n", seconds);
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include "../src/simulation.h"
+#include "../src/tournament.h"
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Round-robin tournament between agent programs (protocol in src/tournament.h).
+// Usage: SnakeTournament [options] "<agent command>" "<agent command>" ...
+// Options: --matches N (boards per pair) --max-ticks N --timeout MS (per move)
+//          --workers N --seed S --board WxH --mode classic|wrap|marathon --level FILE
+// Example: SnakeTournament "ConsoleSnakeCpp --agent greedy" "ConsoleSnakeCpp --agent astar"
+int main(int argc, char* argv[]) {
+    TournamentSettings settings;
+    std::vector<std::string> commands;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "--") != 0) {
+            commands.push_back(arg);
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return 2;
+        }
+        std::string value = argv[++i];
+        if (arg == "--matches") {
+            settings.matchesPerPair = std::atoi(value.c_str());
+        } else if (arg == "--max-ticks") {
+            settings.maxTicks = std::atoi(value.c_str());
+        } else if (arg == "--timeout") {
+            settings.moveTimeoutMs = std::atoi(value.c_str());
+        } else if (arg == "--workers") {
+            settings.workers = std::atoi(value.c_str());
+        } else if (arg == "--seed") {
+            settings.seed = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--board") {
+            if (std::sscanf(value.c_str(), "%dx%d", &settings.width, &settings.height) != 2) {
+                std::cerr << "Board must be WIDTHxHEIGHT" << std::endl;
+                return 2;
+            }
+        } else if (arg == "--mode") {
+            if (!Simulation::findMode(value, settings.mode)) {
+                std::cerr << "Unknown mode " << value << std::endl;
+                return 2;
+            }
+        } else if (arg == "--level") {
+            settings.level = value;
+        } else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 2;
+        }
+    }
+    if (commands.size() < 2 || settings.matchesPerPair <= 0 || settings.maxTicks <= 0 || settings.moveTimeoutMs <= 0 ||
+        settings.width < 4 || settings.height < 4) {
+        std::cerr << "Usage: " << argv[0] << " [--matches N] [--max-ticks N] [--timeout MS] [--workers N] [--seed S]"
+                  << " [--board WxH] [--mode classic|wrap|marathon] [--level FILE] \"<agent command>\" ..." << std::endl;
+        std::cerr << "At least two agents are needed" << std::endl;
+        return 2;
+    }
+
+    Tournament tournament(settings);
+    for (const std::string& command : commands) {
+        tournament.addAgent(command);
+    }
+    bool ok = tournament.run();
+    tournament.print(std::cout);
+    return ok ? 0 : 1;
+}